@@ -0,0 +1,455 @@
+/**
+ * @file bench/usart_bench.c
+ * @brief USART driver benchmark suite
+ *
+ * Replaces main.c to measure the on-board debugger port's driver: transmit
+ * throughput against the line rate, transmit completion latency, receive
+ * throughput and losses under a continuous stream, and keystroke-to-echo
+ * service time. All timing is via SysTick (@c platform_tick_now()).
+ *
+ * Building:
+ * -- On target, exclude main.c from the MPLAB X project and add this file
+ *    instead; the platform sources are used as-is.
+ * -- On the host, @code make -C host bench @endcode builds the same code
+ *    against the simulator, with host/bench_host.c as the remote end.
+ *
+ * Report:
+ * Results go out on the port under test, one line per test, between a
+ * "@bench begin" and a "@bench end" line:
+ *
+ *     @bench test=<name> key=value key=value ...
+ *
+ * Values are unsigned integers (times in microseconds, rates in bytes per
+ * second), so reports can be diffed or parsed run over run. The receive
+ * tests need a remote end: each is announced by a line such as
+ *
+ *     @bench ready=rx_bulk bytes=4096
+ *     @bench ready=echo count=64
+ *
+ * after which the remote sends that many bytes back-to-back (rx_bulk), or
+ * sends one character at a time and waits for its echo before the next
+ * (echo). A test that hears nothing for BENCH_WAIT_US is reported with
+ * "skipped=1". Lines not starting with '@' are payload, and may be ignored.
+ */
+
+#include <xc.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "../platform/blink_settings.h"
+#include "../platform.h"
+
+// Owned by the application; the LED stays off while benchmarking.
+BlinkSetting currentSetting = OFF;
+
+/////////////////////////////////////////////////////////////////////////////
+
+// Bytes sent by the bulk transmit test
+#if !defined(BENCH_TX_BYTES)
+#define BENCH_TX_BYTES	8192
+#endif
+
+// Messages sent (and timed) by the transmit latency test
+#if !defined(BENCH_TX_MSGS)
+#define BENCH_TX_MSGS	64
+#endif
+
+// Bytes requested from the remote by the bulk receive test
+#if !defined(BENCH_RX_BYTES)
+#define BENCH_RX_BYTES	4096
+#endif
+
+// Keystrokes requested from the remote by the echo test
+#if !defined(BENCH_ECHO_COUNT)
+#define BENCH_ECHO_COUNT	64
+#endif
+
+// How long a receive test waits for the remote to start, in microseconds
+#if !defined(BENCH_WAIT_US)
+#define BENCH_WAIT_US	10000000UL
+#endif
+
+// Silence after which a started receive test is considered over
+#if !defined(BENCH_IDLE_US)
+#define BENCH_IDLE_US	500000UL
+#endif
+
+/////////////////////////////////////////////////////////////////////////////
+
+/*
+ * Bulk payload: one 64-character line, repeated via the fragment arrays.
+ * Every array refers to the same (constant) fragments, so it can be
+ * queued again while earlier copies are still in flight.
+ */
+#define BENCH_LINE_LEN		64
+#define BENCH_FRAGS_PER_ARRAY	16
+static const char bench_line[BENCH_LINE_LEN + 1] =
+        "0123456789abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ\r\n";
+static platform_usart_tx_bufdesc_t bench_bulk_desc[BENCH_FRAGS_PER_ARRAY];
+
+#define BENCH_ARRAY_BYTES	(BENCH_LINE_LEN * BENCH_FRAGS_PER_ARRAY)
+#if (BENCH_TX_BYTES % BENCH_ARRAY_BYTES) != 0
+#error "BENCH_TX_BYTES must be a multiple of 1024"
+#endif
+
+// Report line being sent
+static char bench_msg[256];
+
+// Line settings, for the line-rate reference
+static uint32_t bench_baud;
+static unsigned int bench_frame_bits;
+
+/////////////////////////////////////////////////////////////////////////////
+
+// Timing helpers
+
+// Microseconds from t0 to t1; t1 must not be earlier than t0
+static uint32_t bench_us(platform_tick_t t0, platform_tick_t t1) {
+    return (uint32_t) PLATFORM_TICK_TO_US(t1 - t0);
+}
+
+static uint32_t bench_us_since(platform_tick_t t0) {
+    return bench_us(t0, platform_tick_now());
+}
+
+// Rate in units per second, without overflowing for long runs
+static uint32_t bench_rate(uint32_t n, uint32_t us) {
+    if (us == 0)
+        return 0;
+    return (uint32_t) (((uint64_t) n * 1000000UL) / us);
+}
+
+// Running minimum/maximum/sum of a series of samples
+typedef struct bench_series_type {
+    uint32_t n;
+    uint32_t min;
+    uint32_t max;
+    uint64_t sum;
+} bench_series_t;
+
+static void bench_series_init(bench_series_t *s) {
+    s->n = 0;
+    s->min = UINT32_MAX;
+    s->max = 0;
+    s->sum = 0;
+}
+
+static void bench_series_add(bench_series_t *s, uint32_t v) {
+    ++s->n;
+    s->sum += v;
+    if (v < s->min)
+        s->min = v;
+    if (v > s->max)
+        s->max = v;
+}
+
+static uint32_t bench_series_mean(const bench_series_t *s) {
+    return (s->n != 0) ? (uint32_t) (s->sum / s->n) : 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+/*
+ * Send a report line, and wait until it has left
+ *
+ * Reporting goes through the port under test, so it is kept out of every
+ * measured interval.
+ */
+static void bench_printf(const char *fmt, ...) {
+    static platform_usart_tx_bufdesc_t desc[1];
+    va_list ap;
+    int n;
+
+    va_start(ap, fmt);
+    n = vsnprintf(bench_msg, sizeof (bench_msg) - 2, fmt, ap);
+    va_end(ap);
+    if (n < 0)
+        return;
+    if (n > (int) sizeof (bench_msg) - 3)
+        n = sizeof (bench_msg) - 3;
+    bench_msg[n++] = '\r';
+    bench_msg[n++] = '\n';
+
+    desc[0].buf = bench_msg;
+    desc[0].len = (uint16_t) n;
+    while (!platform_usart_cdc_tx_async(desc, 1))
+        platform_do_loop_one();
+    while (platform_usart_cdc_tx_busy())
+        platform_do_loop_one();
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+// Driver configuration, so that reports from different builds are told apart
+static void bench_config(void) {
+    const platform_usart_config_t cfg = PLATFORM_USART_CONFIG_DEFAULT;
+
+    bench_baud = platform_usart_get_baud(PLATFORM_USART_CDC);
+    bench_frame_bits = 1 + cfg.data_bits + cfg.stop_bits +
+            ((cfg.parity != PLATFORM_USART_PARITY_NONE) ? 1 : 0);
+
+    bench_printf("@bench test=config baud=%lu frame_bits=%u char_us=%lu "
+            "irq=%u fifo=%u tx_backend=%u rx_backend=%u "
+            "rx_ring=%u tx_ring=%u tx_queue=%u tick_us=%u",
+            (unsigned long) bench_baud, bench_frame_bits,
+            (unsigned long) ((bench_frame_bits * 1000000UL) / bench_baud),
+            PLATFORM_USART_USE_IRQ, PLATFORM_USART_USE_FIFO,
+            PLATFORM_USART_TX_BACKEND, PLATFORM_USART_RX_BACKEND,
+            PLATFORM_USART_RX_RING_SIZE, PLATFORM_USART_TX_RING_SIZE,
+            PLATFORM_USART_TX_QUEUE_LEN, PLATFORM_TICK_PERIOD_US);
+}
+
+/*
+ * Bulk transmission: keep the queue full of fragment arrays until
+ * BENCH_TX_BYTES have gone out, then compare against the line rate.
+ */
+static void bench_tx_bulk(void) {
+    platform_tick_t t0;
+    platform_usart_stats_t st;
+    uint32_t submitted = 0, loops = 0, us, bps, line_bps;
+    uint16_t seq = 0;
+
+    platform_usart_cdc_stats_clear();
+    t0 = platform_tick_now();
+    for (;;) {
+        if (submitted < BENCH_TX_BYTES) {
+            uint16_t s = platform_usart_cdc_tx_submit(bench_bulk_desc,
+                    BENCH_FRAGS_PER_ARRAY, NULL, NULL);
+            if (s != 0) {
+                seq = s;
+                submitted += BENCH_ARRAY_BYTES;
+            }
+        } else if ((int16_t) (platform_usart_cdc_tx_seq_done() - seq) >= 0) {
+            break;
+        }
+        platform_do_loop_one();
+        ++loops;
+    }
+    us = bench_us_since(t0);
+    platform_usart_cdc_stats(&st);
+
+    // Let the last characters clear the shift register before reporting.
+    while (platform_usart_cdc_tx_busy())
+        platform_do_loop_one();
+
+    bps = bench_rate(BENCH_TX_BYTES, us);
+    line_bps = bench_baud / bench_frame_bits;
+    bench_printf("@bench test=tx_bulk bytes=%lu us=%lu Bps=%lu "
+            "line_Bps=%lu eff_pct=%lu loops=%lu loops_per_kib=%lu "
+            "irq=%lu hwm_queue=%u",
+            (unsigned long) BENCH_TX_BYTES, (unsigned long) us,
+            (unsigned long) bps, (unsigned long) line_bps,
+            (unsigned long) ((line_bps != 0) ? (100UL * bps) / line_bps : 0),
+            (unsigned long) loops,
+            (unsigned long) (((uint64_t) loops * 1024) / BENCH_TX_BYTES),
+            (unsigned long) (st.nr_irq_dre + st.nr_irq_txc),
+            st.hwm_tx_queue);
+}
+
+/*
+ * Transmission latency: one short message at a time, from submission to
+ * completion as reported by the driver. The ideal is the time the
+ * characters take on the wire.
+ */
+static void bench_tx_latency(void) {
+    static const char msg[] = ".";
+    static const platform_usart_tx_bufdesc_t desc[] = {
+        {msg, sizeof (msg) - 1}
+    };
+    bench_series_t lat;
+    platform_tick_t t0;
+    uint32_t x, loops = 0;
+    uint16_t seq;
+
+    bench_series_init(&lat);
+    for (x = 0; x < BENCH_TX_MSGS; ++x) {
+        t0 = platform_tick_now();
+        while ((seq = platform_usart_cdc_tx_submit(desc, 1, NULL, NULL)) == 0)
+            platform_do_loop_one();
+        while ((int16_t) (platform_usart_cdc_tx_seq_done() - seq) < 0) {
+            platform_do_loop_one();
+            ++loops;
+        }
+        bench_series_add(&lat, bench_us_since(t0));
+    }
+    while (platform_usart_cdc_tx_busy())
+        platform_do_loop_one();
+
+    bench_printf("\r\n@bench test=tx_latency msgs=%lu bytes=%u "
+            "min_us=%lu mean_us=%lu max_us=%lu loops_per_msg=%lu",
+            (unsigned long) lat.n, (unsigned int) (sizeof (msg) - 1),
+            (unsigned long) lat.min, (unsigned long) bench_series_mean(&lat),
+            (unsigned long) lat.max,
+            (unsigned long) (loops / BENCH_TX_MSGS));
+}
+
+/*
+ * Bulk reception: the remote sends BENCH_RX_BYTES back-to-back, which are
+ * collected through reception descriptors. Lost bytes are those that never
+ * showed up in a descriptor; the driver statistics tell where they went.
+ */
+static void bench_rx_bulk(void) {
+    static char buf[64];
+    static platform_usart_rx_async_desc_t desc;
+    platform_tick_t t_ready, t_first, t_last;
+    platform_usart_stats_t st;
+    uint32_t received = 0, first_len = 0, loops = 0, errors = 0;
+    uint32_t us, lost;
+    bool started = false;
+
+    desc.buf = buf;
+    desc.max_len = sizeof (buf);
+    desc.compl_type = PLATFORM_USART_RX_COMPL_NONE;
+
+    platform_usart_cdc_stats_clear();
+    platform_usart_cdc_rx_async(&desc);
+    bench_printf("@bench ready=rx_bulk bytes=%lu",
+            (unsigned long) BENCH_RX_BYTES);
+    t_ready = platform_tick_now();
+    t_first = t_ready;
+    t_last = t_ready;
+
+    while (received < BENCH_RX_BYTES) {
+        platform_do_loop_one();
+        if (started)
+            ++loops;
+
+        if (desc.compl_type != PLATFORM_USART_RX_COMPL_NONE) {
+            uint32_t n = desc.compl_info.data_len;
+
+            if (desc.compl_type != PLATFORM_USART_RX_COMPL_DATA)
+                ++errors;
+            t_last = platform_tick_now();
+            if (!started) {
+                // Timing starts with the first completion.
+                started = true;
+                t_first = t_last;
+                first_len = n;
+            }
+            received += n;
+            desc.compl_type = PLATFORM_USART_RX_COMPL_NONE;
+            platform_usart_cdc_rx_async(&desc);
+        } else if (bench_us_since(started ? t_last : t_ready) >=
+                (started ? BENCH_IDLE_US : BENCH_WAIT_US)) {
+            break;
+        }
+    }
+    platform_usart_cdc_rx_abort();
+    platform_usart_cdc_stats(&st);
+
+    if (!started) {
+        bench_printf("@bench test=rx_bulk skipped=1");
+        return;
+    }
+    us = bench_us(t_first, t_last);
+    lost = (received < BENCH_RX_BYTES) ? (BENCH_RX_BYTES - received) : 0;
+    bench_printf("@bench test=rx_bulk bytes=%lu received=%lu lost=%lu "
+            "us=%lu Bps=%lu line_Bps=%lu loops_per_kib=%lu "
+            "compl_full=%lu compl_idle=%lu compl_err=%lu "
+            "overrun=%lu dropped=%lu err_frame=%lu err_parity=%lu "
+            "hwm_ring=%u",
+            (unsigned long) BENCH_RX_BYTES, (unsigned long) received,
+            (unsigned long) lost, (unsigned long) us,
+            (unsigned long) bench_rate(received - first_len, us),
+            (unsigned long) (bench_baud / bench_frame_bits),
+            (unsigned long) ((received != 0) ?
+                ((uint64_t) loops * 1024) / received : 0),
+            (unsigned long) st.nr_compl_full, (unsigned long) st.nr_compl_idle,
+            (unsigned long) errors, (unsigned long) st.nr_err_overflow,
+            (unsigned long) st.nr_rx_dropped, (unsigned long) st.nr_err_frame,
+            (unsigned long) st.nr_err_parity, st.hwm_rx_ring);
+}
+
+/*
+ * Echo: each keystroke from the remote is sent straight back. Measured
+ * here is the firmware's share, from noticing the completed reception to
+ * the echo leaving the driver; the remote sees the full round trip.
+ */
+static void bench_echo(void) {
+    static char buf[1];
+    static platform_usart_rx_async_desc_t desc;
+    static platform_usart_tx_bufdesc_t echo_desc[1];
+    bench_series_t svc;
+    platform_tick_t t_ready, t0;
+    uint16_t seq;
+
+    desc.buf = buf;
+    desc.max_len = sizeof (buf);
+    desc.compl_type = PLATFORM_USART_RX_COMPL_NONE;
+    echo_desc[0].buf = buf;
+    echo_desc[0].len = 1;
+
+    bench_series_init(&svc);
+    platform_usart_cdc_rx_async(&desc);
+    bench_printf("@bench ready=echo count=%lu",
+            (unsigned long) BENCH_ECHO_COUNT);
+    t_ready = platform_tick_now();
+
+    while (svc.n < BENCH_ECHO_COUNT) {
+        // Between keystrokes, sleep like main() does.
+        platform_wait_for_event();
+        platform_do_loop_one();
+        if (desc.compl_type == PLATFORM_USART_RX_COMPL_NONE) {
+            if (bench_us_since(t_ready) >=
+                    ((svc.n == 0) ? BENCH_WAIT_US : BENCH_IDLE_US))
+                break;
+            continue;
+        }
+
+        t0 = platform_tick_now();
+        if (desc.compl_type == PLATFORM_USART_RX_COMPL_DATA) {
+            while ((seq = platform_usart_cdc_tx_submit(echo_desc, 1,
+                    NULL, NULL)) == 0)
+                platform_do_loop_one();
+            while ((int16_t) (platform_usart_cdc_tx_seq_done() - seq) < 0)
+                platform_do_loop_one();
+        }
+        bench_series_add(&svc, bench_us_since(t0));
+
+        desc.compl_type = PLATFORM_USART_RX_COMPL_NONE;
+        platform_usart_cdc_rx_async(&desc);
+        t_ready = platform_tick_now();
+    }
+    platform_usart_cdc_rx_abort();
+    while (platform_usart_cdc_tx_busy())
+        platform_do_loop_one();
+
+    if (svc.n == 0) {
+        bench_printf("\r\n@bench test=echo skipped=1");
+        return;
+    }
+    bench_printf("\r\n@bench test=echo count=%lu missed=%lu "
+            "svc_min_us=%lu svc_mean_us=%lu svc_max_us=%lu",
+            (unsigned long) svc.n, (unsigned long) (BENCH_ECHO_COUNT - svc.n),
+            (unsigned long) svc.min, (unsigned long) bench_series_mean(&svc),
+            (unsigned long) svc.max);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+int main(void) {
+    unsigned int x;
+
+    for (x = 0; x < BENCH_FRAGS_PER_ARRAY; ++x) {
+        bench_bulk_desc[x].buf = bench_line;
+        bench_bulk_desc[x].len = BENCH_LINE_LEN;
+    }
+    platform_init();
+
+    bench_printf("\r\n@bench begin");
+    bench_config();
+    bench_tx_bulk();
+    bench_tx_latency();
+    bench_rx_bulk();
+    bench_echo();
+    bench_printf("@bench end");
+
+    for (;;)
+        platform_do_loop_one();
+
+    // This line must never be reached
+    return 1;
+}
@@ -0,0 +1,197 @@
+/**
+ * @file  host/autobaud_test.c
+ * @brief Host tests for auto-baud rate capture
+ *
+ * Runs in place of main.c. The console port is set up for auto-baud at
+ * 57600 bit/s, and the remote end (simulator alarms, below) then sends a
+ * break, a sync field and two characters at each of a few other rates.
+ * After each round, the rate reported by platform_usart_get_baud() must
+ * be the sender's, and the IDLE timeout that ends the reception must be
+ * the one for that rate. A round with a bad sync field must leave both
+ * alone, and report its break once.
+ *
+ * Each failure is printed; the exit status is non-zero if there was any.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "sim.h"
+#include "../platform/blink_settings.h"
+#include "../platform.h"
+
+// gpio.c reads the blink setting from the application.
+BlinkSetting currentSetting = OFF;
+
+#define TEST_SERCOM		3	// The on-board debugger's CDC port
+#define TEST_FRAME_BITS		10	// 8N1
+#define TEST_DEADLINE		(2 * SIM_TIME_S)
+#define TEST_FF_MAX		SIM_TIME_MS	// Longest fast-forward
+
+typedef struct {
+    sim_time_t at;
+    uint32_t baud;		// Sender's rate
+    uint8_t sync;
+    const char *data;
+    uint32_t want_baud;		// Rate the firmware should settle on
+} test_round_t;
+
+static const test_round_t test_rounds[] = {
+    {20 * SIM_TIME_MS, 1200, 0x55, "ab", 1200},
+    {300 * SIM_TIME_MS, 2400, 0x55, "cd", 2400},
+    // Bad sync field: the rate stays where it was.
+    {500 * SIM_TIME_MS, 4800, 0x54, "ef", 2400},
+};
+#define NR_TEST_ROUNDS	(sizeof (test_rounds) / sizeof (test_rounds[0]))
+
+// When the last character of each round ends on the line
+static volatile sim_time_t test_round_end[NR_TEST_ROUNDS];
+
+static unsigned long nr_checks, nr_failures;
+
+static void check(bool ok, unsigned int round, const char *what,
+        unsigned long got, unsigned long want) {
+    ++nr_checks;
+    if (!ok && ++nr_failures <= 20)
+        printf("FAIL round %u: %s: got %lu, want %lu\n", round, what, got,
+                want);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+// Remote end; runs from simulator callbacks
+
+static void test_send_round(void *arg) {
+    unsigned int n = (unsigned int) (uintptr_t) arg;
+    const test_round_t *r = &test_rounds[n];
+    sim_time_t now = sim_time();
+    sim_time_t ct = (sim_time_t) ((double) TEST_FRAME_BITS * SIM_TIME_S /
+            r->baud);
+    size_t len = strlen(r->data);
+
+    // A break takes two character times; the line is idle by now.
+    sim_uart_set_rx_baud(TEST_SERCOM, r->baud);
+    sim_uart_rx_char(TEST_SERCOM, 0x00, SIM_UART_RX_BREAK, now);
+    sim_uart_rx_char(TEST_SERCOM, r->sync, 0, now);
+    sim_uart_rx(TEST_SERCOM, r->data, len, now);
+    test_round_end[n] = now + (3 + len) * ct;
+
+    if (n + 1 < NR_TEST_ROUNDS)
+        sim_set_alarm(test_rounds[n + 1].at, test_send_round,
+                (void *) (uintptr_t) (n + 1));
+}
+
+int sim_app_init(int argc, char **argv) {
+    if (argc != 0)
+        return 1;
+    // The IDLE timeout is completed from the main loop; keep it on time.
+    sim_set_fast_forward(TEST_FF_MAX);
+    sim_set_alarm(test_rounds[0].at, test_send_round, (void *) 0);
+    return 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+// Firmware side
+
+static bool test_receive(platform_usart_rx_async_desc_t *desc, char *buf,
+        uint16_t len) {
+    memset(desc, 0, sizeof (*desc));
+    desc->buf = buf;
+    desc->max_len = len;
+    if (!platform_usart_cdc_rx_async(desc))
+        return false;
+    while (desc->compl_type == PLATFORM_USART_RX_COMPL_NONE) {
+        if (sim_time() > TEST_DEADLINE)
+            return false;
+        platform_do_loop_one();
+    }
+    return true;
+}
+
+// IDLE timeout for a rate, as usart_line_calc() works it out for 8N1
+static sim_time_t test_idle_timeout(uint32_t baud) {
+    platform_tick_t t = ((platform_tick_t) 3 * (TEST_FRAME_BITS + 1) *
+            PLATFORM_TICK_HZ + baud - 1) / baud;
+
+    return (sim_time_t) t * SIM_TIME_S / PLATFORM_TICK_HZ;
+}
+
+static void test_round(unsigned int n) {
+    const test_round_t *r = &test_rounds[n];
+    platform_usart_rx_async_desc_t desc;
+    char buf[16];
+    sim_time_t gap, idle, slack;
+    uint32_t baud;
+
+    // The break, on its own
+    if (!test_receive(&desc, buf, sizeof (buf))) {
+        check(false, n, "break received", 0, 1);
+        return;
+    }
+    check(desc.compl_type == PLATFORM_USART_RX_COMPL_BREAK, n,
+            "break compl_type", desc.compl_type,
+            PLATFORM_USART_RX_COMPL_BREAK);
+
+    // Then the data, ended by the IDLE timeout
+    if (!test_receive(&desc, buf, sizeof (buf))) {
+        check(false, n, "data received", 0, 1);
+        return;
+    }
+    gap = sim_time() - test_round_end[n];
+    check(desc.compl_type == PLATFORM_USART_RX_COMPL_DATA, n,
+            "data compl_type", desc.compl_type, PLATFORM_USART_RX_COMPL_DATA);
+    check(desc.compl_info.data_len == strlen(r->data) &&
+            memcmp(buf, r->data, strlen(r->data)) == 0, n, "data",
+            desc.compl_info.data_len, strlen(r->data));
+
+    // Within the (16x fractional) BAUD resolution of the sender's rate
+    baud = platform_usart_get_baud(PLATFORM_USART_CDC);
+    check(baud >= r->want_baud - r->want_baud / 200 &&
+            baud <= r->want_baud + r->want_baud / 200, n, "baud", baud,
+            r->want_baud);
+
+    /*
+     * The IDLE timeout starts at the first tick to see the last character,
+     * and is checked on ticks; allow for two tick periods on top. The tick
+     * runs from the main loop, stamped with when SysTick fired, so it may
+     * start up to a main-loop wakeup early.
+     */
+    idle = test_idle_timeout(r->want_baud);
+    slack = 2 * PLATFORM_TICK_PERIOD_US * SIM_TIME_US;
+    check(gap + TEST_FF_MAX >= idle && gap <= idle + slack, n,
+            "idle gap (us)",
+            (unsigned long) (gap / SIM_TIME_US),
+            (unsigned long) (idle / SIM_TIME_US));
+    return;
+}
+
+int main(void) {
+    const platform_usart_config_t cfg = {
+        57600, 8, PLATFORM_USART_PARITY_NONE, 1, 16, 1
+    };
+    platform_usart_stats_t st;
+    unsigned int n;
+
+    platform_init();
+    if (!platform_usart_configure(PLATFORM_USART_CDC, &cfg, NULL)) {
+        printf("FAIL auto-baud configuration rejected\n");
+        return 1;
+    }
+    platform_usart_cdc_stats_clear();
+
+    for (n = 0; n < NR_TEST_ROUNDS; ++n)
+        test_round(n);
+
+    platform_usart_cdc_stats(&st);
+    check(st.nr_breaks == NR_TEST_ROUNDS, n, "nr_breaks", st.nr_breaks,
+            NR_TEST_ROUNDS);
+    check(st.nr_autobaud_sync == NR_TEST_ROUNDS - 1, n, "nr_autobaud_sync",
+            st.nr_autobaud_sync, NR_TEST_ROUNDS - 1);
+    check(st.nr_bad_sync == 1, n, "nr_bad_sync", st.nr_bad_sync, 1);
+
+    printf("autobaud: %lu checks, %lu failures\n", nr_checks, nr_failures);
+    return (nr_failures == 0) ? 0 : 1;
+}
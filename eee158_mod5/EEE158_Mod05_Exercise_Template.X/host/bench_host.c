@@ -0,0 +1,153 @@
+/**
+ * @file  host/bench_host.c
+ * @brief Remote end of the USART benchmark suite (bench/usart_bench.c)
+ *
+ * Linked in place of the console front-end's defaults, this watches the
+ * console SERCOM's output for the benchmark's "@bench" lines: it passes
+ * them through to stdout (payload is dropped), feeds the receive tests
+ * when they announce themselves, and times the echo test on the wire, from
+ * the start bit of each keystroke to the stop bit of its echo. After the
+ * firmware's "@bench end", it adds its own lines and ends the run.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sim.h"
+
+#define BENCH_SERCOM		3	// The on-board debugger's CDC port
+#define BENCH_LINE_MAX		256
+
+// Delay between an announcement and the remote's first character
+#define BENCH_START_DELAY	(1 * SIM_TIME_MS)
+
+static char bench_line[BENCH_LINE_MAX];
+static size_t bench_line_len;
+
+// Line settings, from the firmware's "test=config" line
+static unsigned long bench_baud, bench_frame_bits;
+
+// Echo test state
+static unsigned long echo_left, echo_count;
+static uint8_t echo_char;
+static sim_time_t echo_sent, echo_min, echo_max, echo_sum;
+static uint32_t echo_rand = 12345;
+
+// Get "key=<unsigned>" out of a report line; zero if absent
+static unsigned long bench_value(const char *line, const char *key) {
+    size_t klen = strlen(key);
+    const char *p = line;
+
+    while ((p = strstr(p, key)) != NULL) {
+        if ((p == line || p[-1] == ' ') && p[klen] == '=')
+            return strtoul(p + klen + 1, NULL, 10);
+        p += klen;
+    }
+    return 0;
+}
+
+// Send the next keystroke, a few (pseudo-random) milliseconds from now
+static void bench_echo_next(sim_time_t now) {
+    sim_time_t gap;
+
+    echo_rand = echo_rand * 1103515245u + 12345u;
+    gap = SIM_TIME_MS + (echo_rand >> 8) % (4 * SIM_TIME_MS);
+    echo_char = (uint8_t) ('a' + echo_count % 26);
+    echo_sent = now + gap;
+    sim_uart_rx_char(BENCH_SERCOM, echo_char, 0, echo_sent);
+}
+
+static void bench_report(void) {
+    sim_stats_t st;
+    sim_time_t wire = 0;
+
+    if (bench_baud != 0)
+        wire = (2 * bench_frame_bits * SIM_TIME_S) / bench_baud;
+    if (echo_count != 0)
+        printf("@bench test=echo_wire count=%lu rtt_min_us=%llu "
+                "rtt_mean_us=%llu rtt_max_us=%llu wire_us=%llu\n",
+                echo_count,
+                (unsigned long long) (echo_min / SIM_TIME_US),
+                (unsigned long long) (echo_sum / echo_count / SIM_TIME_US),
+                (unsigned long long) (echo_max / SIM_TIME_US),
+                (unsigned long long) (wire / SIM_TIME_US));
+
+    sim_get_stats(&st);
+    printf("@bench test=host sim_ms=%llu wall_ms=%llu accesses=%llu "
+            "irqs=%llu\n",
+            (unsigned long long) (sim_time() / SIM_TIME_MS),
+            (unsigned long long) (st.wall_s * 1000),
+            (unsigned long long) st.accesses,
+            (unsigned long long) st.irqs);
+}
+
+static void bench_handle_line(const char *line, sim_time_t t) {
+    unsigned long n, x;
+
+    // Report lines may follow payload that was not newline-terminated.
+    if ((line = strstr(line, "@bench")) == NULL)
+        return;
+    puts(line);
+
+    if (strstr(line, " test=config") != NULL) {
+        bench_baud = bench_value(line, "baud");
+        bench_frame_bits = bench_value(line, "frame_bits");
+    } else if (strstr(line, " ready=rx_bulk") != NULL) {
+        n = bench_value(line, "bytes");
+        for (x = 0; x < n; ++x)
+            sim_uart_rx_char(BENCH_SERCOM, (uint8_t) (' ' + x % 95), 0,
+                    t + BENCH_START_DELAY);
+    } else if (strstr(line, " ready=echo") != NULL) {
+        echo_left = bench_value(line, "count");
+        echo_count = 0;
+        echo_min = SIM_TIME_NEVER;
+        echo_max = echo_sum = 0;
+        if (echo_left != 0)
+            bench_echo_next(t);
+    } else if (strcmp(line, "@bench end") == 0) {
+        bench_report();
+        sim_exit(0);
+    }
+}
+
+static void bench_tx(void *arg, unsigned int sercom, uint8_t c,
+        sim_time_t t) {
+    (void) arg;
+    (void) sercom;
+
+    // A report line means the firmware has given up on the echo test.
+    if (c == '@')
+        echo_left = 0;
+    if (echo_left != 0 && c == echo_char) {
+        sim_time_t rtt = t - echo_sent;
+
+        if (rtt < echo_min)
+            echo_min = rtt;
+        if (rtt > echo_max)
+            echo_max = rtt;
+        echo_sum += rtt;
+        ++echo_count;
+        if (--echo_left != 0)
+            bench_echo_next(t);
+        return;
+    }
+
+    if (c == '\n') {
+        while (bench_line_len > 0 && bench_line[bench_line_len - 1] == '\r')
+            --bench_line_len;
+        bench_line[bench_line_len] = '\0';
+        bench_handle_line(bench_line, t);
+        bench_line_len = 0;
+    } else if (bench_line_len < BENCH_LINE_MAX - 1) {
+        bench_line[bench_line_len++] = (char) c;
+    }
+}
+
+int sim_app_init(int argc, char **argv) {
+    (void) argv;
+    if (argc != 0)
+        return 1;
+    sim_uart_set_tx_hook(BENCH_SERCOM, bench_tx, NULL);
+    return 0;
+}
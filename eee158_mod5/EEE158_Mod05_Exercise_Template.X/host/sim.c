@@ -0,0 +1,1048 @@
+/**
+ * @file  host/sim.c
+ * @brief Host-side register-level simulator, core and console front-end
+ *
+ * The firmware is built for x86-64 Linux against host/xc.h, whose register
+ * blocks sit at fixed addresses that are mapped inaccessible. Every access
+ * to them faults; the SIGSEGV handler decodes the faulting instruction and
+ * forwards the access to the owning peripheral model:
+ *
+ * - Plain MOV/MOVZX/MOVSX loads and stores are emulated outright, by
+ *   patching the interrupted register file and skipping the instruction.
+ *   This is the common case, and needs a single signal per access.
+ *
+ * - Anything else (read-modify-write ALU instructions, TEST/CMP against
+ *   memory, ...) is single-stepped: the page is briefly opened up with the
+ *   value the model returned, the trap flag is set, and the SIGTRAP that
+ *   follows the instruction collects any written value and closes the
+ *   page again.
+ *
+ * Time is virtual. Each register access costs a fixed number of CPU cycles,
+ * and models schedule their own events (baud-rate timing, timer overflows,
+ * SysTick). When the firmware keeps polling without anything happening,
+ * the clock fast-forwards to the next aperiodic event (I/O, stimulus),
+ * replaying periodic timer events and their interrupt handlers on the way,
+ * up to a configurable limit. Idle stretches then cost only the interrupt
+ * handlers themselves; with the stock 5 ms SysTick, that is some 1600-2600
+ * simulated seconds per wall-clock second (x86-64 host, LED off or on the
+ * PWM blink backend). Interrupts that come faster, such as TC0's with the
+ * software blink backend, bring this down to a couple hundred.
+ *
+ * Interrupt handlers run from within the signal handler, i.e. at register
+ * access boundaries, or when PRIMASK is cleared. Firmware code that
+ * touches no register runs in zero virtual time.
+ */
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <signal.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <ucontext.h>
+#include <unistd.h>
+
+#include "sim_internal.h"
+
+/////////////////////////////////////////////////////////////////////////////
+
+// Tunables
+
+/// CPU cycles charged per register access (covers the code in between)
+#define SIM_ACCESS_CYCLES_DEFAULT	8
+
+/// Consecutive quiet accesses before the firmware is considered idle
+#define SIM_QUIET_ACCESSES		48
+
+/// Quiet time after activity before fast-forwards may run long
+#define SIM_FF_SETTLE			(10 * SIM_TIME_MS)
+
+/// Default limit for a single fast-forward
+#define SIM_FF_MAX_DEFAULT		(1 * SIM_TIME_S)
+
+/// Stack for the firmware; allocated below 4 GiB, for DMA descriptors
+#define SIM_STACK_SIZE			(8u << 20)
+
+/// Factory calibration row, read by raise_perf_level()
+#define SIM_NVM_CAL_BASE		(0x00806000UL)
+
+/////////////////////////////////////////////////////////////////////////////
+
+sim_time_t sim_now;
+volatile uint32_t sim_primask;
+
+static unsigned int sim_access_cycles = SIM_ACCESS_CYCLES_DEFAULT;
+static sim_time_t sim_ff_max = SIM_FF_MAX_DEFAULT;
+static sim_stats_t sim_stats;
+static struct timespec sim_wall_start;
+
+// Idle detection
+static unsigned int sim_quiet;
+static bool sim_active;
+static sim_time_t sim_last_active;
+static bool sim_ff_running, sim_ff_abort;
+
+// Single alarm for front-ends
+static struct {
+    sim_time_t at;
+    void (*fn)(void *arg);
+    void *arg;
+} sim_alarm = {SIM_TIME_NEVER, NULL, NULL};
+
+/////////////////////////////////////////////////////////////////////////////
+
+void sim_fatal(const char *fmt, ...) {
+    va_list ap;
+
+    fflush(stdout);
+    fprintf(stderr, "sim: [%.6f s] ", (double) sim_now / SIM_TIME_S);
+    va_start(ap, fmt);
+    vfprintf(stderr, fmt, ap);
+    va_end(ap);
+    fputc('\n', stderr);
+    abort();
+}
+
+sim_time_t sim_time(void) {
+    return sim_now;
+}
+
+void sim_activity(void) {
+    sim_active = true;
+    if (sim_ff_running)
+        sim_ff_abort = true;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+// Peripheral table
+
+static sim_periph_t *const sim_periphs[] = {
+    &sim_pm, &sim_mclk, &sim_oscctrl, &sim_supc, &sim_gclk, &sim_eic,
+    &sim_port, &sim_dmac, &sim_nvmctrl, &sim_evsys,
+    &sim_sercom[0], &sim_sercom[1], &sim_sercom[2], &sim_sercom[3],
+    &sim_tc0, &sim_systick,
+};
+#define NR_SIM_PERIPHS (sizeof (sim_periphs) / sizeof (sim_periphs[0]))
+
+#define SIM_PAGE_SIZE	0x1000UL
+#define SIM_PAGE(a)	((uintptr_t) (a) & ~(SIM_PAGE_SIZE - 1))
+
+static sim_periph_t *sim_periph_find(uintptr_t addr) {
+    unsigned int i;
+
+    for (i = 0; i < NR_SIM_PERIPHS; ++i) {
+        if (SIM_PAGE(sim_periphs[i]->base) == SIM_PAGE(addr))
+            return sim_periphs[i];
+    }
+    return NULL;
+}
+
+static uint32_t sim_periph_read(sim_periph_t *p, uintptr_t addr,
+        unsigned int size) {
+    uint32_t off;
+
+    if (addr < p->base || addr + size > p->base + p->size)
+        return 0;
+    off = (uint32_t) (addr - p->base);
+    if (p->read != NULL)
+        return p->read(p, off, size);
+    return sim_reg_load(p->regs, off, size);
+}
+
+static void sim_periph_write(sim_periph_t *p, uintptr_t addr,
+        unsigned int size, uint32_t val) {
+    uint32_t off;
+
+    if (addr < p->base || addr + size > p->base + p->size)
+        return;
+    off = (uint32_t) (addr - p->base);
+    if (p->write != NULL)
+        p->write(p, off, size, val);
+    else
+        sim_reg_store(p->regs, off, size, val);
+}
+
+uint32_t sim_bus_read(uint32_t addr, unsigned int size) {
+    sim_periph_t *p = sim_periph_find(addr);
+
+    if (p != NULL)
+        return sim_periph_read(p, addr, size);
+    return sim_reg_load((const void *) (uintptr_t) addr, 0, size);
+}
+
+void sim_bus_write(uint32_t addr, unsigned int size, uint32_t val) {
+    sim_periph_t *p = sim_periph_find(addr);
+
+    if (p != NULL)
+        sim_periph_write(p, addr, size, val);
+    else
+        sim_reg_store((void *) (uintptr_t) addr, 0, size, val);
+}
+
+static void sim_map_periphs(void) {
+    static const uint8_t nvm_cal[] = {
+        // 0x00806020: DFLL48M coarse calibration in bits 30:25
+        [0x20] = 0x00, 0x00, 0x00, 0x3E,
+    };
+    unsigned int i;
+    void *m;
+
+    for (i = 0; i < NR_SIM_PERIPHS; ++i) {
+        m = mmap((void *) SIM_PAGE(sim_periphs[i]->base), SIM_PAGE_SIZE,
+                PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE,
+                -1, 0);
+        if (m != (void *) SIM_PAGE(sim_periphs[i]->base))
+            sim_fatal("cannot map %s at %#lx: %s", sim_periphs[i]->name,
+                (unsigned long) sim_periphs[i]->base, strerror(errno));
+    }
+
+    m = mmap((void *) SIM_NVM_CAL_BASE, SIM_PAGE_SIZE,
+            PROT_READ | PROT_WRITE,
+            MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0);
+    if (m != (void *) SIM_NVM_CAL_BASE)
+        sim_fatal("cannot map the NVM calibration row: %s", strerror(errno));
+    memcpy(m, nvm_cal, sizeof (nvm_cal));
+    mprotect(m, SIM_PAGE_SIZE, PROT_READ);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+// Interrupt model (NVIC + SysTick exception)
+
+#define NR_SIM_IRQ	64
+#define SIM_PRIO_THREAD	256
+
+static struct {
+    bool enabled;
+    bool pending;
+    bool active;
+    bool level;
+    uint8_t prio;
+} sim_nvic[NR_SIM_IRQ];
+static bool sim_systick_pending;
+static uint8_t sim_systick_prio;
+static unsigned int sim_exec_prio = SIM_PRIO_THREAD;
+
+#define SIM_HANDLERS(X) \
+    X(SysTick) X(EIC_EXTINT_0) X(EIC_EXTINT_1) X(EIC_EXTINT_2) \
+    X(EIC_EXTINT_3) X(EIC_OTHER) X(DMAC_0) X(DMAC_1) X(DMAC_2) X(DMAC_3) \
+    X(DMAC_OTHER) X(EVSYS_0) X(SERCOM0_0) X(SERCOM0_1) X(SERCOM0_2) \
+    X(SERCOM0_OTHER) X(SERCOM1_0) X(SERCOM1_1) X(SERCOM1_2) \
+    X(SERCOM1_OTHER) X(SERCOM2_0) X(SERCOM2_1) X(SERCOM2_2) \
+    X(SERCOM2_OTHER) X(SERCOM3_0) X(SERCOM3_1) X(SERCOM3_2) \
+    X(SERCOM3_OTHER) X(TC0) X(TC1) X(TC2)
+
+#define SIM_HANDLER_DECL(n) extern void n##_Handler(void) __attribute__((weak));
+SIM_HANDLERS(SIM_HANDLER_DECL)
+#undef SIM_HANDLER_DECL
+
+static void (*sim_vectors[NR_SIM_IRQ + 1])(void);
+#define SIM_VECTOR(irq)	sim_vectors[(irq) + 1]
+
+static void sim_irq_init(void) {
+#define SIM_HANDLER_SET(n) SIM_VECTOR(n##_IRQn) = n##_Handler;
+    SIM_HANDLERS(SIM_HANDLER_SET)
+#undef SIM_HANDLER_SET
+}
+
+static bool sim_irq_valid(int irq) {
+    return irq >= 0 && irq < NR_SIM_IRQ;
+}
+
+void sim_irq_level(int irq, bool level) {
+    if (!sim_irq_valid(irq))
+        return;
+    sim_nvic[irq].level = level;
+
+    // While the handler runs, only the level at exit counts (see below).
+    if (level && !sim_nvic[irq].active)
+        sim_nvic[irq].pending = true;
+}
+
+void sim_irq_pend(int irq) {
+    if (irq == SysTick_IRQn)
+        sim_systick_pending = true;
+    else if (sim_irq_valid(irq))
+        sim_nvic[irq].pending = true;
+}
+
+// Highest-priority pending exception, or -2 if none
+static int sim_irq_best(unsigned int *prio, bool ignore_enable) {
+    int best = -2, i;
+    unsigned int bp = SIM_PRIO_THREAD;
+
+    if (sim_systick_pending && sim_systick_prio < bp) {
+        best = SysTick_IRQn;
+        bp = sim_systick_prio;
+    }
+    for (i = 0; i < NR_SIM_IRQ; ++i) {
+        if (sim_nvic[i].pending && (sim_nvic[i].enabled || ignore_enable) &&
+                sim_nvic[i].prio < bp) {
+            best = i;
+            bp = sim_nvic[i].prio;
+        }
+    }
+    *prio = bp;
+    return best;
+}
+
+static bool sim_irq_periodic(int irq) {
+    return irq == SysTick_IRQn || irq == TC0_IRQn;
+}
+
+void sim_irq_poll(void) {
+    unsigned int prio, saved;
+    void (*fn)(void);
+    int irq;
+
+    for (;;) {
+        if (sim_primask != 0)
+            return;
+        irq = sim_irq_best(&prio, false);
+        if (irq == -2 || prio >= sim_exec_prio)
+            return;
+
+        if (irq == SysTick_IRQn)
+            sim_systick_pending = false;
+        else
+            sim_nvic[irq].pending = false;
+        fn = SIM_VECTOR(irq);
+        if (fn == NULL)
+            sim_fatal("unhandled interrupt %d", irq);
+        if (!sim_irq_periodic(irq))
+            sim_activity();
+
+        ++sim_stats.irqs;
+        saved = sim_exec_prio;
+        sim_exec_prio = prio;
+        if (irq >= 0)
+            sim_nvic[irq].active = true;
+        fn();
+        if (irq >= 0)
+            sim_nvic[irq].active = false;
+        sim_exec_prio = saved;
+
+        // Level-sensitive lines re-pend while still asserted
+        if (irq >= 0 && sim_nvic[irq].level)
+            sim_nvic[irq].pending = true;
+    }
+}
+
+void sim_irq_unmasked(void) {
+    sim_irq_poll();
+}
+
+void NVIC_EnableIRQ(IRQn_Type irq) {
+    if (sim_irq_valid(irq)) {
+        sim_nvic[irq].enabled = true;
+        sim_irq_poll();
+    }
+}
+
+void NVIC_DisableIRQ(IRQn_Type irq) {
+    if (sim_irq_valid(irq))
+        sim_nvic[irq].enabled = false;
+}
+
+void NVIC_SetPendingIRQ(IRQn_Type irq) {
+    sim_irq_pend(irq);
+    sim_irq_poll();
+}
+
+void NVIC_ClearPendingIRQ(IRQn_Type irq) {
+    if (irq == SysTick_IRQn)
+        sim_systick_pending = false;
+    else if (sim_irq_valid(irq))
+        sim_nvic[irq].pending = sim_nvic[irq].level;
+}
+
+uint32_t NVIC_GetPendingIRQ(IRQn_Type irq) {
+    if (irq == SysTick_IRQn)
+        return sim_systick_pending;
+    return sim_irq_valid(irq) && sim_nvic[irq].pending;
+}
+
+// Cortex-M23 implements two priority bits
+void NVIC_SetPriority(IRQn_Type irq, uint32_t prio) {
+    if (irq == SysTick_IRQn)
+        sim_systick_prio = prio & 0x3;
+    else if (sim_irq_valid(irq))
+        sim_nvic[irq].prio = prio & 0x3;
+}
+
+uint32_t NVIC_GetPriority(IRQn_Type irq) {
+    if (irq == SysTick_IRQn)
+        return sim_systick_prio;
+    return sim_irq_valid(irq) ? sim_nvic[irq].prio : 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+// Event scheduling
+
+static sim_time_t sim_alarm_next(void) {
+    return sim_alarm.at;
+}
+
+static void sim_alarm_run(sim_time_t now) {
+    if (now >= sim_alarm.at) {
+        sim_alarm.at = SIM_TIME_NEVER;
+        sim_alarm.fn(sim_alarm.arg);
+    }
+}
+
+static sim_model_t sim_alarm_model = {sim_alarm_next, sim_alarm_run, false};
+
+static sim_model_t *const sim_models[] = {
+    &sim_systick_model, &sim_sercom_model, &sim_tc_model,
+    &sim_port_model, &sim_eic_model, &sim_alarm_model,
+};
+#define NR_SIM_MODELS (sizeof (sim_models) / sizeof (sim_models[0]))
+
+static sim_time_t sim_next_event(bool aperiodic_only) {
+    sim_time_t best = SIM_TIME_NEVER, t;
+    unsigned int i;
+
+    for (i = 0; i < NR_SIM_MODELS; ++i) {
+        if (aperiodic_only && sim_models[i]->periodic)
+            continue;
+        t = sim_models[i]->next();
+        if (t < best)
+            best = t;
+    }
+    return best;
+}
+
+void sim_advance_to(sim_time_t t) {
+    sim_time_t te;
+    unsigned int i;
+
+    for (;;) {
+        if (sim_ff_abort)
+            return;
+        te = sim_next_event(false);
+        if (te > t)
+            break;
+        if (te > sim_now)
+            sim_now = te;
+        for (i = 0; i < NR_SIM_MODELS; ++i)
+            sim_models[i]->run(sim_now);
+        sim_irq_poll();
+    }
+    if (t > sim_now)
+        sim_now = t;
+}
+
+void sim_set_alarm(sim_time_t at, void (*fn)(void *arg), void *arg) {
+    sim_alarm.at = (fn != NULL) ? at : SIM_TIME_NEVER;
+    sim_alarm.fn = fn;
+    sim_alarm.arg = arg;
+}
+
+void sim_set_fast_forward(sim_time_t max_jump) {
+    sim_ff_max = max_jump;
+}
+
+/*
+ * Idle fast-forward; called from thread context after a run of quiet
+ * accesses. Jumps run to the next aperiodic event, with timer events (and
+ * their interrupts) processed along the way. Shortly after activity, a
+ * jump stops at the end of the settling window; firmware that polls the TC
+ * count further limits jumps to a fraction of the TC period.
+ */
+extern sim_time_t sim_tc_ff_limit(void);
+
+static void sim_fast_forward(void) {
+    sim_time_t start = sim_now, target, limit;
+
+    if (sim_ff_max == 0)
+        return;
+
+    limit = sim_now + sim_ff_max;
+    if (sim_tc_ff_limit() < limit)
+        limit = sim_tc_ff_limit();
+    if (sim_now - sim_last_active < SIM_FF_SETTLE &&
+            sim_last_active + SIM_FF_SETTLE < limit)
+        limit = sim_last_active + SIM_FF_SETTLE;
+    target = sim_next_event(true);
+    if (target > limit)
+        target = limit;
+    if (target <= sim_now)
+        return;
+
+    sim_ff_running = true;
+    sim_ff_abort = false;
+    sim_advance_to(target);
+    sim_ff_running = false;
+    sim_ff_abort = false;
+
+    ++sim_stats.ff_jumps;
+    sim_stats.ff_time += sim_now - start;
+}
+
+void sim_wfi(void) {
+    uint64_t irqs = sim_stats.irqs;
+    unsigned int prio;
+    sim_time_t t;
+
+    while (sim_stats.irqs == irqs && sim_irq_best(&prio, false) == -2) {
+        t = sim_next_event(false);
+        if (t == SIM_TIME_NEVER)
+            sim_fatal("WFI with no wake-up source");
+        sim_advance_to(t);
+    }
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+// Register access from the firmware
+
+static unsigned int sim_depth;
+
+static void sim_access_begin(void) {
+    ++sim_stats.accesses;
+    sim_advance_to(sim_now + sim_cycles_to_time(sim_access_cycles,
+            sim_cpu_hz()));
+    ++sim_depth;
+}
+
+static void sim_access_end(void) {
+    --sim_depth;
+
+    // Interrupts held off by PRIMASK would be lost over a fast-forward.
+    if (sim_exec_prio == SIM_PRIO_THREAD && sim_primask == 0) {
+        if (sim_active) {
+            sim_active = false;
+            sim_quiet = 0;
+            sim_last_active = sim_now;
+        } else if (++sim_quiet >= SIM_QUIET_ACCESSES) {
+            sim_quiet = 0;
+            sim_fast_forward();
+        }
+    }
+    sim_irq_poll();
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+/*
+ * x86-64 instruction decoding, for the memory operand of the faulting
+ * instruction. Only the forms GCC emits for volatile accesses are emulated;
+ * for the rest, only the operand size and whether memory is written are
+ * needed, since the instruction is single-stepped.
+ */
+typedef enum {
+    SIM_OP_OTHER = 0,
+    SIM_OP_LOAD,
+    SIM_OP_LOAD_ZX,
+    SIM_OP_LOAD_SX,
+    SIM_OP_STORE,
+    SIM_OP_STORE_IMM,
+} sim_op_t;
+
+typedef struct {
+    sim_op_t op;
+    unsigned int len;		// Instruction length
+    unsigned int size;		// Memory operand size
+    unsigned int dsize;		// Destination register size (loads)
+    unsigned int reg;		// ModRM.reg, with REX.R
+    bool rex;
+    bool writes;		// Memory is written (SIM_OP_OTHER)
+    uint32_t imm;
+} sim_insn_t;
+
+static bool sim_insn_decode(const uint8_t *ip, sim_insn_t *d) {
+    const uint8_t *p = ip;
+    bool op16 = false, two = false;
+    unsigned int rex = 0, op, modrm, mod, rm, osz, sub;
+
+    memset(d, 0, sizeof (*d));
+    for (;; ++p) {
+        if (*p == 0x66)
+            op16 = true;
+        else if (*p != 0x67 && *p != 0xF0 && *p != 0x2E && *p != 0x3E &&
+                *p != 0x26 && *p != 0x36 && *p != 0x64 && *p != 0x65)
+            break;
+    }
+    if ((*p & 0xF0) == 0x40)
+        rex = *p++;
+    op = *p++;
+    if (op == 0x0F) {
+        two = true;
+        op = *p++;
+    }
+
+    modrm = *p++;
+    mod = modrm >> 6;
+    rm = modrm & 7;
+    if (mod == 3)
+        return false;
+    if (rm == 4) {
+        if ((*p++ & 7) == 5 && mod == 0)
+            p += 4;
+    } else if (rm == 5 && mod == 0) {
+        p += 4;
+    }
+    if (mod == 1)
+        p += 1;
+    else if (mod == 2)
+        p += 4;
+
+    d->rex = (rex != 0);
+    d->reg = ((modrm >> 3) & 7) | ((rex & 0x4) ? 8 : 0);
+    sub = (modrm >> 3) & 7;
+    osz = (rex & 0x8) ? 8 : (op16 ? 2 : 4);
+
+    if (two) {
+        switch (op) {
+            case 0xB6: case 0xB7: case 0xBE: case 0xBF:
+                d->op = (op & 0x08) ? SIM_OP_LOAD_SX : SIM_OP_LOAD_ZX;
+                d->size = (op & 0x01) ? 2 : 1;
+                d->dsize = osz;
+                break;
+            case 0xB0: case 0xB1: case 0xC0: case 0xC1:
+                // CMPXCHG, XADD
+                d->size = (op & 0x01) ? osz : 1;
+                d->writes = true;
+                break;
+            default:
+                return false;
+        }
+    } else {
+        switch (op) {
+            case 0x88: case 0x89:
+                d->op = SIM_OP_STORE;
+                d->size = (op == 0x88) ? 1 : osz;
+                break;
+            case 0x8A: case 0x8B:
+                d->op = SIM_OP_LOAD;
+                d->size = d->dsize = (op == 0x8A) ? 1 : osz;
+                break;
+            case 0x63:
+                d->op = SIM_OP_LOAD_SX;
+                d->size = 4;
+                d->dsize = osz;
+                break;
+            case 0xC6:
+                if (sub != 0)
+                    return false;
+                d->op = SIM_OP_STORE_IMM;
+                d->size = 1;
+                d->imm = *p++;
+                break;
+            case 0xC7:
+                if (sub != 0)
+                    return false;
+                d->op = SIM_OP_STORE_IMM;
+                d->size = osz;
+                if (osz == 2) {
+                    d->imm = p[0] | (p[1] << 8);
+                    p += 2;
+                } else {
+                    memcpy(&d->imm, p, 4);
+                    p += 4;
+                }
+                break;
+            case 0x80: case 0x81: case 0x83:
+                d->size = (op == 0x80) ? 1 : osz;
+                d->writes = (sub != 7);
+                break;
+            case 0x84: case 0x85:
+                d->size = (op & 0x01) ? osz : 1;
+                break;
+            case 0x86: case 0x87:
+                d->size = (op & 0x01) ? osz : 1;
+                d->writes = true;
+                break;
+            case 0xF6: case 0xF7:
+                d->size = (op & 0x01) ? osz : 1;
+                d->writes = (sub == 2 || sub == 3);
+                break;
+            case 0xFE: case 0xFF:
+                d->size = (op & 0x01) ? osz : 1;
+                d->writes = (sub <= 1);
+                break;
+            case 0xC0: case 0xC1: case 0xD0: case 0xD1: case 0xD2: case 0xD3:
+                d->size = (op & 0x01) ? osz : 1;
+                d->writes = true;
+                break;
+            default:
+                if (op < 0x40 && (op & 0x07) < 4) {
+                    // ADD/OR/ADC/SBB/AND/SUB/XOR/CMP
+                    d->size = (op & 0x01) ? osz : 1;
+                    d->writes = (op & 0x02) == 0 && (op >> 3) != 7;
+                    break;
+                }
+                return false;
+        }
+    }
+    if (d->size > 4)
+        return false;
+    d->len = (unsigned int) (p - ip);
+    return true;
+}
+
+static const int sim_greg_index[16] = {
+    REG_RAX, REG_RCX, REG_RDX, REG_RBX, REG_RSP, REG_RBP, REG_RSI, REG_RDI,
+    REG_R8, REG_R9, REG_R10, REG_R11, REG_R12, REG_R13, REG_R14, REG_R15,
+};
+
+static uint32_t sim_greg_get(const mcontext_t *mc, const sim_insn_t *d) {
+    // Without REX, byte registers 4-7 are AH/CH/DH/BH.
+    if (d->size == 1 && !d->rex && d->reg >= 4 && d->reg < 8)
+        return (uint32_t) (mc->gregs[sim_greg_index[d->reg - 4]] >> 8) & 0xFF;
+    return (uint32_t) mc->gregs[sim_greg_index[d->reg]];
+}
+
+static void sim_greg_set(mcontext_t *mc, const sim_insn_t *d, uint64_t v) {
+    greg_t *r;
+
+    if (d->dsize == 1 && !d->rex && d->reg >= 4 && d->reg < 8) {
+        r = &mc->gregs[sim_greg_index[d->reg - 4]];
+        *r = (*r & ~(greg_t) 0xFF00) | (greg_t) ((v & 0xFF) << 8);
+        return;
+    }
+    r = &mc->gregs[sim_greg_index[d->reg]];
+    switch (d->dsize) {
+        case 1:
+            *r = (*r & ~(greg_t) 0xFF) | (greg_t) (v & 0xFF);
+            break;
+        case 2:
+            *r = (*r & ~(greg_t) 0xFFFF) | (greg_t) (v & 0xFFFF);
+            break;
+        case 4:
+            *r = (greg_t) (uint32_t) v;
+            break;
+        default:
+            *r = (greg_t) v;
+            break;
+    }
+}
+
+static uint64_t sim_sign_extend(uint32_t v, unsigned int size) {
+    if (size == 1)
+        return (uint64_t) (int64_t) (int8_t) v;
+    if (size == 2)
+        return (uint64_t) (int64_t) (int16_t) v;
+    return (uint64_t) (int64_t) (int32_t) v;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+// Trap handlers
+
+static struct {
+    bool active;
+    sim_periph_t *p;
+    uintptr_t addr;
+    unsigned int size;
+    bool writes;
+} sim_step;
+
+static void sim_segv(int sig, siginfo_t *si, void *uc_) {
+    ucontext_t *uc = uc_;
+    mcontext_t *mc = &uc->uc_mcontext;
+    uintptr_t addr = (uintptr_t) si->si_addr;
+    sim_periph_t *p = sim_periph_find(addr);
+    sim_insn_t d;
+    uint32_t v;
+    bool ok;
+
+    (void) sig;
+    if (p == NULL || sim_depth != 0 || sim_step.active) {
+        fprintf(stderr, "sim: fault at %#lx (rip %#llx)\n",
+                (unsigned long) addr, (unsigned long long) mc->gregs[REG_RIP]);
+        signal(SIGSEGV, SIG_DFL);
+        return;
+    }
+
+    ok = sim_insn_decode((const uint8_t *) mc->gregs[REG_RIP], &d);
+    sim_access_begin();
+
+    switch (ok ? d.op : SIM_OP_OTHER) {
+        case SIM_OP_LOAD:
+        case SIM_OP_LOAD_ZX:
+            sim_greg_set(mc, &d, sim_periph_read(p, addr, d.size));
+            break;
+        case SIM_OP_LOAD_SX:
+            sim_greg_set(mc, &d,
+                sim_sign_extend(sim_periph_read(p, addr, d.size), d.size));
+            break;
+        case SIM_OP_STORE:
+            sim_periph_write(p, addr, d.size, sim_greg_get(mc, &d));
+            break;
+        case SIM_OP_STORE_IMM:
+            sim_periph_write(p, addr, d.size, d.imm);
+            break;
+        default:
+            // Open the page with the value read, and step over.
+            if (!ok) {
+                d.size = 4;
+                d.writes = (mc->gregs[REG_ERR] & 0x2) != 0;
+            }
+            v = (!ok && d.writes) ? 0 : sim_periph_read(p, addr, d.size);
+            sim_step.active = true;
+            sim_step.p = p;
+            sim_step.addr = addr;
+            sim_step.size = d.size;
+            sim_step.writes = d.writes;
+            mprotect((void *) SIM_PAGE(addr), SIM_PAGE_SIZE,
+                    PROT_READ | PROT_WRITE);
+            memcpy((void *) addr, &v, d.size);
+            mc->gregs[REG_EFL] |= 0x100;
+            ++sim_stats.stepped;
+            --sim_depth;
+            return;
+    }
+
+    mc->gregs[REG_RIP] += d.len;
+    ++sim_stats.emulated;
+    sim_access_end();
+}
+
+static void sim_trap(int sig, siginfo_t *si, void *uc_) {
+    ucontext_t *uc = uc_;
+    mcontext_t *mc = &uc->uc_mcontext;
+    uint32_t v = 0;
+
+    (void) sig;
+    (void) si;
+    if (!sim_step.active)
+        return;
+
+    mc->gregs[REG_EFL] &= ~0x100;
+    memcpy(&v, (const void *) sim_step.addr, sim_step.size);
+    mprotect((void *) SIM_PAGE(sim_step.addr), SIM_PAGE_SIZE, PROT_NONE);
+    sim_step.active = false;
+
+    ++sim_depth;
+    if (sim_step.writes)
+        sim_periph_write(sim_step.p, sim_step.addr, sim_step.size, v);
+    sim_access_end();
+}
+
+static void sim_install_traps(void) {
+    struct sigaction sa;
+
+    memset(&sa, 0, sizeof (sa));
+    sa.sa_flags = SA_SIGINFO | SA_NODEFER;
+    sigemptyset(&sa.sa_mask);
+    sa.sa_sigaction = sim_segv;
+    sigaction(SIGSEGV, &sa, NULL);
+    sa.sa_sigaction = sim_trap;
+    sigaction(SIGTRAP, &sa, NULL);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+// Statistics and shutdown
+
+static bool sim_opt_stats;
+
+void sim_get_stats(sim_stats_t *stats) {
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    *stats = sim_stats;
+    stats->wall_s = (double) (now.tv_sec - sim_wall_start.tv_sec) +
+            (double) (now.tv_nsec - sim_wall_start.tv_nsec) / 1e9;
+}
+
+void sim_exit(int status) {
+    sim_stats_t st;
+    double vs;
+
+    fflush(stdout);
+    if (sim_opt_stats) {
+        sim_get_stats(&st);
+        vs = (double) sim_now / SIM_TIME_S;
+        fprintf(stderr,
+                "sim: %.3f s simulated in %.3f s (x%.0f)\n"
+                "sim: %llu register accesses (%llu emulated, %llu stepped), "
+                "%llu interrupts\n"
+                "sim: %llu fast-forwards, skipping %.3f s\n",
+                vs, st.wall_s, st.wall_s > 0 ? vs / st.wall_s : 0.0,
+                (unsigned long long) st.accesses,
+                (unsigned long long) st.emulated,
+                (unsigned long long) st.stepped,
+                (unsigned long long) st.irqs,
+                (unsigned long long) st.ff_jumps,
+                (double) st.ff_time / SIM_TIME_S);
+        sim_sercom_report();
+        sim_port_report();
+    }
+    exit(status);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+// Console front-end
+
+#define SIM_CONSOLE_SERCOM	3	// The on-board debugger's CDC port
+#define SIM_BUTTON_GROUP	0	// PA23
+#define SIM_BUTTON_PIN		23
+
+static bool sim_opt_quiet, sim_opt_pins;
+
+int __attribute__((weak)) sim_app_init(int argc, char **argv) {
+    (void) argv;
+    return argc != 0;
+}
+
+static void sim_console_tx(void *arg, unsigned int sercom, uint8_t c,
+        sim_time_t t) {
+    (void) arg;
+    (void) sercom;
+    (void) t;
+    if (!sim_opt_quiet)
+        putchar(c);
+}
+
+static void sim_console_pin(void *arg, unsigned int group, unsigned int pin,
+        int level, sim_time_t t) {
+    (void) arg;
+    fprintf(stderr, "sim: [%.6f s] P%c%02u = %d\n",
+            (double) t / SIM_TIME_S, 'A' + group, pin, level);
+}
+
+static void sim_stop(void *arg) {
+    (void) arg;
+    sim_exit(0);
+}
+
+static void sim_usage(const char *argv0) {
+    fprintf(stderr,
+            "usage: %s [options] [-- harness options]\n"
+            "  -t SECONDS     Simulated run time (default 10)\n"
+            "  -i FILE        Feed FILE (- for stdin) to the console RX\n"
+            "  -d MS          Delay before console input starts (default 100)\n"
+            "  -b MS:press    Press (or :release) the on-board button at MS\n"
+            "  -k MS:TEXT     Type TEXT on the console RX at MS\n"
+            "  -c CYCLES      CPU cycles charged per register access "
+            "(default %u)\n"
+            "  -f MS          Longest fast-forward; 0 disables (default %llu)\n"
+            "  -p             Log pin changes to stderr\n"
+            "  -q             Do not echo console output\n"
+            "  -s             Print statistics on exit\n",
+            argv0, SIM_ACCESS_CYCLES_DEFAULT,
+            (unsigned long long) (SIM_FF_MAX_DEFAULT / SIM_TIME_MS));
+    exit(2);
+}
+
+static void sim_read_input(const char *path, sim_time_t at) {
+    FILE *f = (strcmp(path, "-") == 0) ? stdin : fopen(path, "rb");
+    char buf[4096];
+    size_t n;
+
+    if (f == NULL)
+        sim_fatal("cannot open %s: %s", path, strerror(errno));
+    while ((n = fread(buf, 1, sizeof (buf), f)) > 0)
+        sim_uart_rx(SIM_CONSOLE_SERCOM, buf, n, at);
+    if (f != stdin)
+        fclose(f);
+}
+
+static ucontext_t sim_uc_host, sim_uc_fw;
+
+static void sim_fw_entry(void) {
+    int rc = sim_firmware_main();
+
+    fprintf(stderr, "sim: main() returned %d\n", rc);
+    sim_exit(rc);
+}
+
+int main(int argc, char **argv) {
+    double run_s = 10.0, delay_ms = 100.0, ms;
+    const char *input = NULL;
+    char *end;
+    void *stack;
+    int opt;
+
+    sim_sys_reset();
+    sim_sercom_reset();
+    sim_tc_reset();
+    sim_port_reset();
+    sim_dmac_reset();
+    sim_irq_init();
+
+    while ((opt = getopt(argc, argv, "t:i:d:b:k:c:f:pqs")) != -1) {
+        switch (opt) {
+            case 't':
+                run_s = strtod(optarg, NULL);
+                break;
+            case 'i':
+                input = optarg;
+                break;
+            case 'd':
+                delay_ms = strtod(optarg, NULL);
+                break;
+            case 'b':
+                ms = strtod(optarg, &end);
+                if (*end != ':')
+                    sim_usage(argv[0]);
+                if (strcmp(end + 1, "press") == 0)
+                    sim_pin_drive(SIM_BUTTON_GROUP, SIM_BUTTON_PIN, 0,
+                        (sim_time_t) (ms * SIM_TIME_MS));
+                else if (strcmp(end + 1, "release") == 0)
+                    sim_pin_drive(SIM_BUTTON_GROUP, SIM_BUTTON_PIN, -1,
+                        (sim_time_t) (ms * SIM_TIME_MS));
+                else
+                    sim_usage(argv[0]);
+                break;
+            case 'k':
+                ms = strtod(optarg, &end);
+                if (*end != ':')
+                    sim_usage(argv[0]);
+                sim_uart_rx(SIM_CONSOLE_SERCOM, end + 1, strlen(end + 1),
+                        (sim_time_t) (ms * SIM_TIME_MS));
+                break;
+            case 'c':
+                sim_access_cycles = (unsigned int) strtoul(optarg, NULL, 0);
+                break;
+            case 'f':
+                sim_ff_max = (sim_time_t) (strtod(optarg, NULL) *
+                        SIM_TIME_MS);
+                break;
+            case 'p':
+                sim_opt_pins = true;
+                break;
+            case 'q':
+                sim_opt_quiet = true;
+                break;
+            case 's':
+                sim_opt_stats = true;
+                break;
+            default:
+                sim_usage(argv[0]);
+        }
+    }
+
+    sim_uart_set_tx_hook(SIM_CONSOLE_SERCOM, sim_console_tx, NULL);
+    if (sim_opt_pins)
+        sim_set_pin_hook(sim_console_pin, NULL);
+    if (input != NULL)
+        sim_read_input(input, (sim_time_t) (delay_ms * SIM_TIME_MS));
+    sim_set_alarm((sim_time_t) (run_s * SIM_TIME_S), sim_stop, NULL);
+    if (sim_app_init(argc - optind, argv + optind) != 0)
+        sim_usage(argv[0]);
+
+    sim_map_periphs();
+    sim_install_traps();
+    clock_gettime(CLOCK_MONOTONIC, &sim_wall_start);
+
+    stack = mmap(NULL, SIM_STACK_SIZE, PROT_READ | PROT_WRITE,
+            MAP_PRIVATE | MAP_ANONYMOUS | MAP_32BIT, -1, 0);
+    if (stack == MAP_FAILED)
+        sim_fatal("cannot allocate the firmware stack: %s", strerror(errno));
+    getcontext(&sim_uc_fw);
+    sim_uc_fw.uc_stack.ss_sp = stack;
+    sim_uc_fw.uc_stack.ss_size = SIM_STACK_SIZE;
+    sim_uc_fw.uc_link = &sim_uc_host;
+    makecontext(&sim_uc_fw, sim_fw_entry, 0);
+    swapcontext(&sim_uc_host, &sim_uc_fw);
+    return 0;
+}
@@ -0,0 +1,180 @@
+/**
+ * @file  host/sim.h
+ * @brief Host-side register-level simulator, public interface
+ *
+ * The simulator runs the unchanged firmware as a Linux process: register
+ * accesses trap into peripheral models that share one virtual clock. This
+ * header is for code that drives the simulation from the outside (the
+ * stock console front-end in sim.c, or benchmark harnesses); the firmware
+ * itself only ever sees xc.h.
+ *
+ * All functions here must be called either before the firmware starts, or
+ * from simulator callbacks (which run at register-access boundaries).
+ */
+
+#if !defined(EEE158_EX05_HOST_SIM_H_)
+#define EEE158_EX05_HOST_SIM_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/// Virtual time, in picoseconds since reset
+typedef uint64_t sim_time_t;
+
+#define SIM_TIME_NEVER		UINT64_MAX
+#define SIM_TIME_NS		((sim_time_t) 1000)
+#define SIM_TIME_US		((sim_time_t) 1000000)
+#define SIM_TIME_MS		((sim_time_t) 1000000000)
+#define SIM_TIME_S		((sim_time_t) 1000000000000)
+
+/// Get the current virtual time
+sim_time_t sim_time(void);
+
+/////////////////////////////////////////////////////////////////////////////
+
+// SERCOM USART stimulus and observation
+
+/// Flags for @c sim_uart_rx_char()
+#define SIM_UART_RX_FERR	0x01	// Frame error (bad stop bit)
+#define SIM_UART_RX_PERR	0x02	// Parity error
+#define SIM_UART_RX_BREAK	0x04	// Break condition, instead of data
+
+/**
+ * Queue a character for reception on a SERCOM
+ *
+ * Characters arrive back-to-back at the sender's line rate (see
+ * @c sim_uart_set_rx_baud()), but never before @p at. With RTS/CTS flow control enabled, the sender holds
+ * off while RTS is deasserted.
+ *
+ * @param[in]	sercom	SERCOM instance (0-3)
+ * @param[in]	c	Character value
+ * @param[in]	flags	Error conditions to inject (@c SIM_UART_RX_*)
+ * @param[in]	at	Earliest start time of the character
+ */
+void sim_uart_rx_char(unsigned int sercom, uint8_t c, unsigned int flags,
+        sim_time_t at);
+
+/// Queue a buffer for reception; see @c sim_uart_rx_char()
+void sim_uart_rx(unsigned int sercom, const void *buf, size_t len,
+        sim_time_t at);
+
+/**
+ * Set the line rate of the remote sender on a SERCOM
+ *
+ * Zero (the default) follows the SERCOM's configured rate. A different rate
+ * does not garble characters; it only shows in their timing, and in the
+ * rate that auto-baud reprograms BAUD to on a valid sync field.
+ *
+ * @param[in]	sercom	SERCOM instance (0-3)
+ * @param[in]	baud	Line rate, in bit/s; takes effect from the next
+ *			character the sender starts
+ */
+void sim_uart_set_rx_baud(unsigned int sercom, double baud);
+
+/// Number of queued characters that have not yet been received
+size_t sim_uart_rx_pending(unsigned int sercom);
+
+/**
+ * Callback for characters leaving a SERCOM's transmitter
+ *
+ * @param[in]	arg	Opaque pointer given at registration
+ * @param[in]	sercom	SERCOM instance
+ * @param[in]	c	Character value
+ * @param[in]	t	Time at which the stop bit finished
+ */
+typedef void (*sim_uart_tx_hook_t)(void *arg, unsigned int sercom, uint8_t c,
+        sim_time_t t);
+
+/// Register (or, with @c NULL, remove) the transmit hook of a SERCOM
+void sim_uart_set_tx_hook(unsigned int sercom, sim_uart_tx_hook_t fn,
+        void *arg);
+
+/// Get the line rate a SERCOM is currently configured for, in bit/s
+double sim_uart_baud(unsigned int sercom);
+
+/////////////////////////////////////////////////////////////////////////////
+
+// Pin stimulus and observation
+
+/**
+ * Drive an external signal onto a pin
+ *
+ * @param[in]	group	PORT group (0 = PA, 1 = PB)
+ * @param[in]	pin	Pin within the group
+ * @param[in]	level	0 or 1 to drive; -1 to release (board pull-ups apply)
+ * @param[in]	at	Time of the change
+ */
+void sim_pin_drive(unsigned int group, unsigned int pin, int level,
+        sim_time_t at);
+
+/**
+ * Callback for pin level changes
+ *
+ * Only pins that the firmware drives (PORT output or peripheral output)
+ * are reported.
+ */
+typedef void (*sim_pin_hook_t)(void *arg, unsigned int group,
+        unsigned int pin, int level, sim_time_t t);
+
+/// Register (or, with @c NULL, remove) the pin-change hook
+void sim_set_pin_hook(sim_pin_hook_t fn, void *arg);
+
+/// Get the current level of a pin
+int sim_pin_level(unsigned int group, unsigned int pin);
+
+/////////////////////////////////////////////////////////////////////////////
+
+// Run control
+
+/**
+ * Schedule a callback at a given virtual time
+ *
+ * Only one callback may be outstanding; a new one replaces the old. The
+ * callback may reschedule itself, or end the run via @c sim_exit().
+ */
+void sim_set_alarm(sim_time_t at, void (*fn)(void *arg), void *arg);
+
+/// End the simulation, flushing the console and printing statistics
+void sim_exit(int status) __attribute__((noreturn));
+
+/**
+ * Configure time acceleration
+ *
+ * @param[in]	max_jump	Longest single fast-forward; 0 disables
+ *				idle fast-forwarding altogether.
+ */
+void sim_set_fast_forward(sim_time_t max_jump);
+
+/// Simulator statistics
+typedef struct sim_stats_type {
+    uint64_t accesses;		// Register accesses by the firmware
+    uint64_t emulated;		// ... handled by instruction emulation
+    uint64_t stepped;		// ... handled by single-stepping
+    uint64_t irqs;		// Interrupt handlers invoked
+    uint64_t ff_jumps;		// Idle fast-forwards taken
+    sim_time_t ff_time;		// Virtual time skipped by fast-forwarding
+    double wall_s;		// Wall-clock time since reset
+} sim_stats_t;
+
+/// Get the simulator statistics
+void sim_get_stats(sim_stats_t *stats);
+
+/////////////////////////////////////////////////////////////////////////////
+
+/*
+ * Front-end hooks
+ *
+ * The stock front-end (sim.c) passes options it does not recognize, plus
+ * everything after "--", to @c sim_app_init(). The default (weak) version
+ * rejects them; a harness linked in place of the console front-end can
+ * override it to parse its own options and install hooks.
+ *
+ * @return 0 on success, non-zero to abort with a usage message
+ */
+int sim_app_init(int argc, char **argv);
+
+/// The firmware's main(), renamed at compile time
+int sim_firmware_main(void);
+
+#endif	// !defined(EEE158_EX05_HOST_SIM_H_)
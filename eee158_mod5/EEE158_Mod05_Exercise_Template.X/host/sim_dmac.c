@@ -0,0 +1,333 @@
+/**
+ * @file  host/sim_dmac.c
+ * @brief Host-side register-level simulator, DMAC model
+ *
+ * Channels fetch descriptors from BASEADDR and work on their write-back
+ * copy at WRBADDR, so the firmware sees BTCNT count down beat by beat.
+ * SRCADDR/DSTADDR hold end addresses when incrementing, as on hardware.
+ * Peripheral triggers are either levels polled from the SERCOM model
+ * (RXC/DRE) or one-shot pulses (TC0), and a beat happens as soon as it is
+ * triggered; bus arbitration, priorities and transfer latency are not
+ * modelled. ACTIVE always reads as idle.
+ */
+
+#include "sim_internal.h"
+
+#define NR_DMAC_CH		8
+
+// CTRL
+#define CTRL_SWRST		(1u << 0)
+#define CTRL_DMAENABLE		(1u << 1)
+
+// CHCTRLA
+#define CHCTRLA_SWRST		(1u << 0)
+#define CHCTRLA_ENABLE		(1u << 1)
+
+// CHCTRLB
+#define CHCTRLB_TRIGSRC(x)	(((x) >> 8) & 0x3F)
+#define CHCTRLB_TRIGACT(x)	(((x) >> 22) & 0x3)
+#define TRIGACT_BLOCK		0
+#define TRIGACT_BEAT		2
+#define TRIGACT_TRANSACTION	3
+#define CHCTRLB_CMD(x)		(((x) >> 24) & 0x3)
+#define CMD_SUSPEND		1
+#define CMD_RESUME		2
+
+// CHINTFLAG
+#define CHINT_TERR		(1u << 0)
+#define CHINT_TCMPL		(1u << 1)
+#define CHINT_SUSP		(1u << 2)
+
+// CHSTATUS
+#define CHSTATUS_FERR		(1u << 2)
+
+// Descriptor BTCTRL
+#define BTCTRL_VALID		(1u << 0)
+#define BTCTRL_BLOCKACT(x)	(((x) >> 3) & 0x3)
+#define BTCTRL_BEATSIZE(x)	(((x) >> 8) & 0x3)
+#define BTCTRL_SRCINC		(1u << 10)
+#define BTCTRL_DSTINC		(1u << 11)
+#define BTCTRL_STEPSEL		(1u << 12)
+#define BTCTRL_STEPSIZE(x)	(((x) >> 13) & 0x7)
+
+// Descriptor layout in SRAM
+#define DESC_BTCTRL		0x0
+#define DESC_BTCNT		0x2
+#define DESC_SRCADDR		0x4
+#define DESC_DSTADDR		0x8
+#define DESC_DESCADDR		0xC
+#define DESC_SIZE		16
+
+static dmac_registers_t dmac_regs;
+
+static struct {
+    uint8_t chctrla;
+    uint32_t chctrlb;
+    uint8_t inten, intflag, status;
+    bool suspended;
+} dmac_ch[NR_DMAC_CH];
+
+static bool dmac_polling, dmac_repoll;
+
+/////////////////////////////////////////////////////////////////////////////
+
+static uint32_t dmac_wb(unsigned int ch) {
+    return dmac_regs.DMAC_WRBADDR + ch * DESC_SIZE;
+}
+
+static uint32_t dmac_mem_read(uint32_t addr, unsigned int size) {
+    return sim_reg_load((const void *) (uintptr_t) addr, 0, size);
+}
+
+static void dmac_mem_write(uint32_t addr, unsigned int size, uint32_t val) {
+    sim_reg_store((void *) (uintptr_t) addr, 0, size, val);
+}
+
+static void dmac_update_irq(void) {
+    uint16_t pend = 0;
+    uint32_t status = 0;
+    bool other = false;
+    unsigned int ch;
+
+    for (ch = 0; ch < NR_DMAC_CH; ++ch) {
+        bool act = (dmac_ch[ch].intflag & dmac_ch[ch].inten) != 0;
+
+        if (act)
+            status |= 1u << ch;
+        if (ch < 4)
+            sim_irq_level(DMAC_0_IRQn + ch, act);
+        else
+            other = other || act;
+    }
+    sim_irq_level(DMAC_OTHER_IRQn, other);
+    for (ch = 0; ch < NR_DMAC_CH; ++ch) {
+        if (status & (1u << ch)) {
+            pend = (uint16_t) (ch | ((dmac_ch[ch].intflag & 0x7) << 8));
+            break;
+        }
+    }
+    dmac_regs.DMAC_INTPEND = pend;
+    dmac_regs.DMAC_INTSTATUS = status;
+}
+
+static bool dmac_ch_running(unsigned int ch) {
+    return (dmac_regs.DMAC_CTRL & CTRL_DMAENABLE) != 0 &&
+            (dmac_ch[ch].chctrla & CHCTRLA_ENABLE) != 0 &&
+            !dmac_ch[ch].suspended;
+}
+
+// Copy a descriptor into the channel's write-back slot
+static bool dmac_fetch(unsigned int ch, uint32_t addr) {
+    unsigned int i;
+
+    if (addr == 0 || (dmac_mem_read(addr + DESC_BTCTRL, 2) & BTCTRL_VALID) == 0) {
+        dmac_ch[ch].status |= CHSTATUS_FERR;
+        dmac_ch[ch].suspended = true;
+        dmac_ch[ch].intflag |= CHINT_SUSP;
+        return false;
+    }
+    for (i = 0; i < DESC_SIZE; i += 4)
+        dmac_mem_write(dmac_wb(ch) + i, 4, dmac_mem_read(addr + i, 4));
+    return true;
+}
+
+// Move one beat; returns whether the block is done
+static bool dmac_beat(unsigned int ch) {
+    uint32_t wb = dmac_wb(ch);
+    uint32_t btctrl = dmac_mem_read(wb + DESC_BTCTRL, 2);
+    uint32_t btcnt = dmac_mem_read(wb + DESC_BTCNT, 2);
+    uint32_t src = dmac_mem_read(wb + DESC_SRCADDR, 4);
+    uint32_t dst = dmac_mem_read(wb + DESC_DSTADDR, 4);
+    unsigned int size = 1u << BTCTRL_BEATSIZE(btctrl);
+    uint32_t sstep = size, dstep = size;
+
+    if (btcnt == 0)
+        return true;
+    if (btctrl & BTCTRL_STEPSEL)
+        sstep <<= BTCTRL_STEPSIZE(btctrl);
+    else
+        dstep <<= BTCTRL_STEPSIZE(btctrl);
+    if (btctrl & BTCTRL_SRCINC)
+        src -= btcnt * sstep;
+    if (btctrl & BTCTRL_DSTINC)
+        dst -= btcnt * dstep;
+
+    sim_bus_write(dst, size, sim_bus_read(src, size));
+    dmac_mem_write(wb + DESC_BTCNT, 2, --btcnt);
+    return btcnt == 0;
+}
+
+static void dmac_block_done(unsigned int ch) {
+    uint32_t wb = dmac_wb(ch);
+    uint32_t btctrl = dmac_mem_read(wb + DESC_BTCTRL, 2);
+    uint32_t next = dmac_mem_read(wb + DESC_DESCADDR, 4);
+    unsigned int act = BTCTRL_BLOCKACT(btctrl);
+
+    if (act & 0x1)
+        dmac_ch[ch].intflag |= CHINT_TCMPL;
+    if (next == 0) {
+        dmac_ch[ch].chctrla &= ~CHCTRLA_ENABLE;
+        dmac_mem_write(wb + DESC_BTCTRL, 2, btctrl & ~BTCTRL_VALID);
+    } else if (dmac_fetch(ch, next) && (act & 0x2)) {
+        dmac_ch[ch].suspended = true;
+        dmac_ch[ch].intflag |= CHINT_SUSP;
+    }
+}
+
+// Serve one trigger on a channel
+static void dmac_trigger(unsigned int ch) {
+    unsigned int act = CHCTRLB_TRIGACT(dmac_ch[ch].chctrlb);
+
+    if (!dmac_ch_running(ch))
+        return;
+    if (act == TRIGACT_BEAT) {
+        if (dmac_beat(ch))
+            dmac_block_done(ch);
+    } else {
+        do {
+            while (!dmac_beat(ch))
+                ;
+            dmac_block_done(ch);
+        } while (act == TRIGACT_TRANSACTION && dmac_ch_running(ch));
+    }
+    dmac_update_irq();
+}
+
+void sim_dmac_poll(void) {
+    unsigned int ch, trig;
+
+    if (dmac_polling) {
+        dmac_repoll = true;
+        return;
+    }
+    dmac_polling = true;
+    do {
+        dmac_repoll = false;
+        for (ch = 0; ch < NR_DMAC_CH; ++ch) {
+            trig = CHCTRLB_TRIGSRC(dmac_ch[ch].chctrlb);
+            while (trig != 0 && dmac_ch_running(ch) &&
+                    sim_sercom_dma_trig(trig)) {
+                dmac_trigger(ch);
+                dmac_repoll = true;
+            }
+        }
+    } while (dmac_repoll);
+    dmac_polling = false;
+}
+
+void sim_dmac_pulse(unsigned int trig) {
+    unsigned int ch;
+
+    for (ch = 0; ch < NR_DMAC_CH; ++ch) {
+        if (CHCTRLB_TRIGSRC(dmac_ch[ch].chctrlb) == trig)
+            dmac_trigger(ch);
+    }
+}
+
+bool sim_dmac_trig_used(unsigned int trig) {
+    unsigned int ch;
+
+    for (ch = 0; ch < NR_DMAC_CH; ++ch) {
+        if ((dmac_ch[ch].chctrla & CHCTRLA_ENABLE) != 0 &&
+                CHCTRLB_TRIGSRC(dmac_ch[ch].chctrlb) == trig)
+            return true;
+    }
+    return false;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+// Register access
+
+static void dmac_ch_reset(unsigned int ch) {
+    memset(&dmac_ch[ch], 0, sizeof (dmac_ch[ch]));
+}
+
+static uint32_t dmac_read(sim_periph_t *p, uint32_t off, unsigned int size) {
+    unsigned int ch = dmac_regs.DMAC_CHID % NR_DMAC_CH;
+
+    (void) p;
+    dmac_regs.DMAC_CHCTRLA = dmac_ch[ch].chctrla;
+    dmac_regs.DMAC_CHCTRLB = dmac_ch[ch].chctrlb;
+    dmac_regs.DMAC_CHINTENSET = dmac_regs.DMAC_CHINTENCLR = dmac_ch[ch].inten;
+    dmac_regs.DMAC_CHINTFLAG = dmac_ch[ch].intflag;
+    dmac_regs.DMAC_CHSTATUS = dmac_ch[ch].status;
+    dmac_regs.DMAC_ACTIVE = 0;
+    dmac_regs.DMAC_BUSYCH = dmac_regs.DMAC_PENDCH = 0;
+    return sim_reg_load(&dmac_regs, off, size);
+}
+
+static void dmac_write(sim_periph_t *p, uint32_t off, unsigned int size,
+        uint32_t val) {
+    unsigned int ch = dmac_regs.DMAC_CHID % NR_DMAC_CH, n;
+    uint32_t v;
+    uint8_t old;
+
+    (void) p;
+    if (sim_reg_hit(off, size, 0x00, 2)) {
+        v = sim_reg_merge(dmac_regs.DMAC_CTRL, 0x00, off, size, val);
+        if ((v & CTRL_SWRST) && (dmac_regs.DMAC_CTRL & CTRL_DMAENABLE) == 0) {
+            sim_dmac_reset();
+        } else {
+            dmac_regs.DMAC_CTRL = (uint16_t) (v & ~CTRL_SWRST);
+        }
+    } else if (sim_reg_hit(off, size, 0x10, 4)) {
+        v = sim_reg_merge(0, 0x10, off, size, val);
+        for (n = 0; n < NR_DMAC_CH; ++n) {
+            if (v & (1u << n))
+                dmac_trigger(n);
+        }
+    } else if (sim_reg_hit(off, size, 0x40, 1)) {
+        old = dmac_ch[ch].chctrla;
+        if (val & CHCTRLA_SWRST) {
+            if ((old & CHCTRLA_ENABLE) == 0)
+                dmac_ch_reset(ch);
+        } else {
+            dmac_ch[ch].chctrla = (uint8_t) val & ~CHCTRLA_SWRST;
+            if (!(old & CHCTRLA_ENABLE) && (val & CHCTRLA_ENABLE)) {
+                dmac_ch[ch].suspended = false;
+                dmac_ch[ch].status &= ~CHSTATUS_FERR;
+                dmac_fetch(ch, dmac_regs.DMAC_BASEADDR + ch * DESC_SIZE);
+            }
+        }
+    } else if (sim_reg_hit(off, size, 0x44, 4)) {
+        v = sim_reg_merge(dmac_ch[ch].chctrlb, 0x44, off, size, val);
+        switch (CHCTRLB_CMD(v)) {
+            case CMD_SUSPEND:
+                dmac_ch[ch].suspended = true;
+                dmac_ch[ch].intflag |= CHINT_SUSP;
+                break;
+            case CMD_RESUME:
+                dmac_ch[ch].suspended = false;
+                dmac_ch[ch].status &= ~CHSTATUS_FERR;
+                break;
+        }
+        dmac_ch[ch].chctrlb = v & ~(0x3u << 24);
+    } else if (sim_reg_hit(off, size, 0x4C, 1)) {
+        dmac_ch[ch].inten &= ~(uint8_t) val;
+    } else if (sim_reg_hit(off, size, 0x4D, 1)) {
+        dmac_ch[ch].inten |= (uint8_t) val & 0x7;
+    } else if (sim_reg_hit(off, size, 0x4E, 1)) {
+        dmac_ch[ch].intflag &= ~(uint8_t) val;
+    } else if (!sim_reg_hit(off, size, 0x20, 0x10) &&
+            !sim_reg_hit(off, size, 0x4F, 1)) {
+        sim_reg_store(&dmac_regs, off, size, val);
+    }
+    dmac_update_irq();
+    sim_activity();
+    sim_dmac_poll();
+}
+
+sim_periph_t sim_dmac = {
+    "DMAC", SIM_DMAC_BASE, sizeof (dmac_registers_t), &dmac_regs, dmac_read,
+    dmac_write, NULL
+};
+
+void sim_dmac_reset(void) {
+    unsigned int ch;
+
+    memset(&dmac_regs, 0, sizeof (dmac_regs));
+    for (ch = 0; ch < NR_DMAC_CH; ++ch)
+        dmac_ch_reset(ch);
+    dmac_update_irq();
+}
@@ -0,0 +1,226 @@
+/**
+ * @file  host/sim_internal.h
+ * @brief Host-side register-level simulator, shared internals
+ *
+ * NOTE: Only for the sim_*.c sources.
+ */
+
+#if !defined(EEE158_EX05_HOST_SIM_INTERNAL_H_)
+#define EEE158_EX05_HOST_SIM_INTERNAL_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "xc.h"
+#include "sim.h"
+
+/////////////////////////////////////////////////////////////////////////////
+
+/*
+ * Peripheral register blocks
+ *
+ * Each block has a backing copy (@c regs) with the same layout as the
+ * firmware's view. Accesses land in @c read and @c write, which get the
+ * offset within the block and the access width in bytes; a NULL hook
+ * means plain memory semantics on the backing copy.
+ */
+typedef struct sim_periph_type sim_periph_t;
+struct sim_periph_type {
+    const char *name;
+    uintptr_t base;
+    size_t size;
+    void *regs;
+    uint32_t (*read)(sim_periph_t *p, uint32_t off, unsigned int size);
+    void (*write)(sim_periph_t *p, uint32_t off, unsigned int size,
+            uint32_t val);
+    void *ctx;
+};
+
+/// Load from a backing copy
+static inline uint32_t sim_reg_load(const void *regs, uint32_t off,
+        unsigned int size) {
+    uint32_t v = 0;
+
+    memcpy(&v, (const uint8_t *) regs + off, size);
+    return v;
+}
+
+/// Store into a backing copy
+static inline void sim_reg_store(void *regs, uint32_t off, unsigned int size,
+        uint32_t val) {
+    memcpy((uint8_t *) regs + off, &val, size);
+}
+
+/// Whether an access [off, off+size) touches the register at [roff, roff+rsize)
+static inline bool sim_reg_hit(uint32_t off, unsigned int size, uint32_t roff,
+        unsigned int rsize) {
+    return off < roff + rsize && roff < off + size;
+}
+
+/*
+ * Merge a narrow write into a register, so models can act on full-width
+ * values. Bytes outside the access come from @p old.
+ */
+static inline uint32_t sim_reg_merge(uint32_t old, uint32_t roff,
+        uint32_t off, unsigned int size, uint32_t val) {
+    uint32_t mask = (size >= 4) ? 0xFFFFFFFFu : ((1u << (size * 8)) - 1);
+    int sh = (int) (off - roff) * 8;
+
+    if (sh < 0)
+        return (old & ~(mask >> -sh)) | (val >> -sh);
+    return (old & ~(mask << sh)) | ((val & mask) << sh);
+}
+
+/// Access a register block from within the simulator (DMAC, EVSYS)
+uint32_t sim_bus_read(uint32_t addr, unsigned int size);
+void sim_bus_write(uint32_t addr, unsigned int size, uint32_t val);
+
+/////////////////////////////////////////////////////////////////////////////
+
+/*
+ * Timed models
+ *
+ * @c next returns the time of the model's next autonomous state change (or
+ * SIM_TIME_NEVER); @c run processes everything due at or before @p now.
+ * Periodic models (timers) may keep running during deep fast-forwards;
+ * any other event ends one.
+ */
+typedef struct sim_model_type {
+    sim_time_t (*next)(void);
+    void (*run)(sim_time_t now);
+    bool periodic;
+} sim_model_t;
+
+/// Current virtual time
+extern sim_time_t sim_now;
+
+/// Time taken by @p n cycles of a clock running at @p hz
+static inline sim_time_t sim_cycles_to_time(uint64_t n, uint32_t hz) {
+    if (hz == 0)
+        return SIM_TIME_NEVER;
+    return (sim_time_t) (((unsigned __int128) n * SIM_TIME_S + hz - 1) / hz);
+}
+
+/// Whole cycles of a clock running at @p hz that fit in @p t
+static inline uint64_t sim_time_to_cycles(sim_time_t t, uint32_t hz) {
+    return (uint64_t) (((unsigned __int128) t * hz) / SIM_TIME_S);
+}
+
+/// Process every model event up to @p t, dispatching interrupts in between
+void sim_advance_to(sim_time_t t);
+
+/*
+ * Note that firmware-visible state changed in a way that matters for idle
+ * detection (I/O, configuration); register polling and timer bookkeeping
+ * do not count.
+ */
+void sim_activity(void);
+
+/////////////////////////////////////////////////////////////////////////////
+
+// Interrupts
+
+/// Drive a level-sensitive peripheral interrupt line
+void sim_irq_level(int irq, bool level);
+
+/// Pend an interrupt (edge, e.g. SysTick)
+void sim_irq_pend(int irq);
+
+/// Dispatch any pending interrupt that may preempt the current context
+void sim_irq_poll(void);
+
+/////////////////////////////////////////////////////////////////////////////
+
+// Clocks (sim_sys.c)
+
+/// Frequency of a GCLK generator, in Hz (0 if disabled)
+uint32_t sim_gclk_gen_hz(unsigned int gen);
+
+/// Frequency of a GCLK peripheral channel, in Hz (0 if disabled)
+uint32_t sim_gclk_pch_hz(unsigned int ch);
+
+/// CPU (and APB) clock, in Hz
+uint32_t sim_cpu_hz(void);
+
+// Pins and events (sim_port.c)
+
+/// Level of the output a peripheral drives onto a pin (-1 if none)
+typedef int (*sim_pin_src_t)(unsigned int index);
+
+/// Note that a peripheral output changed; re-evaluates the pins it drives
+void sim_pin_periph_changed(void);
+
+/// Whether a peripheral output currently reaches any pin through PMUX
+bool sim_pin_periph_routed(sim_pin_src_t src, unsigned int index);
+
+/// Level of a pin, as seen by peripheral inputs (EIC)
+int sim_pin_input(unsigned int group, unsigned int pin);
+
+/// Fire an event generator (EVSYS_ID_GEN_*)
+void sim_evsys_fire(unsigned int gen);
+
+/// Deliver an event to a TC (sim_tc.c)
+void sim_tc_event(void);
+
+/// Deliver an event to a PORT event input (sim_port.c)
+void sim_port_event(unsigned int n);
+
+// TC waveform output (sim_tc.c)
+int sim_tc_wo(unsigned int n);
+
+// DMA triggers (sim_dmac.c)
+
+/// Current level of a peripheral DMA trigger (sim_sercom.c)
+bool sim_sercom_dma_trig(unsigned int trig);
+
+/// Re-evaluate level-sensitive DMA triggers
+void sim_dmac_poll(void);
+
+/// Deliver a one-shot DMA trigger (e.g. a TC overflow)
+void sim_dmac_pulse(unsigned int trig);
+
+/// Whether any enabled channel listens to a trigger
+bool sim_dmac_trig_used(unsigned int trig);
+
+/// DMA trigger numbering (datasheet, DMAC "Peripheral Trigger Source")
+#define SIM_DMAC_TRIG_SERCOM_RX(n)	(0x04 + 2 * (n))
+#define SIM_DMAC_TRIG_SERCOM_TX(n)	(0x05 + 2 * (n))
+#define SIM_DMAC_TRIG_TC0_OVF		(0x12)
+#define SIM_DMAC_TRIG_TC0_MC(n)		(0x13 + (n))
+
+/////////////////////////////////////////////////////////////////////////////
+
+// Peripheral blocks and models, by file
+extern sim_periph_t sim_pm, sim_mclk, sim_oscctrl, sim_supc, sim_gclk,
+        sim_nvmctrl, sim_systick;
+extern sim_model_t sim_systick_model;
+
+extern sim_periph_t sim_sercom[4];
+extern sim_model_t sim_sercom_model;
+
+extern sim_periph_t sim_tc0;
+extern sim_model_t sim_tc_model;
+
+extern sim_periph_t sim_port, sim_eic, sim_evsys;
+extern sim_model_t sim_port_model, sim_eic_model;
+
+extern sim_periph_t sim_dmac;
+
+/// Reset hooks, called before the firmware starts
+void sim_sys_reset(void);
+void sim_sercom_reset(void);
+void sim_tc_reset(void);
+void sim_port_reset(void);
+void sim_dmac_reset(void);
+
+/// Print per-model statistics at exit
+void sim_sercom_report(void);
+void sim_port_report(void);
+
+/// Write a diagnostic and abort
+void sim_fatal(const char *fmt, ...)
+__attribute__((noreturn, format(printf, 1, 2)));
+
+#endif	// !defined(EEE158_EX05_HOST_SIM_INTERNAL_H_)
@@ -0,0 +1,717 @@
+/**
+ * @file  host/sim_port.c
+ * @brief Host-side register-level simulator, PORT, EIC and EVSYS models
+ *
+ * A pin's level comes from, in order: a peripheral output selected through
+ * PMUX (TC0 WO[n]), the PORT output driver, an external drive queued with
+ * sim_pin_drive(), a board pull-up, and the PINCFG pull. IN only samples
+ * pins whose input buffer is enabled.
+ *
+ * The EIC models the SENSE modes, the FILTEN majority filter (three
+ * GCLK_EIC clocks) and the debouncer (three or seven stable samples of the
+ * prescaled tick), PINSTATE, and event outputs. EVSYS routes generators to
+ * the PORT and TC0 event inputs without path latency.
+ *
+ * Not modelled: NMI, asynchronous-edge wakeups, EVSYS channel interrupts,
+ * and pins outside the board's EXTINT mapping.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "sim_internal.h"
+
+#define NR_PORT_GROUPS		2
+#define NR_EXTINT		16
+#define NR_EVSYS_CHANNELS	8
+#define NR_PORT_EV		4
+#define EIC_GCLK_ID		4
+
+// PINCFG
+#define PINCFG_PMUXEN		(1u << 0)
+#define PINCFG_INEN		(1u << 1)
+#define PINCFG_PULLEN		(1u << 2)
+
+/////////////////////////////////////////////////////////////////////////////
+
+// Board wiring
+
+// Peripheral outputs, by pin and PMUX function
+static const struct {
+    uint8_t group, pin, func;
+    sim_pin_src_t src;
+    unsigned int index;
+} port_periph_out[] = {
+    {0, 14, 0x4, sim_tc_wo, 0},		// PA14: TC0/WO[0]
+    {0, 15, 0x4, sim_tc_wo, 1},		// PA15: TC0/WO[1]
+};
+
+// EXTINT lines, by pin (PMUX function A)
+static const struct {
+    uint8_t group, pin, line;
+} port_extint[] = {
+    {0, 23, 2},		// PA23: on-board button
+};
+
+// External pull-ups on the board
+static const uint32_t port_board_pullup[NR_PORT_GROUPS] = {
+    1u << 23,		// PA23: on-board button
+    0
+};
+
+/////////////////////////////////////////////////////////////////////////////
+
+// PORT
+
+static port_registers_t port_regs;
+
+// External stimulus, kept sorted by time
+typedef struct {
+    sim_time_t at;
+    uint8_t group, pin;
+    int8_t level;
+} port_stim_t;
+
+static struct {
+    uint32_t ext_drive[NR_PORT_GROUPS];	// Pins driven from outside
+    uint32_t ext_level[NR_PORT_GROUPS];
+    uint32_t level[NR_PORT_GROUPS];	// Last evaluated pin levels
+    port_stim_t *stim;
+    size_t stim_len, stim_cap;
+    sim_pin_hook_t hook;
+    void *hook_arg;
+
+    struct {
+        uint64_t edges;
+        sim_time_t high_time, since;
+    } stats[NR_PORT_GROUPS][32];
+} port;
+
+static void eic_input_changed(unsigned int group, unsigned int pin);
+
+/*
+ * Evaluate one pin; @p driven tells whether the firmware drives it (these
+ * are the pins reported through the pin hook).
+ */
+static int port_pin_eval(unsigned int g, unsigned int p, bool *driven) {
+    const port_group_registers_t *gr = &port_regs.GROUP[g];
+    uint8_t cfg = gr->PORT_PINCFG[p];
+    unsigned int func = (gr->PORT_PMUX[p >> 1] >> ((p & 1) * 4)) & 0xF;
+    unsigned int i;
+    int level;
+
+    *driven = false;
+    if (cfg & PINCFG_PMUXEN) {
+        for (i = 0; i < sizeof (port_periph_out) / sizeof (port_periph_out[0]);
+                ++i) {
+            if (port_periph_out[i].group != g || port_periph_out[i].pin != p ||
+                    port_periph_out[i].func != func)
+                continue;
+            level = port_periph_out[i].src(port_periph_out[i].index);
+            if (level >= 0) {
+                *driven = true;
+                return level;
+            }
+        }
+    } else if (gr->PORT_DIR & (1u << p)) {
+        *driven = true;
+        return (gr->PORT_OUT >> p) & 1;
+    }
+
+    if (port.ext_drive[g] & (1u << p))
+        return (port.ext_level[g] >> p) & 1;
+    if (port_board_pullup[g] & (1u << p))
+        return 1;
+    if (cfg & PINCFG_PULLEN)
+        return (gr->PORT_OUT >> p) & 1;
+    return 0;
+}
+
+/*
+ * Re-evaluate every pin after a change; returns whether a firmware-driven
+ * pin changed level.
+ */
+static bool port_update(void) {
+    bool out_changed = false, driven;
+    unsigned int g, p;
+    uint32_t level, diff;
+
+    for (g = 0; g < NR_PORT_GROUPS; ++g) {
+        level = 0;
+        for (p = 0; p < 32; ++p) {
+            if (port_pin_eval(g, p, &driven))
+                level |= 1u << p;
+        }
+        diff = level ^ port.level[g];
+        port.level[g] = level;
+        for (p = 0; diff != 0; ++p, diff >>= 1) {
+            if ((diff & 1) == 0)
+                continue;
+            port_pin_eval(g, p, &driven);
+            eic_input_changed(g, p);
+            if (!driven)
+                continue;
+            out_changed = true;
+            ++port.stats[g][p].edges;
+            if ((level >> p) & 1)
+                port.stats[g][p].since = sim_now;
+            else
+                port.stats[g][p].high_time += sim_now - port.stats[g][p].since;
+            if (port.hook != NULL)
+                port.hook(port.hook_arg, g, p, (int) ((level >> p) & 1),
+                    sim_now);
+        }
+    }
+    return out_changed;
+}
+
+bool sim_pin_periph_routed(sim_pin_src_t src, unsigned int index) {
+    const port_group_registers_t *gr;
+    unsigned int i, p;
+
+    for (i = 0; i < sizeof (port_periph_out) / sizeof (port_periph_out[0]);
+            ++i) {
+        if (port_periph_out[i].src != src || port_periph_out[i].index != index)
+            continue;
+        gr = &port_regs.GROUP[port_periph_out[i].group];
+        p = port_periph_out[i].pin;
+        if ((gr->PORT_PINCFG[p] & PINCFG_PMUXEN) != 0 &&
+                ((gr->PORT_PMUX[p >> 1] >> ((p & 1) * 4)) & 0xF) ==
+                port_periph_out[i].func)
+            return true;
+    }
+    return false;
+}
+
+void sim_pin_periph_changed(void) {
+    port_update();
+}
+
+int sim_pin_input(unsigned int group, unsigned int pin) {
+    return (int) ((port.level[group] >> pin) & 1);
+}
+
+int sim_pin_level(unsigned int group, unsigned int pin) {
+    if (group >= NR_PORT_GROUPS || pin >= 32)
+        return -1;
+    return sim_pin_input(group, pin);
+}
+
+static uint32_t port_read(sim_periph_t *p, uint32_t off, unsigned int size) {
+    port_group_registers_t *gr;
+    unsigned int g;
+    uint32_t inen;
+    unsigned int i;
+
+    (void) p;
+    g = off / sizeof (port_group_registers_t);
+    if (g < NR_PORT_GROUPS) {
+        gr = &port_regs.GROUP[g];
+        inen = 0;
+        for (i = 0; i < 32; ++i) {
+            if (gr->PORT_PINCFG[i] & PINCFG_INEN)
+                inen |= 1u << i;
+        }
+        gr->PORT_IN = port.level[g] & inen;
+        gr->PORT_DIRCLR = gr->PORT_DIRSET = gr->PORT_DIRTGL = gr->PORT_DIR;
+        gr->PORT_OUTCLR = gr->PORT_OUTSET = gr->PORT_OUTTGL = gr->PORT_OUT;
+        gr->PORT_WRCONFIG = 0;
+    }
+    return sim_reg_load(&port_regs, off, size);
+}
+
+static void port_wrconfig(port_group_registers_t *gr, uint32_t v) {
+    uint32_t mask = (v & 0xFFFF) << ((v & (1u << 31)) ? 16 : 0);
+    uint8_t cfg = (uint8_t) (((v >> 16) & 0x07) | ((v >> 16) & 0x40));
+    unsigned int pin;
+    int sh;
+
+    for (pin = 0; pin < 32; ++pin) {
+        if ((mask & (1u << pin)) == 0)
+            continue;
+        if (v & (1u << 30))	// WRPINCFG
+            gr->PORT_PINCFG[pin] = cfg;
+        if (v & (1u << 28)) {	// WRPMUX
+            sh = (pin & 1) * 4;
+            gr->PORT_PMUX[pin >> 1] = (uint8_t) ((gr->PORT_PMUX[pin >> 1] &
+                    ~(0xF << sh)) | (((v >> 24) & 0xF) << sh));
+        }
+    }
+}
+
+static void port_write(sim_periph_t *p, uint32_t off, unsigned int size,
+        uint32_t val) {
+    port_registers_t before = port_regs;
+    port_group_registers_t *gr;
+    uint32_t roff, v;
+    unsigned int g;
+
+    (void) p;
+    g = off / sizeof (port_group_registers_t);
+    if (g >= NR_PORT_GROUPS)
+        return;
+    gr = &port_regs.GROUP[g];
+    roff = off % sizeof (port_group_registers_t);
+    v = sim_reg_merge(0, roff & ~3u, roff, size, val);
+
+    switch (roff & ~3u) {
+        case 0x00:
+            gr->PORT_DIR = sim_reg_merge(gr->PORT_DIR, 0x00, roff, size, val);
+            break;
+        case 0x04:
+            gr->PORT_DIR &= ~v;
+            break;
+        case 0x08:
+            gr->PORT_DIR |= v;
+            break;
+        case 0x0C:
+            gr->PORT_DIR ^= v;
+            break;
+        case 0x10:
+            gr->PORT_OUT = sim_reg_merge(gr->PORT_OUT, 0x10, roff, size, val);
+            break;
+        case 0x14:
+            gr->PORT_OUT &= ~v;
+            break;
+        case 0x18:
+            gr->PORT_OUT |= v;
+            break;
+        case 0x1C:
+            gr->PORT_OUT ^= v;
+            break;
+        case 0x20:	// IN is read-only
+            break;
+        case 0x28:
+            port_wrconfig(gr, v);
+            break;
+        default:	// CTRL, EVCTRL, PMUX, PINCFG
+            sim_reg_store(&port_regs, off, size, val);
+            break;
+    }
+    if (port_update() || memcmp(&before, &port_regs, sizeof (before)) != 0)
+        sim_activity();
+}
+
+sim_periph_t sim_port = {
+    "PORT", SIM_PORT_BASE, sizeof (port_registers_t), &port_regs, port_read,
+    port_write, NULL
+};
+
+// PORT event inputs: EVCTRL holds one PID/EVACT/PORTEI byte per input
+void sim_port_event(unsigned int n) {
+    port_group_registers_t *gr;
+    unsigned int g;
+    uint8_t ev;
+    uint32_t bit;
+
+    if (n >= NR_PORT_EV)
+        return;
+    for (g = 0; g < NR_PORT_GROUPS; ++g) {
+        gr = &port_regs.GROUP[g];
+        ev = (uint8_t) (gr->PORT_EVCTRL >> (8 * n));
+        if ((ev & 0x80) == 0)
+            continue;
+        bit = 1u << (ev & 0x1F);
+        switch ((ev >> 5) & 0x3) {
+            case 0:	// OUT: events are pulses, so drive high
+            case 1:	// SET
+                gr->PORT_OUT |= bit;
+                break;
+            case 2:	// CLR
+                gr->PORT_OUT &= ~bit;
+                break;
+            case 3:	// TGL
+                gr->PORT_OUT ^= bit;
+                break;
+        }
+    }
+    port_update();
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+// External stimulus
+
+void sim_pin_drive(unsigned int group, unsigned int pin, int level,
+        sim_time_t at) {
+    size_t i;
+
+    if (group >= NR_PORT_GROUPS || pin >= 32)
+        sim_fatal("sim_pin_drive(): no pin P%c%02u", 'A' + group, pin);
+    if (at < sim_now)
+        at = sim_now;
+    if (port.stim_len == port.stim_cap) {
+        port.stim_cap = port.stim_cap ? 2 * port.stim_cap : 16;
+        port.stim = realloc(port.stim, port.stim_cap * sizeof (*port.stim));
+        if (port.stim == NULL)
+            sim_fatal("out of memory");
+    }
+    for (i = port.stim_len; i > 0 && port.stim[i - 1].at > at; --i)
+        port.stim[i] = port.stim[i - 1];
+    port.stim[i].at = at;
+    port.stim[i].group = (uint8_t) group;
+    port.stim[i].pin = (uint8_t) pin;
+    port.stim[i].level = (int8_t) level;
+    ++port.stim_len;
+}
+
+void sim_set_pin_hook(sim_pin_hook_t fn, void *arg) {
+    port.hook = fn;
+    port.hook_arg = arg;
+}
+
+static sim_time_t port_next(void) {
+    return port.stim_len ? port.stim[0].at : SIM_TIME_NEVER;
+}
+
+static void port_run(sim_time_t now) {
+    port_stim_t s;
+    uint32_t bit;
+
+    while (port.stim_len != 0 && port.stim[0].at <= now) {
+        s = port.stim[0];
+        memmove(&port.stim[0], &port.stim[1],
+                --port.stim_len * sizeof (*port.stim));
+        bit = 1u << s.pin;
+        if (s.level < 0) {
+            port.ext_drive[s.group] &= ~bit;
+        } else {
+            port.ext_drive[s.group] |= bit;
+            if (s.level)
+                port.ext_level[s.group] |= bit;
+            else
+                port.ext_level[s.group] &= ~bit;
+        }
+        port_update();
+        sim_activity();
+    }
+}
+
+sim_model_t sim_port_model = {port_next, port_run, false};
+
+/////////////////////////////////////////////////////////////////////////////
+
+// EIC
+
+#define EIC_CTRLA_SWRST		(1u << 0)
+#define EIC_CTRLA_ENABLE	(1u << 1)
+#define EIC_CTRLA_CKSEL		(1u << 4)
+
+#define SENSE_NONE		0
+#define SENSE_RISE		1
+#define SENSE_FALL		2
+#define SENSE_BOTH		3
+#define SENSE_HIGH		4
+#define SENSE_LOW		5
+
+static eic_registers_t eic_regs;
+
+static struct {
+    uint32_t inten, intflag;
+    struct {
+        int raw;		// Level at the pin
+        int state;		// Level after filtering/debouncing
+        sim_time_t pending;	// When raw is accepted into state
+    } line[NR_EXTINT];
+} eic;
+
+static bool eic_enabled(void) {
+    return (eic_regs.EIC_CTRLA & EIC_CTRLA_ENABLE) != 0;
+}
+
+static uint32_t eic_config(unsigned int n) {
+    uint32_t cfg = (n < 8) ? eic_regs.EIC_CONFIG0 : eic_regs.EIC_CONFIG1;
+
+    return (cfg >> (4 * (n % 8))) & 0xF;
+}
+
+static uint32_t eic_clk_hz(void) {
+    if (eic_regs.EIC_CTRLA & EIC_CTRLA_CKSEL)
+        return 32768;	// CLK_ULP32K
+    return sim_gclk_pch_hz(EIC_GCLK_ID);
+}
+
+// Time a new level must hold before the EIC takes it
+static sim_time_t eic_filter_time(unsigned int n) {
+    uint32_t dp = eic_regs.EIC_DPRESCALER, hz;
+    unsigned int sh = (n < 8) ? 0 : 4, states;
+
+    if (eic_regs.EIC_DEBOUNCEN & (1u << n)) {
+        states = (dp & (1u << (sh + 3))) ? 7 : 3;
+        hz = (dp & (1u << 16)) ? 32768 : eic_clk_hz();
+        return sim_cycles_to_time((uint64_t) states <<
+                (((dp >> sh) & 0x7) + 1), hz);
+    }
+    if (eic_config(n) & 0x8)	// FILTEN
+        return sim_cycles_to_time(3, eic_clk_hz());
+    return 0;
+}
+
+static void eic_update_irq(void) {
+    uint32_t act = eic.intflag & eic.inten;
+    unsigned int n;
+
+    eic_regs.EIC_INTFLAG = eic.intflag;
+    eic_regs.EIC_INTENSET = eic_regs.EIC_INTENCLR = eic.inten;
+    for (n = 0; n < 4; ++n)
+        sim_irq_level(EIC_EXTINT_0_IRQn + n, (act & (1u << n)) != 0);
+    sim_irq_level(EIC_OTHER_IRQn, (act & ~0xFu) != 0);
+}
+
+static void eic_detect(unsigned int n, int old) {
+    unsigned int sense = eic_config(n) & 0x7;
+    int now = eic.line[n].state;
+    bool hit;
+
+    switch (sense) {
+        case SENSE_RISE:
+            hit = !old && now;
+            break;
+        case SENSE_FALL:
+            hit = old && !now;
+            break;
+        case SENSE_BOTH:
+            hit = old != now;
+            break;
+        case SENSE_HIGH:
+            hit = now;
+            break;
+        case SENSE_LOW:
+            hit = !now;
+            break;
+        default:
+            hit = false;
+            break;
+    }
+    if (!hit || (eic.intflag & (1u << n)) != 0)
+        return;
+    eic.intflag |= 1u << n;
+    if (eic_regs.EIC_EVCTRL & (1u << n))
+        sim_evsys_fire(EVSYS_ID_GEN_EIC_EXTINT_0 + n);
+}
+
+static void eic_accept(unsigned int n) {
+    int old = eic.line[n].state;
+
+    eic.line[n].pending = SIM_TIME_NEVER;
+    eic.line[n].state = eic.line[n].raw;
+    if (eic.line[n].state)
+        eic_regs.EIC_PINSTATE |= 1u << n;
+    else
+        eic_regs.EIC_PINSTATE &= ~(1u << n);
+    if (eic_enabled())
+        eic_detect(n, old);
+    eic_update_irq();
+}
+
+// Level sensing keeps re-raising a flag for as long as the level holds
+static void eic_levels(void) {
+    unsigned int n;
+
+    if (!eic_enabled())
+        return;
+    for (n = 0; n < NR_EXTINT; ++n) {
+        if ((eic_config(n) & 0x7) >= SENSE_HIGH)
+            eic_detect(n, eic.line[n].state);
+    }
+    eic_update_irq();
+}
+
+static void eic_input_changed(unsigned int group, unsigned int pin) {
+    const port_group_registers_t *gr = &port_regs.GROUP[group];
+    unsigned int i, n;
+    sim_time_t t;
+
+    for (i = 0; i < sizeof (port_extint) / sizeof (port_extint[0]); ++i) {
+        if (port_extint[i].group != group || port_extint[i].pin != pin)
+            continue;
+        // Only routed through PMUX function A
+        if ((gr->PORT_PINCFG[pin] & PINCFG_PMUXEN) == 0 ||
+                ((gr->PORT_PMUX[pin >> 1] >> ((pin & 1) * 4)) & 0xF) != 0)
+            continue;
+        n = port_extint[i].line;
+        eic.line[n].raw = sim_pin_input(group, pin);
+        t = eic_filter_time(n);
+        if (t == 0)
+            eic_accept(n);
+        else if (eic.line[n].raw != eic.line[n].state)
+            eic.line[n].pending = (t == SIM_TIME_NEVER) ? t : sim_now + t;
+        else
+            eic.line[n].pending = SIM_TIME_NEVER;	// A glitch, filtered
+    }
+}
+
+static sim_time_t eic_next(void) {
+    sim_time_t best = SIM_TIME_NEVER;
+    unsigned int n;
+
+    for (n = 0; n < NR_EXTINT; ++n) {
+        if (eic.line[n].pending < best)
+            best = eic.line[n].pending;
+    }
+    return best;
+}
+
+static void eic_run(sim_time_t now) {
+    unsigned int n;
+
+    for (n = 0; n < NR_EXTINT; ++n) {
+        if (eic.line[n].pending <= now)
+            eic_accept(n);
+    }
+}
+
+sim_model_t sim_eic_model = {eic_next, eic_run, false};
+
+static void eic_reset(void) {
+    unsigned int i, n;
+
+    memset(&eic_regs, 0, sizeof (eic_regs));
+    eic.inten = eic.intflag = 0;
+    for (n = 0; n < NR_EXTINT; ++n) {
+        eic.line[n].state = eic.line[n].raw = 0;
+        eic.line[n].pending = SIM_TIME_NEVER;
+    }
+    for (i = 0; i < sizeof (port_extint) / sizeof (port_extint[0]); ++i) {
+        n = port_extint[i].line;
+        eic.line[n].raw = eic.line[n].state =
+                sim_pin_input(port_extint[i].group, port_extint[i].pin);
+        if (eic.line[n].state)
+            eic_regs.EIC_PINSTATE |= 1u << n;
+    }
+    eic_update_irq();
+}
+
+static uint32_t eic_read(sim_periph_t *p, uint32_t off, unsigned int size) {
+    (void) p;
+    eic_regs.EIC_SYNCBUSY = 0;
+    return sim_reg_load(&eic_regs, off, size);
+}
+
+static void eic_write(sim_periph_t *p, uint32_t off, unsigned int size,
+        uint32_t val) {
+    eic_registers_t before = eic_regs;
+    uint32_t inten = eic.inten, v;
+    bool was_enabled = eic_enabled();
+
+    (void) p;
+    if (sim_reg_hit(off, size, 0x00, 1) && (val & EIC_CTRLA_SWRST)) {
+        eic_reset();
+        sim_activity();
+        return;
+    }
+    if (sim_reg_hit(off, size, 0x04, 4) || sim_reg_hit(off, size, 0x38, 4))
+        return;		// SYNCBUSY, PINSTATE: read-only
+
+    v = sim_reg_merge(0, off & ~3u, off, size, val);
+    if (sim_reg_hit(off, size, 0x0C, 4)) {
+        eic.inten &= ~v;
+    } else if (sim_reg_hit(off, size, 0x10, 4)) {
+        eic.inten |= v;
+    } else if (sim_reg_hit(off, size, 0x14, 4)) {
+        eic.intflag &= ~v;
+        eic_levels();
+    } else if (sim_reg_hit(off, size, 0x02, 2)) {
+        eic_regs.EIC_NMIFLAG &= ~(uint16_t) val;
+    } else {
+        sim_reg_store(&eic_regs, off, size, val);
+    }
+    if (!was_enabled && eic_enabled())
+        eic_levels();
+    eic_update_irq();
+
+    if (eic.inten != inten || memcmp(&before, &eic_regs, 0x14) != 0 ||
+            memcmp((const uint8_t *) &before + 0x18,
+                    (const uint8_t *) &eic_regs + 0x18,
+                    sizeof (before) - 0x18) != 0)
+        sim_activity();
+}
+
+sim_periph_t sim_eic = {
+    "EIC", SIM_EIC_BASE, sizeof (eic_registers_t), &eic_regs, eic_read,
+    eic_write, NULL
+};
+
+/////////////////////////////////////////////////////////////////////////////
+
+// EVSYS
+
+static evsys_registers_t evsys_regs;
+
+static void evsys_channel(unsigned int ch) {
+    unsigned int u;
+
+    for (u = 0; u < sizeof (evsys_regs.EVSYS_USER); ++u) {
+        if (evsys_regs.EVSYS_USER[u] != ch + 1)
+            continue;
+        if (u >= EVSYS_ID_USER_PORT_EV_0 &&
+                u < EVSYS_ID_USER_PORT_EV_0 + NR_PORT_EV)
+            sim_port_event(u - EVSYS_ID_USER_PORT_EV_0);
+        else if (u == EVSYS_ID_USER_TC0_EVU)
+            sim_tc_event();
+    }
+}
+
+void sim_evsys_fire(unsigned int gen) {
+    unsigned int ch;
+
+    for (ch = 0; ch < NR_EVSYS_CHANNELS; ++ch) {
+        if ((evsys_regs.EVSYS_CHANNEL[ch] & 0x7F) == gen && gen != 0)
+            evsys_channel(ch);
+    }
+}
+
+static void evsys_write(sim_periph_t *p, uint32_t off, unsigned int size,
+        uint32_t val) {
+    unsigned int ch;
+    uint32_t v;
+
+    (void) p;
+    if (sim_reg_hit(off, size, 0x00, 1) && (val & 0x01)) {
+        memset(&evsys_regs, 0, sizeof (evsys_regs));	// SWRST
+    } else if (sim_reg_hit(off, size, 0x04, 4)) {
+        v = sim_reg_merge(0, 0x04, off, size, val);
+        for (ch = 0; ch < NR_EVSYS_CHANNELS; ++ch) {
+            if (v & (1u << ch))
+                evsys_channel(ch);
+        }
+    } else {
+        sim_reg_store(&evsys_regs, off, size, val);
+    }
+    sim_activity();
+}
+
+sim_periph_t sim_evsys = {
+    "EVSYS", SIM_EVSYS_BASE, sizeof (evsys_registers_t), &evsys_regs, NULL,
+    evsys_write, NULL
+};
+
+/////////////////////////////////////////////////////////////////////////////
+
+void sim_port_reset(void) {
+    free(port.stim);
+    memset(&port, 0, sizeof (port));
+    memset(&port_regs, 0, sizeof (port_regs));
+    memset(&evsys_regs, 0, sizeof (evsys_regs));
+    port_update();
+    eic_reset();
+}
+
+void sim_port_report(void) {
+    unsigned int g, p;
+    sim_time_t high;
+
+    for (g = 0; g < NR_PORT_GROUPS; ++g) {
+        for (p = 0; p < 32; ++p) {
+            if (port.stats[g][p].edges == 0)
+                continue;
+            high = port.stats[g][p].high_time;
+            if ((port.level[g] >> p) & 1)
+                high += sim_now - port.stats[g][p].since;
+            fprintf(stderr, "sim: P%c%02u: %llu edges, high %.1f%% "
+                    "of the time\n", 'A' + g, p,
+                    (unsigned long long) port.stats[g][p].edges,
+                    sim_now ? 100.0 * (double) high / (double) sim_now : 0.0);
+        }
+    }
+}
@@ -0,0 +1,612 @@
+/**
+ * @file  host/sim_sercom.c
+ * @brief Host-side register-level simulator, SERCOM USART model
+ *
+ * Models the internally-clocked USART view: the optional FIFOs (four
+ * characters each way), DRE/TXC/RXC/RXS/ERROR/RXBRK, STATUS error bits, and
+ * character timing derived from BAUD, SAMPR, the frame format and the
+ * GCLK channel feeding the SERCOM. With RTS/CTS (TXPO = 2), the remote
+ * sender holds off while the receive FIFO is full; CTS is always asserted.
+ *
+ * The remote sender runs at the configured rate, or at one of its own
+ * (sim_uart_set_rx_baud()). In auto-baud frame formats, a break raises
+ * RXBRK and the character after it is consumed as the sync field: ISF if
+ * it is not 0x55, else BAUD is reprogrammed (16x fractional) to the
+ * sender's rate.
+ *
+ * Not modelled: SPI/I2C, synchronous mode, IrDA/LIN/ISO7816 specifics,
+ * collision detection, and baud-rate mismatch (characters sent at another
+ * rate still arrive intact).
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "sim_internal.h"
+
+#define NR_SERCOM		4
+#define SERCOM_FIFO_DEPTH	4
+#define SERCOM_SYNC_CLOCKS	3	// GCLK + APB clocks per synchronization
+
+// CTRLA
+#define CTRLA_SWRST		(1u << 0)
+#define CTRLA_ENABLE		(1u << 1)
+#define CTRLA_SAMPR(x)		(((x) >> 13) & 0x7)
+#define CTRLA_TXPO(x)		(((x) >> 16) & 0x3)
+#define CTRLA_FORM(x)		(((x) >> 24) & 0xF)
+
+// CTRLB
+#define CTRLB_CHSIZE(x)		((x) & 0x7)
+#define CTRLB_SBMODE		(1u << 6)
+#define CTRLB_SFDE		(1u << 9)
+#define CTRLB_TXEN		(1u << 16)
+#define CTRLB_RXEN		(1u << 17)
+#define CTRLB_FIFOCLR_TX	(1u << 22)
+#define CTRLB_FIFOCLR_RX	(1u << 23)
+
+// CTRLC
+#define CTRLC_TXTRHOLD(x)	(((x) >> 24) & 0x3)
+#define CTRLC_FIFOEN		(1u << 27)
+#define CTRLC_RXTRHOLD(x)	(((x) >> 28) & 0x3)
+
+// INTFLAG
+#define INT_DRE			(1u << 0)
+#define INT_TXC			(1u << 1)
+#define INT_RXC			(1u << 2)
+#define INT_RXS			(1u << 3)
+#define INT_RXBRK		(1u << 5)
+#define INT_ERROR		(1u << 7)
+#define INT_STICKY		(INT_TXC | INT_RXS | (1u << 4) | INT_RXBRK | INT_ERROR)
+
+// STATUS
+#define STATUS_PERR		(1u << 0)
+#define STATUS_FERR		(1u << 1)
+#define STATUS_BUFOVF		(1u << 2)
+#define STATUS_CTS		(1u << 3)
+#define STATUS_ISF		(1u << 4)
+#define STATUS_W1C		(0x00B7)
+
+typedef struct {
+    uint8_t c;
+    uint8_t flags;
+    sim_time_t at;
+} sercom_rx_in_t;
+
+typedef struct {
+    sercom_usart_int_registers_t regs;
+    unsigned int n;
+
+    // Latched when enabled
+    bool enabled;
+    sim_time_t char_time;
+    unsigned int char_bits;
+    double baud;
+
+    // Transmitter
+    uint8_t txq[SERCOM_FIFO_DEPTH];
+    unsigned int tx_head, tx_count;
+    bool shifting;
+    uint8_t shift_c;
+    sim_time_t shift_end;
+
+    // Receiver
+    struct {
+        uint8_t c;
+        uint8_t status;
+    } rxq[SERCOM_FIFO_DEPTH];
+    unsigned int rx_head, rx_count;
+    bool expect_sync;
+
+    // Remote sender
+    sercom_rx_in_t *in;
+    size_t in_head, in_len, in_cap;
+    double in_baud;		// Zero to follow the configured rate
+    bool line_busy;
+    sim_time_t line_end;
+
+    uint8_t inten, intflag;
+    sim_time_t sync_until;
+    uint32_t sync_bits;
+
+    sim_uart_tx_hook_t tx_hook;
+    void *tx_arg;
+
+    struct {
+        uint64_t tx, rx, overflow, dropped;
+    } stats;
+} sercom_t;
+
+static sercom_t sercoms[NR_SERCOM];
+
+/////////////////////////////////////////////////////////////////////////////
+
+static bool sercom_fifo(const sercom_t *s) {
+    return (s->regs.SERCOM_CTRLC & CTRLC_FIFOEN) != 0;
+}
+
+static unsigned int sercom_tx_depth(const sercom_t *s) {
+    return sercom_fifo(s) ? SERCOM_FIFO_DEPTH : 1;
+}
+
+static unsigned int sercom_rx_depth(const sercom_t *s) {
+    return sercom_fifo(s) ? SERCOM_FIFO_DEPTH : 2;
+}
+
+static bool sercom_autobaud(const sercom_t *s) {
+    unsigned int form = CTRLA_FORM(s->regs.SERCOM_CTRLA);
+
+    return form == 4 || form == 5;
+}
+
+static bool sercom_rx_on(const sercom_t *s) {
+    return s->enabled && (s->regs.SERCOM_CTRLB & CTRLB_RXEN) != 0;
+}
+
+static bool sercom_tx_on(const sercom_t *s) {
+    return s->enabled && (s->regs.SERCOM_CTRLB & CTRLB_TXEN) != 0;
+}
+
+// Line rate and character time, from the current configuration
+static void sercom_latch_timing(sercom_t *s) {
+    static const unsigned int sampr_s[8] = {16, 16, 8, 8, 3, 3, 3, 3};
+    uint32_t ctrla = s->regs.SERCOM_CTRLA, ctrlb = s->regs.SERCOM_CTRLB;
+    uint32_t baud = s->regs.SERCOM_BAUD;
+    double ref = sim_gclk_pch_hz(17 + s->n);
+    unsigned int sampr = CTRLA_SAMPR(ctrla), form = CTRLA_FORM(ctrla);
+    unsigned int bits, chsize = CTRLB_CHSIZE(ctrlb);
+
+    if (sampr == 1 || sampr == 3 || sampr == 5) {
+        s->baud = ref / (sampr_s[sampr] *
+                ((baud & 0x1FFF) + (double) (baud >> 13) / 8.0));
+    } else {
+        s->baud = ref / sampr_s[sampr] * (1.0 - (double) baud / 65536.0);
+    }
+
+    bits = 1 + ((chsize == 0) ? 8 : (chsize == 1) ? 9 : chsize);
+    bits += (form == 1 || form == 5) ? 1 : 0;
+    bits += (ctrlb & CTRLB_SBMODE) ? 2 : 1;
+    s->char_bits = bits;
+    s->char_time = (s->baud > 0) ?
+            (sim_time_t) ((double) bits * SIM_TIME_S / s->baud) :
+            SIM_TIME_NEVER;
+}
+
+static void sercom_sync(sercom_t *s, uint32_t bits) {
+    uint32_t hz = sim_gclk_pch_hz(17 + s->n);
+
+    s->sync_bits |= bits;
+    s->sync_until = sim_now + sim_cycles_to_time(SERCOM_SYNC_CLOCKS,
+            hz ? hz : sim_cpu_hz()) + sim_cycles_to_time(SERCOM_SYNC_CLOCKS,
+            sim_cpu_hz());
+}
+
+static void sercom_load_status(sercom_t *s) {
+    if (s->rx_count > 0)
+        s->regs.SERCOM_STATUS |= s->rxq[s->rx_head].status;
+}
+
+// Recompute derived flags, interrupt lines and DMA triggers
+static void sercom_update(sercom_t *s) {
+    uint32_t ctrlc = s->regs.SERCOM_CTRLC;
+    unsigned int tx_room = sercom_tx_depth(s) - s->tx_count;
+    unsigned int tx_thr = sercom_fifo(s) ? CTRLC_TXTRHOLD(ctrlc) + 1 : 1;
+    unsigned int rx_thr = sercom_fifo(s) ? CTRLC_RXTRHOLD(ctrlc) + 1 : 1;
+    int irq = SERCOM0_0_IRQn + 4 * (int) s->n;
+    uint8_t flags = s->intflag & INT_STICKY;
+
+    if (s->enabled && tx_room >= tx_thr)
+        flags |= INT_DRE;
+    if (s->rx_count >= rx_thr)
+        flags |= INT_RXC;
+    s->intflag = flags;
+    s->regs.SERCOM_INTFLAG = flags;
+    s->regs.SERCOM_INTENSET = s->regs.SERCOM_INTENCLR = s->inten;
+    s->regs.SERCOM_FIFOSPACE = (uint16_t) (tx_room | (s->rx_count << 8));
+
+    flags &= s->inten;
+    sim_irq_level(irq + 0, (flags & INT_DRE) != 0);
+    sim_irq_level(irq + 1, (flags & INT_TXC) != 0);
+    sim_irq_level(irq + 2, (flags & INT_RXC) != 0);
+    sim_irq_level(irq + 3, (flags & ~(INT_DRE | INT_TXC | INT_RXC)) != 0);
+    sim_dmac_poll();
+}
+
+static void sercom_tx_start(sercom_t *s) {
+    if (s->shifting || s->tx_count == 0 || !sercom_tx_on(s))
+        return;
+    s->shift_c = s->txq[s->tx_head];
+    s->tx_head = (s->tx_head + 1) % SERCOM_FIFO_DEPTH;
+    --s->tx_count;
+    s->shifting = true;
+    s->shift_end = sim_now + s->char_time;
+}
+
+static void sercom_reset_one(sercom_t *s) {
+    unsigned int n = s->n;
+    sercom_rx_in_t *in = s->in;
+    size_t in_head = s->in_head, in_len = s->in_len, in_cap = s->in_cap;
+    double in_baud = s->in_baud;
+    sim_uart_tx_hook_t hook = s->tx_hook;
+    void *arg = s->tx_arg;
+    __typeof__(s->stats) stats = s->stats;
+
+    // Keep the remote side (queued input, hooks) across a SWRST.
+    memset(s, 0, sizeof (*s));
+    s->n = n;
+    s->in = in;
+    s->in_head = in_head;
+    s->in_len = in_len;
+    s->in_cap = in_cap;
+    s->in_baud = in_baud;
+    s->tx_hook = hook;
+    s->tx_arg = arg;
+    s->stats = stats;
+    s->char_time = SIM_TIME_NEVER;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+// Register access
+
+static uint32_t sercom_read(sim_periph_t *p, uint32_t off, unsigned int size) {
+    sercom_t *s = p->ctx;
+    uint32_t v;
+
+    if (sim_now >= s->sync_until)
+        s->sync_bits = 0;
+    s->regs.SERCOM_SYNCBUSY = s->sync_bits;
+    s->regs.SERCOM_STATUS |= STATUS_CTS;
+    sercom_update(s);
+
+    if (sim_reg_hit(off, size, 0x28, 4)) {
+        // DATA: pop the receive FIFO
+        v = 0;
+        if (s->rx_count > 0) {
+            v = s->rxq[s->rx_head].c;
+            s->rx_head = (s->rx_head + 1) % SERCOM_FIFO_DEPTH;
+            --s->rx_count;
+            sercom_load_status(s);
+            sercom_update(s);
+            sim_activity();
+        }
+        return v;
+    }
+    return sim_reg_load(&s->regs, off, size);
+}
+
+static void sercom_write(sim_periph_t *p, uint32_t off, unsigned int size,
+        uint32_t val) {
+    sercom_t *s = p->ctx;
+    sercom_usart_int_registers_t before = s->regs;
+    uint8_t inten = s->inten, intflag = s->intflag;
+    uint32_t old, v;
+
+    if (sim_reg_hit(off, size, 0x00, 4)) {
+        old = s->regs.SERCOM_CTRLA;
+        v = sim_reg_merge(old, 0x00, off, size, val);
+        if (v & CTRLA_SWRST) {
+            sercom_reset_one(s);
+            sercom_sync(s, CTRLA_SWRST);
+            sercom_update(s);
+            sim_activity();
+            return;
+        }
+        // Enable-protected, save for ENABLE itself
+        if (old & CTRLA_ENABLE)
+            v = (old & ~CTRLA_ENABLE) | (v & CTRLA_ENABLE);
+        s->regs.SERCOM_CTRLA = v;
+        if ((old ^ v) & CTRLA_ENABLE) {
+            sercom_sync(s, CTRLA_ENABLE);
+            s->enabled = (v & CTRLA_ENABLE) != 0;
+            if (s->enabled) {
+                sercom_latch_timing(s);
+                sercom_tx_start(s);
+            } else {
+                s->shifting = false;
+            }
+        }
+    } else if (sim_reg_hit(off, size, 0x04, 4)) {
+        old = s->regs.SERCOM_CTRLB;
+        v = sim_reg_merge(old, 0x04, off, size, val);
+        if (v & CTRLB_FIFOCLR_TX) {
+            s->tx_count = 0;
+            s->tx_head = 0;
+        }
+        if (v & CTRLB_FIFOCLR_RX) {
+            s->rx_count = 0;
+            s->rx_head = 0;
+        }
+        v &= ~(CTRLB_FIFOCLR_TX | CTRLB_FIFOCLR_RX);
+        if (s->enabled) {
+            v = (old & ~(CTRLB_TXEN | CTRLB_RXEN)) |
+                    (v & (CTRLB_TXEN | CTRLB_RXEN));
+            sercom_sync(s, 1u << 2);
+        }
+        s->regs.SERCOM_CTRLB = v;
+        sercom_tx_start(s);
+    } else if (sim_reg_hit(off, size, 0x08, 8)) {
+        // CTRLC, BAUD, RXPL
+        if (!s->enabled)
+            sim_reg_store(&s->regs, off, size, val);
+    } else if (sim_reg_hit(off, size, 0x14, 1)) {
+        s->inten &= ~(uint8_t) val;
+    } else if (sim_reg_hit(off, size, 0x16, 1)) {
+        s->inten |= (uint8_t) val;
+    } else if (sim_reg_hit(off, size, 0x18, 1)) {
+        s->intflag &= ~((uint8_t) val & INT_STICKY);
+    } else if (sim_reg_hit(off, size, 0x1A, 2)) {
+        s->regs.SERCOM_STATUS &= ~(sim_reg_merge(0, 0x1A, off, size, val) &
+                STATUS_W1C);
+    } else if (sim_reg_hit(off, size, 0x28, 4)) {
+        // DATA: push into the transmit FIFO
+        if (s->tx_count < sercom_tx_depth(s)) {
+            s->txq[(s->tx_head + s->tx_count) % SERCOM_FIFO_DEPTH] =
+                    (uint8_t) val;
+            ++s->tx_count;
+        }
+        s->intflag &= ~INT_TXC;
+        sercom_tx_start(s);
+        sim_activity();
+    } else if (sim_reg_hit(off, size, 0x30, 1) ||
+            sim_reg_hit(off, size, 0x36, 2)) {
+        sim_reg_store(&s->regs, off, size, val);
+    }
+    sercom_update(s);
+
+    // Rewriting a register with what it already holds is just polling.
+    if (s->inten != inten || s->intflag != intflag ||
+            memcmp(&s->regs, &before, sizeof (before)) != 0)
+        sim_activity();
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+// Timed behaviour
+
+static bool sercom_rts(const sercom_t *s) {
+    if (CTRLA_TXPO(s->regs.SERCOM_CTRLA) != 2)
+        return true;
+    return s->rx_count < sercom_rx_depth(s);
+}
+
+// Time one character from the remote sender takes on the line
+static sim_time_t sercom_in_char_time(const sercom_t *s) {
+    if (s->in_baud <= 0 || s->char_time == SIM_TIME_NEVER)
+        return s->char_time;
+    return (sim_time_t) ((double) s->char_bits * SIM_TIME_S / s->in_baud);
+}
+
+// Retune BAUD to the sender's rate, as measured from a valid sync field
+static void sercom_autobaud_sync(sercom_t *s) {
+    double ref = sim_gclk_pch_hz(17 + s->n);
+    uint32_t eighths;
+
+    if (s->in_baud <= 0)
+        return;
+    eighths = (uint32_t) (8.0 * ref / (16.0 * s->in_baud) + 0.5);
+    if (eighths < 8 || (eighths >> 3) > 0x1FFF)
+        return;
+    s->regs.SERCOM_BAUD = (uint16_t) ((eighths >> 3) | ((eighths & 0x7) << 13));
+    sercom_latch_timing(s);
+}
+
+static sim_time_t sercom_next_one(const sercom_t *s) {
+    sim_time_t t = SIM_TIME_NEVER, start;
+
+    if (s->shifting)
+        t = s->shift_end;
+    if (s->line_busy) {
+        if (s->line_end < t)
+            t = s->line_end;
+    } else if (s->in_head < s->in_len && sercom_rts(s)) {
+        start = s->in[s->in_head].at;
+        if (start < s->line_end)
+            start = s->line_end;
+        if (start < t)
+            t = start;
+    }
+    return t;
+}
+
+static sim_time_t sercom_next(void) {
+    sim_time_t best = SIM_TIME_NEVER, t;
+    unsigned int n;
+
+    for (n = 0; n < NR_SERCOM; ++n) {
+        t = sercom_next_one(&sercoms[n]);
+        if (t < best)
+            best = t;
+    }
+    return best;
+}
+
+static void sercom_rx_push(sercom_t *s, const sercom_rx_in_t *in) {
+    uint8_t status = 0;
+    unsigned int slot;
+
+    if (!sercom_rx_on(s)) {
+        ++s->stats.dropped;
+        return;
+    }
+    if (in->flags & SIM_UART_RX_BREAK) {
+        if (sercom_autobaud(s)) {
+            s->intflag |= INT_RXBRK;
+            s->expect_sync = true;
+            return;
+        }
+        status |= STATUS_FERR;
+    } else if (s->expect_sync) {
+        s->expect_sync = false;
+        if (in->c != 0x55) {
+            s->regs.SERCOM_STATUS |= STATUS_ISF;
+            s->intflag |= INT_ERROR;
+        } else {
+            sercom_autobaud_sync(s);
+        }
+        return;
+    }
+    if (in->flags & SIM_UART_RX_FERR)
+        status |= STATUS_FERR;
+    if (in->flags & SIM_UART_RX_PERR)
+        status |= STATUS_PERR;
+
+    if (s->rx_count >= sercom_rx_depth(s)) {
+        s->regs.SERCOM_STATUS |= STATUS_BUFOVF;
+        s->intflag |= INT_ERROR;
+        ++s->stats.overflow;
+        return;
+    }
+    slot = (s->rx_head + s->rx_count) % SERCOM_FIFO_DEPTH;
+    s->rxq[slot].c = (in->flags & SIM_UART_RX_BREAK) ? 0x00 : in->c;
+    s->rxq[slot].status = status;
+    if (s->rx_count++ == 0)
+        sercom_load_status(s);
+    if (status != 0)
+        s->intflag |= INT_ERROR;
+    ++s->stats.rx;
+}
+
+static void sercom_run_one(sercom_t *s, sim_time_t now) {
+    sim_time_t t;
+    bool changed = false;
+
+    for (;;) {
+        t = sercom_next_one(s);
+        if (t > now)
+            break;
+        changed = true;
+
+        if (s->shifting && s->shift_end == t) {
+            s->shifting = false;
+            ++s->stats.tx;
+            if (s->tx_hook != NULL)
+                s->tx_hook(s->tx_arg, s->n, s->shift_c, t);
+            sercom_tx_start(s);
+            if (!s->shifting)
+                s->intflag |= INT_TXC;
+            sercom_update(s);
+        } else if (s->line_busy) {
+            s->line_busy = false;
+            sercom_rx_push(s, &s->in[s->in_head++]);
+            sercom_update(s);
+        } else {
+            // Start the next queued character on the line.
+            if (s->enabled && s->char_time != SIM_TIME_NEVER) {
+                s->line_busy = true;
+                s->line_end = t + sercom_in_char_time(s) *
+                        ((s->in[s->in_head].flags & SIM_UART_RX_BREAK) ? 2 : 1);
+                if (sercom_rx_on(s) &&
+                        (s->regs.SERCOM_CTRLB & CTRLB_SFDE) != 0) {
+                    s->intflag |= INT_RXS;
+                    sercom_update(s);
+                }
+            } else {
+                ++s->stats.dropped;
+                ++s->in_head;
+            }
+        }
+    }
+    if (changed)
+        sim_activity();
+}
+
+static void sercom_run(sim_time_t now) {
+    unsigned int n;
+
+    for (n = 0; n < NR_SERCOM; ++n)
+        sercom_run_one(&sercoms[n], now);
+}
+
+sim_model_t sim_sercom_model = {sercom_next, sercom_run, false};
+
+bool sim_sercom_dma_trig(unsigned int trig) {
+    sercom_t *s;
+
+    if (trig < SIM_DMAC_TRIG_SERCOM_RX(0) ||
+            trig > SIM_DMAC_TRIG_SERCOM_TX(NR_SERCOM - 1))
+        return false;
+    s = &sercoms[(trig - SIM_DMAC_TRIG_SERCOM_RX(0)) / 2];
+    if ((trig - SIM_DMAC_TRIG_SERCOM_RX(0)) & 1)
+        return (s->intflag & INT_DRE) != 0;
+    return (s->intflag & INT_RXC) != 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+// Public interface
+
+sim_periph_t sim_sercom[NR_SERCOM] = {
+#define SERCOM_PERIPH(n) \
+    {"SERCOM" #n, SIM_SERCOM_BASE(n), sizeof (sercom_usart_int_registers_t), \
+        &sercoms[n].regs, sercom_read, sercom_write, &sercoms[n]}
+    SERCOM_PERIPH(0), SERCOM_PERIPH(1), SERCOM_PERIPH(2), SERCOM_PERIPH(3),
+#undef SERCOM_PERIPH
+};
+
+void sim_uart_rx_char(unsigned int sercom, uint8_t c, unsigned int flags,
+        sim_time_t at) {
+    sercom_t *s = &sercoms[sercom];
+
+    if (s->in_len == s->in_cap) {
+        s->in_cap = s->in_cap ? 2 * s->in_cap : 256;
+        s->in = realloc(s->in, s->in_cap * sizeof (*s->in));
+        if (s->in == NULL)
+            sim_fatal("out of memory");
+    }
+    s->in[s->in_len].c = c;
+    s->in[s->in_len].flags = (uint8_t) flags;
+    s->in[s->in_len].at = at;
+    ++s->in_len;
+}
+
+void sim_uart_rx(unsigned int sercom, const void *buf, size_t len,
+        sim_time_t at) {
+    const uint8_t *p = buf;
+
+    while (len-- > 0)
+        sim_uart_rx_char(sercom, *p++, 0, at);
+}
+
+size_t sim_uart_rx_pending(unsigned int sercom) {
+    return sercoms[sercom].in_len - sercoms[sercom].in_head;
+}
+
+void sim_uart_set_tx_hook(unsigned int sercom, sim_uart_tx_hook_t fn,
+        void *arg) {
+    sercoms[sercom].tx_hook = fn;
+    sercoms[sercom].tx_arg = arg;
+}
+
+void sim_uart_set_rx_baud(unsigned int sercom, double baud) {
+    sercoms[sercom].in_baud = baud;
+}
+
+double sim_uart_baud(unsigned int sercom) {
+    return sercoms[sercom].enabled ? sercoms[sercom].baud : 0.0;
+}
+
+void sim_sercom_reset(void) {
+    unsigned int n;
+
+    for (n = 0; n < NR_SERCOM; ++n) {
+        sercoms[n].n = n;
+        sercom_reset_one(&sercoms[n]);
+    }
+}
+
+void sim_sercom_report(void) {
+    unsigned int n;
+    const sercom_t *s;
+
+    for (n = 0; n < NR_SERCOM; ++n) {
+        s = &sercoms[n];
+        if (s->stats.tx == 0 && s->stats.rx == 0 && s->in_len == 0)
+            continue;
+        fprintf(stderr, "sim: SERCOM%u at %.0f bit/s: %llu sent, "
+                "%llu received, %llu overflowed, %llu dropped\n",
+                n, s->baud, (unsigned long long) s->stats.tx,
+                (unsigned long long) s->stats.rx,
+                (unsigned long long) s->stats.overflow,
+                (unsigned long long) s->stats.dropped);
+    }
+}
@@ -0,0 +1,327 @@
+/**
+ * @file  host/sim_sys.c
+ * @brief Host-side register-level simulator, system peripherals
+ *
+ * PM, MCLK, OSCCTRL, SUPC and NVMCTRL are modelled just far enough for
+ * raise_perf_level() to get through: ready flags come up immediately. GCLK
+ * tracks generator frequencies (with SYNCBUSY latency), and SysTick counts
+ * the CPU clock.
+ *
+ * NOTE: Peripherals latch their clock frequency when they are configured;
+ *       changing a generator under a running peripheral is not modelled.
+ */
+
+#include "sim_internal.h"
+
+/////////////////////////////////////////////////////////////////////////////
+
+// PM: performance-level switches complete at once.
+
+static pm_registers_t pm_regs;
+
+static void pm_write(sim_periph_t *p, uint32_t off, unsigned int size,
+        uint32_t val) {
+    (void) p;
+    if (sim_reg_hit(off, size, 0x06, 1)) {
+        // INTFLAG: write-one-to-clear
+        pm_regs.PM_INTFLAG &= ~sim_reg_merge(0, 0x06, off, size, val);
+        return;
+    }
+    sim_reg_store(&pm_regs, off, size, val);
+    if (sim_reg_hit(off, size, 0x02, 1))
+        pm_regs.PM_INTFLAG |= 0x01;	// PLRDY
+}
+
+sim_periph_t sim_pm = {
+    "PM", SIM_PM_BASE, sizeof (pm_registers_t), &pm_regs, NULL, pm_write,
+    NULL
+};
+
+// MCLK, NVMCTRL: plain registers
+
+static mclk_registers_t mclk_regs;
+static nvmctrl_registers_t nvmctrl_regs;
+
+sim_periph_t sim_mclk = {
+    "MCLK", SIM_MCLK_BASE, sizeof (mclk_registers_t), &mclk_regs, NULL, NULL,
+    NULL
+};
+
+sim_periph_t sim_nvmctrl = {
+    "NVMCTRL", SIM_NVMCTRL_BASE, sizeof (nvmctrl_registers_t),
+    &nvmctrl_regs, NULL, NULL, NULL
+};
+
+// OSCCTRL, SUPC: status registers read as always-ready
+
+static oscctrl_registers_t oscctrl_regs;
+static supc_registers_t supc_regs;
+
+#define OSCCTRL_STATUS_READY	((1u << 4) | (1u << 24))	// OSC16MRDY, DFLLRDY
+#define SUPC_STATUS_READY	((1u << 0) | (1u << 2) | (1u << 18))
+
+static void oscctrl_write(sim_periph_t *p, uint32_t off, unsigned int size,
+        uint32_t val) {
+    (void) p;
+    if (!sim_reg_hit(off, size, 0x10, 4))
+        sim_reg_store(&oscctrl_regs, off, size, val);
+}
+
+static void supc_write(sim_periph_t *p, uint32_t off, unsigned int size,
+        uint32_t val) {
+    (void) p;
+    if (!sim_reg_hit(off, size, 0x0C, 4))
+        sim_reg_store(&supc_regs, off, size, val);
+}
+
+sim_periph_t sim_oscctrl = {
+    "OSCCTRL", SIM_OSCCTRL_BASE, sizeof (oscctrl_registers_t), &oscctrl_regs,
+    NULL, oscctrl_write, NULL
+};
+
+sim_periph_t sim_supc = {
+    "SUPC", SIM_SUPC_BASE, sizeof (supc_registers_t), &supc_regs, NULL,
+    supc_write, NULL
+};
+
+/////////////////////////////////////////////////////////////////////////////
+
+// GCLK
+
+#define NR_GCLK_GEN		5
+#define GCLK_SYNC_CYCLES	4	// Source clocks until SYNCBUSY drops
+
+static gclk_registers_t gclk_regs;
+static sim_time_t gclk_sync_until[NR_GCLK_GEN];
+
+static uint32_t gclk_src_hz(unsigned int src) {
+    switch (src) {
+        case 0x03:	// OSCULP32K
+            return 32768;
+        case 0x05:	// OSC16M, FSEL selects 4/8/12/16 MHz
+            return 4000000u * (((oscctrl_regs.OSCCTRL_OSC16MCTRL >> 2) & 0x3) + 1);
+        case 0x07:	// DFLL48M
+            return (oscctrl_regs.OSCCTRL_DFLLCTRL & 0x0002) ? 48000000u : 0;
+        default:
+            return 0;
+    }
+}
+
+uint32_t sim_gclk_gen_hz(unsigned int gen) {
+    uint32_t g, div;
+
+    if (gen >= NR_GCLK_GEN)
+        return 0;
+    g = gclk_regs.GCLK_GENCTRL[gen];
+    if ((g & (1u << 8)) == 0)
+        return 0;
+    div = g >> 16;
+    if (g & (1u << 12))
+        div = 1u << (div + 1);	// DIVSEL
+    else if (div == 0)
+        div = 1;
+    return gclk_src_hz(g & 0x1F) / div;
+}
+
+uint32_t sim_gclk_pch_hz(unsigned int ch) {
+    uint32_t pch;
+
+    if (ch >= 32)
+        return 0;
+    pch = gclk_regs.GCLK_PCHCTRL[ch];
+    if ((pch & (1u << 6)) == 0)
+        return 0;
+    return sim_gclk_gen_hz(pch & 0xF);
+}
+
+uint32_t sim_cpu_hz(void) {
+    uint32_t hz = sim_gclk_gen_hz(0);
+    uint8_t div = mclk_regs.MCLK_CPUDIV;
+
+    if (hz == 0)
+        sim_fatal("GCLK_GEN0 stopped; the CPU has no clock");
+    return hz / (div != 0 ? div : 1);
+}
+
+static uint32_t gclk_read(sim_periph_t *p, uint32_t off, unsigned int size) {
+    uint32_t busy = 0;
+    unsigned int n;
+
+    (void) p;
+    if (sim_reg_hit(off, size, 0x04, 4)) {
+        for (n = 0; n < NR_GCLK_GEN; ++n) {
+            if (sim_now < gclk_sync_until[n])
+                busy |= 1u << (n + 2);
+        }
+        gclk_regs.GCLK_SYNCBUSY = busy;
+    }
+    return sim_reg_load(&gclk_regs, off, size);
+}
+
+static void gclk_write(sim_periph_t *p, uint32_t off, unsigned int size,
+        uint32_t val) {
+    unsigned int n;
+    uint32_t hz;
+
+    (void) p;
+    if (sim_reg_hit(off, size, 0x04, 4))
+        return;
+    sim_reg_store(&gclk_regs, off, size, val);
+    gclk_regs.GCLK_CTRLA &= ~0x01;	// SWRST is not modelled
+    for (n = 0; n < NR_GCLK_GEN; ++n) {
+        if (sim_reg_hit(off, size, 0x20 + 4 * n, 4)) {
+            hz = gclk_src_hz(gclk_regs.GCLK_GENCTRL[n] & 0x1F);
+            gclk_sync_until[n] = sim_now +
+                    sim_cycles_to_time(GCLK_SYNC_CYCLES, hz ? hz : 32768);
+        }
+    }
+    sim_activity();
+}
+
+sim_periph_t sim_gclk = {
+    "GCLK", SIM_GCLK_BASE, sizeof (gclk_registers_t), &gclk_regs, gclk_read,
+    gclk_write, NULL
+};
+
+/////////////////////////////////////////////////////////////////////////////
+
+/*
+ * SysTick
+ *
+ * Counts the CPU clock down from LOAD; writing VAL clears it, and the
+ * count restarts from LOAD on the next clock. The external reference
+ * (CLKSOURCE = 0) is not modelled and also runs at the CPU clock.
+ *
+ * SCB shares the page, so it is handled here as well; only ICSR.PENDSTSET
+ * reads back, and writes to the SCB are ignored.
+ */
+
+#define SYSTICK_SCB_OFF		(SIM_SCB_BASE - SIM_SYSTICK_BASE)
+
+static SysTick_Type systick_regs;
+
+static struct {
+    uint32_t hz;
+    sim_time_t t0;		// Time at which the counter was last at 0
+    uint64_t wraps;		// Wraps to 0 since t0
+} systick;
+
+static bool systick_running(void) {
+    return (systick_regs.CTRL & 0x1) != 0 && systick_regs.LOAD != 0;
+}
+
+static uint32_t systick_val(void) {
+    uint64_t k;
+
+    if (!systick_running())
+        return systick_regs.VAL;
+    k = sim_time_to_cycles(sim_now - systick.t0, systick.hz);
+    if (k == 0)
+        return 0;
+    return systick_regs.LOAD - (uint32_t) ((k - 1) % (systick_regs.LOAD + 1));
+}
+
+static sim_time_t systick_next(void) {
+    if (!systick_running())
+        return SIM_TIME_NEVER;
+    return systick.t0 + sim_cycles_to_time((systick.wraps + 1) *
+            ((uint64_t) systick_regs.LOAD + 1), systick.hz);
+}
+
+static void systick_run(sim_time_t now) {
+    while (systick_next() <= now) {
+        ++systick.wraps;
+        systick_regs.CTRL |= (1u << 16);	// COUNTFLAG
+        if (systick_regs.CTRL & 0x2)
+            sim_irq_pend(SysTick_IRQn);
+    }
+}
+
+static void systick_restart(uint32_t val) {
+    uint32_t load = systick_regs.LOAD;
+
+    // Place t0 so that the counter reads @p val now.
+    systick.t0 = sim_now;
+    if (val != 0 && val <= load)
+        systick.t0 -= sim_cycles_to_time(load - val + 1, systick.hz);
+    systick.wraps = 0;
+}
+
+static uint32_t systick_read(sim_periph_t *p, uint32_t off,
+        unsigned int size) {
+    uint32_t v;
+
+    (void) p;
+    if (sim_reg_hit(off, size, SYSTICK_SCB_OFF + 0x04, 4))
+        return NVIC_GetPendingIRQ(SysTick_IRQn) ? SCB_ICSR_PENDSTSET_Msk : 0;
+    if (off >= sizeof (SysTick_Type))
+        return 0;
+    systick_regs.VAL = systick_val();
+    v = sim_reg_load(&systick_regs, off, size);
+    if (sim_reg_hit(off, size, 0x00, 4))
+        systick_regs.CTRL &= ~(1u << 16);	// COUNTFLAG clears on read
+    return v;
+}
+
+static void systick_write(sim_periph_t *p, uint32_t off, unsigned int size,
+        uint32_t val) {
+    bool was_running = systick_running();
+    uint32_t countflag;
+
+    (void) p;
+    if (off >= sizeof (SysTick_Type))
+        return;
+    if (sim_reg_hit(off, size, 0x08, 4)) {
+        systick_regs.VAL = 0;
+        systick_regs.CTRL &= ~(1u << 16);
+        systick_restart(0);
+        return;
+    }
+    if (sim_reg_hit(off, size, 0x0C, 4))
+        return;
+
+    countflag = systick_regs.CTRL & (1u << 16);
+    systick_regs.VAL = systick_val();
+    sim_reg_store(&systick_regs, off, size, val);
+    systick_regs.LOAD &= 0x00FFFFFF;
+    systick_regs.CTRL = (systick_regs.CTRL & 0x7) | countflag;
+    if (!was_running && systick_running()) {
+        systick.hz = sim_cpu_hz();
+        systick_restart(systick_regs.VAL);
+    }
+    sim_activity();
+}
+
+sim_periph_t sim_systick = {
+    "SysTick", SIM_SYSTICK_BASE, SYSTICK_SCB_OFF + sizeof (SCB_Type),
+    &systick_regs,
+    systick_read, systick_write, NULL
+};
+
+sim_model_t sim_systick_model = {systick_next, systick_run, true};
+
+/////////////////////////////////////////////////////////////////////////////
+
+void sim_sys_reset(void) {
+    memset(&pm_regs, 0, sizeof (pm_regs));
+    memset(&mclk_regs, 0, sizeof (mclk_regs));
+    memset(&nvmctrl_regs, 0, sizeof (nvmctrl_regs));
+    memset(&oscctrl_regs, 0, sizeof (oscctrl_regs));
+    memset(&supc_regs, 0, sizeof (supc_regs));
+    memset(&gclk_regs, 0, sizeof (gclk_regs));
+    memset(&systick_regs, 0, sizeof (systick_regs));
+    memset(&systick, 0, sizeof (systick));
+
+    // Reset values: everything clocked, GCLK_GEN0 on OSC16M at 4 MHz
+    mclk_regs.MCLK_CPUDIV = 0x01;
+    mclk_regs.MCLK_AHBMASK = 0x00001FFF;
+    mclk_regs.MCLK_APBAMASK = 0x00001FFF;
+    mclk_regs.MCLK_APBBMASK = 0x0000003F;
+    mclk_regs.MCLK_APBCMASK = 0x00001FFF;
+    oscctrl_regs.OSCCTRL_STATUS = OSCCTRL_STATUS_READY;
+    oscctrl_regs.OSCCTRL_OSC16MCTRL = 0x82;
+    oscctrl_regs.OSCCTRL_DFLLCTRL = 0x0080;
+    supc_regs.SUPC_STATUS = SUPC_STATUS_READY;
+    gclk_regs.GCLK_GENCTRL[0] = 0x00000105;
+    systick_regs.CALIB = 0x80000000;	// NOREF
+}
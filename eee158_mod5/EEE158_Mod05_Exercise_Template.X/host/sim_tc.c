@@ -0,0 +1,438 @@
+/**
+ * @file  host/sim_tc.c
+ * @brief Host-side register-level simulator, TC0 model (16-bit mode)
+ *
+ * Models up-counting in all four waveform modes (NFRQ, MFRQ, NPWM, MPWM),
+ * OVF/MC flags, double-buffered CC updates through CCBUF, the READSYNC
+ * command that COUNT reads depend on, both waveform outputs, the event
+ * input (RETRIGGER, COUNT, START) and event outputs, and DMA triggers on
+ * overflow and compare match.
+ *
+ * Not modelled: 8- and 32-bit modes, down-counting, capture, and the
+ * prescaler phase (the count restarts on the exact enable/write time).
+ */
+
+#include "sim_internal.h"
+
+#define TC_GCLK_ID		23	// Shared by TC0 and TC1
+#define TC_POLL_SETTLE		(10 * SIM_TIME_MS)
+
+// CTRLA
+#define CTRLA_SWRST		(1u << 0)
+#define CTRLA_ENABLE		(1u << 1)
+#define CTRLA_PRESCALER(x)	(((x) >> 8) & 0x7)
+
+// CTRLB
+#define CTRLB_LUPD		(1u << 1)
+#define CTRLB_ONESHOT		(1u << 2)
+#define CTRLB_CMD(x)		(((x) >> 5) & 0x7)
+#define CMD_RETRIGGER		1
+#define CMD_STOP		2
+#define CMD_UPDATE		3
+#define CMD_READSYNC		4
+
+// EVCTRL
+#define EVCTRL_EVACT(x)		((x) & 0x7)
+#define EVACT_RETRIGGER		1
+#define EVACT_COUNT		2
+#define EVACT_START		3
+#define EVCTRL_TCEI		(1u << 5)
+#define EVCTRL_OVFEO		(1u << 8)
+#define EVCTRL_MCEO(n)		(1u << (12 + (n)))
+
+// INTFLAG
+#define INT_OVF			(1u << 0)
+#define INT_MC(n)		(1u << (4 + (n)))
+
+// STATUS
+#define STATUS_STOP		(1u << 0)
+#define STATUS_CCBUFV(n)	(1u << (4 + (n)))
+
+// WAVE
+#define WAVEGEN_NFRQ		0
+#define WAVEGEN_MFRQ		1
+#define WAVEGEN_NPWM		2
+#define WAVEGEN_MPWM		3
+
+static tc_count16_registers_t tc_regs;
+
+static struct {
+    bool enabled;
+    bool running;
+    uint32_t hz;		// Counter clock, after the prescaler
+    sim_time_t base_t;		// The count was base_cnt at base_t
+    uint16_t base_cnt;
+    uint8_t ctrlb;
+    uint8_t inten, intflag;
+    bool toggle;		// WO[0] state in the frequency modes
+    sim_time_t last_readsync;
+} tc;
+
+/////////////////////////////////////////////////////////////////////////////
+
+static unsigned int tc_wavegen(void) {
+    return tc_regs.TC_WAVE & 0x3;
+}
+
+static uint16_t tc_top(void) {
+    unsigned int w = tc_wavegen();
+
+    return (w == WAVEGEN_MFRQ || w == WAVEGEN_MPWM) ? tc_regs.TC_CC[0] : 0xFFFF;
+}
+
+static bool tc_clocked(void) {
+    bool counting = (tc_regs.TC_EVCTRL & EVCTRL_TCEI) != 0 &&
+            EVCTRL_EVACT(tc_regs.TC_EVCTRL) == EVACT_COUNT;
+
+    return tc.enabled && tc.running && tc.hz != 0 && !counting;
+}
+
+// Counter value now, wrapping at TOP
+static uint16_t tc_count(void) {
+    uint64_t k, period = (uint64_t) tc_top() + 1;
+
+    if (!tc_clocked())
+        return tc.base_cnt;
+    k = sim_time_to_cycles(sim_now - tc.base_t, tc.hz);
+    if (tc.base_cnt >= period) {
+        // Past TOP (CC0 was lowered): runs on to MAX first
+        if (k < 0x10000u - tc.base_cnt)
+            return (uint16_t) (tc.base_cnt + k);
+        k -= 0x10000u - tc.base_cnt;
+        return (uint16_t) (k % period);
+    }
+    return (uint16_t) ((tc.base_cnt + k) % period);
+}
+
+static void tc_rebase(void) {
+    tc.base_cnt = tc_count();
+    tc.base_t = sim_now;
+}
+
+static int tc_wo_level(unsigned int n) {
+    unsigned int w = tc_wavegen();
+    uint16_t cnt = tc_count();
+    int level;
+
+    if (w == WAVEGEN_NPWM || (w == WAVEGEN_MPWM && n == 1))
+        level = cnt < tc_regs.TC_CC[n];
+    else if (n == 0)
+        level = tc.toggle;
+    else
+        level = 0;
+    if (tc_regs.TC_DRVCTRL & (1u << n))
+        level = !level;
+    return level;
+}
+
+int sim_tc_wo(unsigned int n) {
+    return tc.enabled ? tc_wo_level(n) : -1;
+}
+
+static void tc_update_irq(void) {
+    tc_regs.TC_INTFLAG = tc.intflag;
+    tc_regs.TC_INTENSET = tc_regs.TC_INTENCLR = tc.inten;
+    sim_irq_level(TC0_IRQn, (tc.intflag & tc.inten) != 0);
+}
+
+static void tc_buffer_update(void) {
+    unsigned int n;
+
+    for (n = 0; n < 2; ++n) {
+        if (tc_regs.TC_STATUS & STATUS_CCBUFV(n)) {
+            tc_regs.TC_CC[n] = tc_regs.TC_CCBUF[n];
+            tc_regs.TC_STATUS &= ~STATUS_CCBUFV(n);
+        }
+    }
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+/*
+ * Next event, in counter clocks from base: either a compare match, or the
+ * wrap to zero (if the count is already past TOP, it runs on to 0xFFFF).
+ */
+static uint64_t tc_next_ticks(int *which) {
+    uint16_t top = tc_top();
+    uint32_t wrap = (tc.base_cnt > top) ? 0xFFFF : top;
+    uint64_t best = (uint64_t) wrap - tc.base_cnt + 1;
+    unsigned int n;
+
+    *which = -1;
+    for (n = 0; n < 2; ++n) {
+        uint16_t cc = tc_regs.TC_CC[n];
+
+        if (cc > tc.base_cnt && cc <= wrap &&
+                (uint64_t) (cc - tc.base_cnt) < best) {
+            best = cc - tc.base_cnt;
+            *which = (int) n;
+        }
+    }
+    return best;
+}
+
+/*
+ * Whether overflows and matches are only visible through INTFLAG. Once all
+ * the flags are up, the counter needs no events at all until something
+ * changes (e.g. MFRQ with CC0 = 0 wraps on every clock); COUNT is then
+ * derived from the elapsed time alone.
+ */
+static bool tc_unobserved(void) {
+    return tc.inten == 0 &&
+            (tc_regs.TC_EVCTRL & (EVCTRL_OVFEO | EVCTRL_MCEO(0) |
+                    EVCTRL_MCEO(1))) == 0 &&
+            (tc.ctrlb & CTRLB_ONESHOT) == 0 &&
+            (tc_regs.TC_STATUS & (STATUS_CCBUFV(0) | STATUS_CCBUFV(1))) == 0 &&
+            !sim_pin_periph_routed(sim_tc_wo, 0) &&
+            !sim_pin_periph_routed(sim_tc_wo, 1) &&
+            !sim_dmac_trig_used(SIM_DMAC_TRIG_TC0_OVF) &&
+            !sim_dmac_trig_used(SIM_DMAC_TRIG_TC0_MC(0)) &&
+            !sim_dmac_trig_used(SIM_DMAC_TRIG_TC0_MC(1));
+}
+
+// Whether every flag the counter can raise is already set
+static bool tc_saturated(void) {
+    uint16_t top = tc_top();
+    unsigned int i;
+
+    if ((tc.intflag & INT_OVF) == 0)
+        return false;
+    for (i = 0; i < 2; ++i) {
+        if (tc_regs.TC_CC[i] != 0 && tc_regs.TC_CC[i] <= top &&
+                (tc.intflag & INT_MC(i)) == 0)
+            return false;
+    }
+    return true;
+}
+
+static sim_time_t tc_next(void) {
+    int which;
+
+    if (!tc_clocked() || (tc_unobserved() && tc_saturated()))
+        return SIM_TIME_NEVER;
+    return tc.base_t + sim_cycles_to_time(tc_next_ticks(&which), tc.hz);
+}
+
+// Process an event at the current base (compare match n, or -1: wrap)
+static void tc_event_at(int which) {
+    uint32_t ev = tc_regs.TC_EVCTRL;
+    unsigned int n;
+
+    if (which >= 0) {
+        // Both channels match at once if their CC values are equal.
+        for (n = 0; n < 2; ++n) {
+            if (tc_regs.TC_CC[n] != tc_regs.TC_CC[which])
+                continue;
+            tc.intflag |= INT_MC(n);
+            if (ev & EVCTRL_MCEO(n))
+                sim_evsys_fire(EVSYS_ID_GEN_TC0_MC_0 + n);
+            sim_dmac_pulse(SIM_DMAC_TRIG_TC0_MC(n));
+        }
+    } else {
+        tc.intflag |= INT_OVF;
+        if ((tc.ctrlb & CTRLB_LUPD) == 0)
+            tc_buffer_update();
+        tc.toggle = !tc.toggle;
+        if (tc.ctrlb & CTRLB_ONESHOT) {
+            tc.running = false;
+            tc_regs.TC_STATUS |= STATUS_STOP;
+        }
+        if (ev & EVCTRL_OVFEO)
+            sim_evsys_fire(EVSYS_ID_GEN_TC0_OVF);
+        sim_dmac_pulse(SIM_DMAC_TRIG_TC0_OVF);
+    }
+    tc_update_irq();
+    sim_pin_periph_changed();
+}
+
+static void tc_run(sim_time_t now) {
+    uint64_t k;
+    int which;
+
+    if (tc_clocked() && tc_unobserved() && tc_saturated()) {
+        tc_rebase();
+        return;
+    }
+    while (tc_clocked()) {
+        k = tc_next_ticks(&which);
+        if (tc.base_t + sim_cycles_to_time(k, tc.hz) > now)
+            break;
+        tc.base_t += sim_cycles_to_time(k, tc.hz);
+        tc.base_cnt = (which >= 0) ? tc_regs.TC_CC[which] : 0;
+        tc_event_at(which);
+    }
+}
+
+sim_model_t sim_tc_model = {tc_next, tc_run, true};
+
+/*
+ * Firmware that polls COUNT derives its own edges from it (e.g. the
+ * software blink); keep fast-forwards short enough for it to see them.
+ */
+sim_time_t sim_tc_ff_limit(void) {
+    uint64_t period;
+
+    if (!tc_clocked() || sim_now - tc.last_readsync > TC_POLL_SETTLE)
+        return SIM_TIME_NEVER;
+    period = (uint64_t) tc_top() + 1;
+    return sim_now + sim_cycles_to_time((period + 31) / 32, tc.hz);
+}
+
+// Event input, routed by EVSYS
+void sim_tc_event(void) {
+    uint32_t ev = tc_regs.TC_EVCTRL;
+    int which;
+
+    if (!tc.enabled || (ev & EVCTRL_TCEI) == 0)
+        return;
+    switch (EVCTRL_EVACT(ev)) {
+        case EVACT_RETRIGGER:
+            tc.running = true;
+            tc_regs.TC_STATUS &= ~STATUS_STOP;
+            tc.base_cnt = 0;
+            tc.base_t = sim_now;
+            break;
+        case EVACT_COUNT:
+            if (!tc.running)
+                break;
+            if (tc_next_ticks(&which) == 1) {
+                tc.base_cnt = (which >= 0) ? tc_regs.TC_CC[which] : 0;
+                tc_event_at(which);
+            } else {
+                ++tc.base_cnt;
+            }
+            break;
+        case EVACT_START:
+            if (!tc.running) {
+                tc.running = true;
+                tc_regs.TC_STATUS &= ~STATUS_STOP;
+                tc.base_t = sim_now;
+            }
+            break;
+        default:
+            break;
+    }
+    sim_pin_periph_changed();
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+// Register access
+
+static void tc_reset_regs(void) {
+    memset(&tc_regs, 0, sizeof (tc_regs));
+    memset(&tc, 0, sizeof (tc));
+    tc_regs.TC_STATUS = STATUS_STOP;
+}
+
+static uint32_t tc_read(sim_periph_t *p, uint32_t off, unsigned int size) {
+    (void) p;
+    tc_regs.TC_CTRLBSET = tc_regs.TC_CTRLBCLR = tc.ctrlb;
+    tc_regs.TC_SYNCBUSY = 0;
+    return sim_reg_load(&tc_regs, off, size);
+}
+
+static void tc_command(unsigned int cmd) {
+    switch (cmd) {
+        case CMD_RETRIGGER:
+            tc.running = true;
+            tc_regs.TC_STATUS &= ~STATUS_STOP;
+            tc.base_cnt = 0;
+            tc.base_t = sim_now;
+            break;
+        case CMD_STOP:
+            tc_rebase();
+            tc.running = false;
+            tc_regs.TC_STATUS |= STATUS_STOP;
+            break;
+        case CMD_UPDATE:
+            tc_buffer_update();
+            break;
+        case CMD_READSYNC:
+            tc_regs.TC_COUNT = tc_count();
+            tc.last_readsync = sim_now;
+            break;
+        default:
+            break;
+    }
+}
+
+static void tc_write(sim_periph_t *p, uint32_t off, unsigned int size,
+        uint32_t val) {
+    static const uint16_t presc[8] = {1, 2, 4, 8, 16, 64, 256, 1024};
+    tc_count16_registers_t before = tc_regs;
+    uint8_t inten = tc.inten, intflag = tc.intflag;
+    uint32_t old, v;
+    unsigned int n;
+
+    (void) p;
+    tc_rebase();
+    if (sim_reg_hit(off, size, 0x00, 4)) {
+        old = tc_regs.TC_CTRLA;
+        v = sim_reg_merge(old, 0x00, off, size, val);
+        if (v & CTRLA_SWRST) {
+            tc_reset_regs();
+        } else {
+            if (old & CTRLA_ENABLE)
+                v = (old & ~CTRLA_ENABLE) | (v & CTRLA_ENABLE);
+            tc_regs.TC_CTRLA = v;
+            if (!tc.enabled && (v & CTRLA_ENABLE)) {
+                tc.enabled = tc.running = true;
+                tc_regs.TC_STATUS &= ~STATUS_STOP;
+                tc.hz = sim_gclk_pch_hz(TC_GCLK_ID) /
+                        presc[CTRLA_PRESCALER(v)];
+                tc.base_t = sim_now;
+            } else if (tc.enabled && (v & CTRLA_ENABLE) == 0) {
+                tc.enabled = tc.running = false;
+                tc_regs.TC_STATUS |= STATUS_STOP;
+            }
+        }
+    } else if (sim_reg_hit(off, size, 0x04, 1)) {
+        tc.ctrlb &= ~((uint8_t) val & 0x07);
+    } else if (sim_reg_hit(off, size, 0x05, 1)) {
+        tc.ctrlb |= (uint8_t) val & 0x07;
+        tc_command(CTRLB_CMD(val));
+    } else if (sim_reg_hit(off, size, 0x06, 2)) {
+        sim_reg_store(&tc_regs, off, size, val);
+    } else if (sim_reg_hit(off, size, 0x08, 1)) {
+        tc.inten &= ~(uint8_t) val;
+    } else if (sim_reg_hit(off, size, 0x09, 1)) {
+        tc.inten |= (uint8_t) val;
+    } else if (sim_reg_hit(off, size, 0x0A, 1)) {
+        tc.intflag &= ~(uint8_t) val;
+    } else if (sim_reg_hit(off, size, 0x0B, 1)) {
+        // STATUS: only the buffer-valid flags can be cleared
+        tc_regs.TC_STATUS &= ~((uint8_t) val & 0x38);
+    } else if (sim_reg_hit(off, size, 0x0C, 4)) {
+        sim_reg_store(&tc_regs, off, size, val);
+    } else if (sim_reg_hit(off, size, 0x14, 2)) {
+        tc_regs.TC_COUNT = (uint16_t) val;
+        tc.base_cnt = (uint16_t) val;
+    } else if (sim_reg_hit(off, size, 0x1C, 4)) {
+        sim_reg_store(&tc_regs, off, size, val);
+    } else if (sim_reg_hit(off, size, 0x30, 4)) {
+        sim_reg_store(&tc_regs, off, size, val);
+        for (n = 0; n < 2; ++n) {
+            if (sim_reg_hit(off, size, 0x30 + 2 * n, 2))
+                tc_regs.TC_STATUS |= STATUS_CCBUFV(n);
+        }
+    }
+    tc_update_irq();
+    sim_pin_periph_changed();
+
+    if (tc.inten != inten || tc.intflag != intflag ||
+            memcmp(&before, &tc_regs, 0x14) != 0 ||
+            before.TC_CC[0] != tc_regs.TC_CC[0] ||
+            before.TC_CC[1] != tc_regs.TC_CC[1] ||
+            sim_reg_hit(off, size, 0x14, 2))
+        sim_activity();
+}
+
+sim_periph_t sim_tc0 = {
+    "TC0", SIM_TC0_BASE, sizeof (tc_count16_registers_t), &tc_regs, tc_read,
+    tc_write, NULL
+};
+
+void sim_tc_reset(void) {
+    tc_reset_regs();
+}
@@ -0,0 +1,266 @@
+/**
+ * @file  host/timespec_test.c
+ * @brief Host tests for the timespec and tick-conversion routines
+ *
+ * Runs in place of main.c, against the simulator (for SysTick). Every
+ * routine is checked against plain 64-bit division on the host: in full
+ * around each carry, borrow and second boundary, and at a stride (plus
+ * pseudo-random points) everywhere else. The tick readers are then run
+ * across several SysTick wrap-arounds and a second boundary, each result
+ * being checked against platform_tick_now() taken before and after.
+ *
+ * Each failure is printed; the exit status is non-zero if there was any.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "../platform/blink_settings.h"
+#include "../platform.h"
+
+// gpio.c reads the blink setting from the application.
+BlinkSetting currentSetting = OFF;
+
+#define NSEC_PER_SEC	1000000000ULL
+
+static unsigned long nr_checks, nr_failures;
+static uint64_t test_rand = 0x158158158ULL;
+
+static uint64_t test_random(void) {
+    // xorshift64
+    test_rand ^= test_rand << 13;
+    test_rand ^= test_rand >> 7;
+    test_rand ^= test_rand << 17;
+    return test_rand;
+}
+
+static void check(bool ok, const char *what, const platform_timespec_t *got,
+        uint64_t want_sec, uint64_t want_nsec, uint64_t arg) {
+    ++nr_checks;
+    if (ok)
+        return;
+    if (++nr_failures <= 20) {
+        printf("FAIL %s(0x%llx): got %lu.%09lu, want %llu.%09llu\n", what,
+                (unsigned long long) arg, (unsigned long) got->nr_sec,
+                (unsigned long) got->nr_nsec, (unsigned long long) want_sec,
+                (unsigned long long) want_nsec);
+    }
+}
+
+static void check_ts(const char *what, const platform_timespec_t *got,
+        uint64_t want_sec, uint64_t want_nsec, uint64_t arg) {
+    check(got->nr_sec == (uint32_t) want_sec && got->nr_nsec == want_nsec,
+            what, got, want_sec, want_nsec, arg);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+static void test_normalize_one(uint32_t sec, uint32_t nsec) {
+    platform_timespec_t ts = {sec, nsec};
+    uint64_t s = (uint64_t) sec + nsec / NSEC_PER_SEC;
+    uint64_t ns = nsec % NSEC_PER_SEC;
+
+    if (s > UINT32_MAX) {
+        s = UINT32_MAX;
+        ns = NSEC_PER_SEC - 1;
+    }
+    platform_timespec_normalize(&ts);
+    check_ts("normalize", &ts, s, ns, ((uint64_t) sec << 32) | nsec);
+}
+
+static void test_normalize(void) {
+    static const uint32_t secs[] = {
+        0, 1, 1000, UINT32_MAX - 4, UINT32_MAX - 3, UINT32_MAX - 2,
+        UINT32_MAX - 1, UINT32_MAX
+    };
+    uint32_t k, x;
+    int64_t d, v;
+
+    for (k = 0; k < sizeof (secs) / sizeof (secs[0]); ++k) {
+        // Around each multiple of 10^9, then the top of the range
+        for (x = 0; x <= 4; ++x) {
+            for (d = -1000; d <= 1000; ++d) {
+                v = (int64_t) (x * NSEC_PER_SEC) + d;
+                if (v >= 0 && v <= UINT32_MAX)
+                    test_normalize_one(secs[k], (uint32_t) v);
+            }
+        }
+        for (x = UINT32_MAX - 1000; x != 0; ++x)
+            test_normalize_one(secs[k], x);
+        for (x = 0; x < UINT32_MAX - 65537; x += 65537)
+            test_normalize_one(secs[k], x);
+    }
+    for (k = 0; k < 1000000; ++k)
+        test_normalize_one((uint32_t) test_random(), (uint32_t) test_random());
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+static void test_add_sub_one(uint32_t ls, uint32_t lns, uint32_t rs,
+        uint32_t rns) {
+    platform_timespec_t l = {ls, lns}, r = {rs, rns}, t;
+    uint64_t lt = (uint64_t) ls * NSEC_PER_SEC + lns;
+    uint64_t rt = (uint64_t) rs * NSEC_PER_SEC + rns;
+    uint64_t arg = ((uint64_t) lns << 32) | rns;
+    uint64_t sum = lt + rt;
+    uint64_t diff;
+    int cmp = (lt > rt) - (lt < rt);
+
+    // Seconds wrap modulo 2^32: (lt - rt) is taken modulo 2^32 seconds.
+    diff = lt - rt + (lt < rt ? ((uint64_t) 1 << 32) * NSEC_PER_SEC : 0);
+
+    platform_timespec_add(&t, &l, &r);
+    check_ts("add", &t, sum / NSEC_PER_SEC, sum % NSEC_PER_SEC, arg);
+    platform_timespec_sub(&t, &l, &r);
+    check_ts("sub", &t, diff / NSEC_PER_SEC, diff % NSEC_PER_SEC, arg);
+    platform_tick_delta(&t, &l, &r);
+    check_ts("tick_delta", &t, diff / NSEC_PER_SEC, diff % NSEC_PER_SEC, arg);
+
+    ++nr_checks;
+    if (platform_timespec_compare(&l, &r) != cmp && ++nr_failures <= 20) {
+        printf("FAIL compare(%lu.%09lu, %lu.%09lu): got %d, want %d\n",
+                (unsigned long) ls, (unsigned long) lns, (unsigned long) rs,
+                (unsigned long) rns, platform_timespec_compare(&l, &r), cmp);
+    }
+
+    // In place, as documented
+    t = l;
+    platform_timespec_add(&t, &t, &r);
+    check_ts("add (aliased)", &t, sum / NSEC_PER_SEC, sum % NSEC_PER_SEC, arg);
+    t = r;
+    platform_timespec_sub(&t, &l, &t);
+    check_ts("sub (aliased)", &t, diff / NSEC_PER_SEC, diff % NSEC_PER_SEC, arg);
+}
+
+static void test_add_sub(void) {
+    static const uint32_t secs[] = {
+        0, 1, 2, 1000, 0x7FFFFFFF, 0x80000000, UINT32_MAX - 1, UINT32_MAX
+    };
+    static const uint32_t nsecs[] = {
+        0, 1, 2, 499999999, 500000000, 500000001, 999999998, 999999999
+    };
+    const unsigned int ns = sizeof (secs) / sizeof (secs[0]);
+    const unsigned int nn = sizeof (nsecs) / sizeof (nsecs[0]);
+    unsigned int a, b, c, d;
+    uint32_t k;
+
+    // Every combination of the edge values, for carries, borrows and wraps
+    for (a = 0; a < ns; ++a)
+        for (b = 0; b < nn; ++b)
+            for (c = 0; c < ns; ++c)
+                for (d = 0; d < nn; ++d)
+                    test_add_sub_one(secs[a], nsecs[b], secs[c], nsecs[d]);
+
+    // Every nanosecond count against a few, at a stride
+    for (k = 0; k < NSEC_PER_SEC; k += 997)
+        for (d = 0; d < nn; ++d)
+            test_add_sub_one(5, k, 3, nsecs[d]);
+
+    for (k = 0; k < 1000000; ++k) {
+        test_add_sub_one((uint32_t) test_random(),
+                (uint32_t) (test_random() % NSEC_PER_SEC),
+                (uint32_t) test_random(),
+                (uint32_t) (test_random() % NSEC_PER_SEC));
+    }
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+static void test_tick_to_timespec_one(platform_tick_t t) {
+    platform_timespec_t ts;
+    uint64_t r = t % PLATFORM_TICK_HZ;
+
+    platform_tick_to_timespec(&ts, t);
+    check_ts("tick_to_timespec", &ts, t / PLATFORM_TICK_HZ,
+            r * 125 / 3, t);
+}
+
+static void test_tick_to_timespec(void) {
+    static const uint64_t secs[] = {
+        0, 1, 2, 59, 3600, 86400, 0xFFFFFFFFULL, 0x100000000ULL,
+        0x100000001ULL, UINT64_MAX / PLATFORM_TICK_HZ - 1,
+        UINT64_MAX / PLATFORM_TICK_HZ
+    };
+    uint64_t base;
+    uint32_t k;
+    int64_t d;
+
+    // Around each second boundary, including the last one below 2^64
+    for (k = 0; k < sizeof (secs) / sizeof (secs[0]); ++k) {
+        base = secs[k] * PLATFORM_TICK_HZ;
+        for (d = -3000; d <= 3000; ++d) {
+            if ((d >= 0 || base >= (uint64_t) -d) &&
+                    (d <= 0 || base <= UINT64_MAX - d))
+                test_tick_to_timespec_one(base + d);
+        }
+    }
+    for (d = 0; d < 3000; ++d)
+        test_tick_to_timespec_one(UINT64_MAX - d);
+
+    // Every cycle of the first two seconds, then a stride and at random
+    for (k = 0; k < 2 * PLATFORM_TICK_HZ; ++k)
+        test_tick_to_timespec_one(k);
+    for (base = 0; base < ((uint64_t) 1 << 40); base += 1000003)
+        test_tick_to_timespec_one(base);
+    for (k = 0; k < 4000000; ++k) {
+        test_tick_to_timespec_one(test_random());
+        test_tick_to_timespec_one(test_random() >> (test_random() & 63));
+    }
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+/*
+ * A tick reader's result must lie between the conversions of the ticks
+ * taken just before and just after it (rounded down to a tick period, for
+ * platform_tick_count()).
+ */
+static void test_tick_readers(void) {
+    const platform_tick_t period = PLATFORM_TICK_FROM_US(PLATFORM_TICK_PERIOD_US);
+    platform_timespec_t lo, hi, ts;
+    platform_tick_t t0, t1, end;
+    unsigned int which;
+
+    end = platform_tick_now() + 5 * PLATFORM_TICK_HZ / 2;
+    do {
+        for (which = 0; which < 2; ++which) {
+            t0 = platform_tick_now();
+            if (which == 0)
+                platform_tick_count(&ts);
+            else
+                platform_tick_hrcount(&ts);
+            t1 = platform_tick_now();
+            if (which == 0) {
+                t0 -= t0 % period;
+                t1 -= t1 % period;
+            }
+            platform_tick_to_timespec(&lo, t0);
+            platform_tick_to_timespec(&hi, t1);
+            ++nr_checks;
+            if ((platform_timespec_compare(&ts, &lo) < 0 ||
+                    platform_timespec_compare(&ts, &hi) > 0) &&
+                    ++nr_failures <= 20) {
+                printf("FAIL tick_%s: %lu.%09lu outside %lu.%09lu..%lu.%09lu\n",
+                        (which == 0) ? "count" : "hrcount",
+                        (unsigned long) ts.nr_sec, (unsigned long) ts.nr_nsec,
+                        (unsigned long) lo.nr_sec, (unsigned long) lo.nr_nsec,
+                        (unsigned long) hi.nr_sec, (unsigned long) hi.nr_nsec);
+            }
+        }
+    } while (t1 < end);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+int main(void) {
+    platform_init();
+
+    test_normalize();
+    test_add_sub();
+    test_tick_to_timespec();
+    test_tick_readers();
+
+    printf("timespec: %lu checks, %lu failures\n", nr_checks, nr_failures);
+    return (nr_failures == 0) ? 0 : 1;
+}
@@ -0,0 +1,411 @@
+/**
+ * @file  host/xc.h
+ * @brief Host-side stand-in for the XC32 device header
+ *
+ * Only the registers, types and intrinsics that the firmware actually uses
+ * are declared; layouts follow the PIC32CM5164LS00048 datasheet so that
+ * offsets within a peripheral match the real chip.
+ *
+ * NOTE: Base addresses are simulator-specific. Every peripheral sits on its
+ *       own 4-KiB page, which the simulator maps inaccessible so that each
+ *       register access traps into the corresponding model (see sim.c).
+ */
+
+#if !defined(EEE158_EX05_HOST_XC_H_)
+#define EEE158_EX05_HOST_XC_H_
+
+#include <stdint.h>
+
+#define __I  volatile
+#define __O  volatile
+#define __IO volatile
+
+/*
+ * The firmware marks its handlers with __attribute__((used, interrupt())).
+ * Handlers are plain functions on the host; the simulator calls them
+ * directly.
+ */
+#define interrupt(...)
+
+/////////////////////////////////////////////////////////////////////////////
+
+// Simulator address map
+#define SIM_PM_BASE		(0x40000000UL)
+#define SIM_MCLK_BASE		(0x40001000UL)
+#define SIM_OSCCTRL_BASE	(0x40002000UL)
+#define SIM_SUPC_BASE		(0x40003000UL)
+#define SIM_GCLK_BASE		(0x40004000UL)
+#define SIM_EIC_BASE		(0x40005000UL)
+#define SIM_PORT_BASE		(0x40006000UL)
+#define SIM_DMAC_BASE		(0x41000000UL)
+#define SIM_NVMCTRL_BASE	(0x41001000UL)
+#define SIM_EVSYS_BASE		(0x42000000UL)
+#define SIM_SERCOM_BASE(n)	(0x42001000UL + ((n) * 0x1000UL))
+#define SIM_TC0_BASE		(0x42005000UL)
+#define SIM_SYSTICK_BASE	(0xE000E010UL)
+#define SIM_SCB_BASE		(0xE000ED00UL)
+
+/////////////////////////////////////////////////////////////////////////////
+
+// PM (datasheet section 22)
+typedef struct {
+    __IO uint8_t  PM_CTRLA;		// 0x00
+    __IO uint8_t  PM_SLEEPCFG;		// 0x01
+    __IO uint8_t  PM_PLCFG;		// 0x02
+    uint8_t       Reserved1[0x01];
+    __IO uint8_t  PM_INTENCLR;		// 0x04
+    __IO uint8_t  PM_INTENSET;		// 0x05
+    __IO uint8_t  PM_INTFLAG;		// 0x06
+    uint8_t       Reserved2[0x01];
+    __IO uint16_t PM_STDBYCFG;		// 0x08
+} pm_registers_t;
+
+// MCLK (datasheet section 18)
+typedef struct {
+    __IO uint8_t  MCLK_CTRLA;		// 0x00
+    __IO uint8_t  MCLK_INTENCLR;	// 0x01
+    __IO uint8_t  MCLK_INTENSET;	// 0x02
+    __IO uint8_t  MCLK_INTFLAG;		// 0x03
+    __IO uint8_t  MCLK_CPUDIV;		// 0x04
+    uint8_t       Reserved1[0x0B];
+    __IO uint32_t MCLK_AHBMASK;		// 0x10
+    __IO uint32_t MCLK_APBAMASK;	// 0x14
+    __IO uint32_t MCLK_APBBMASK;	// 0x18
+    __IO uint32_t MCLK_APBCMASK;	// 0x1C
+} mclk_registers_t;
+
+// OSCCTRL (datasheet section 20)
+typedef struct {
+    __IO uint8_t  OSCCTRL_EVCTRL;	// 0x00
+    uint8_t       Reserved1[0x03];
+    __IO uint32_t OSCCTRL_INTENCLR;	// 0x04
+    __IO uint32_t OSCCTRL_INTENSET;	// 0x08
+    __IO uint32_t OSCCTRL_INTFLAG;	// 0x0C
+    __IO uint32_t OSCCTRL_STATUS;	// 0x10
+    __IO uint16_t OSCCTRL_XOSCCTRL;	// 0x14
+    __IO uint8_t  OSCCTRL_CFDPRESC;	// 0x16
+    uint8_t       Reserved2[0x01];
+    __IO uint8_t  OSCCTRL_OSC16MCTRL;	// 0x18
+    uint8_t       Reserved3[0x03];
+    __IO uint16_t OSCCTRL_DFLLULPCTRL;	// 0x1C
+    uint8_t       Reserved4[0x02];
+    __IO uint16_t OSCCTRL_DFLLCTRL;	// 0x20
+    uint8_t       Reserved5[0x02];
+    __IO uint32_t OSCCTRL_DFLLVAL;	// 0x24
+} oscctrl_registers_t;
+
+// SUPC (datasheet section 23)
+typedef struct {
+    __IO uint32_t SUPC_INTENCLR;	// 0x00
+    __IO uint32_t SUPC_INTENSET;	// 0x04
+    __IO uint32_t SUPC_INTFLAG;		// 0x08
+    __IO uint32_t SUPC_STATUS;		// 0x0C
+    __IO uint32_t SUPC_BOD33;		// 0x10
+    uint8_t       Reserved1[0x04];
+    __IO uint32_t SUPC_VREG;		// 0x18
+    __IO uint32_t SUPC_VREF;		// 0x1C
+    __IO uint32_t SUPC_VREGPLL;		// 0x20
+} supc_registers_t;
+
+// GCLK (datasheet section 17)
+typedef struct {
+    __IO uint8_t  GCLK_CTRLA;		// 0x00
+    uint8_t       Reserved1[0x03];
+    __I  uint32_t GCLK_SYNCBUSY;	// 0x04
+    uint8_t       Reserved2[0x18];
+    __IO uint32_t GCLK_GENCTRL[5];	// 0x20
+    uint8_t       Reserved3[0x4C];
+    __IO uint32_t GCLK_PCHCTRL[32];	// 0x80
+} gclk_registers_t;
+
+// NVMCTRL (datasheet section 26)
+typedef struct {
+    __IO uint16_t NVMCTRL_CTRLA;	// 0x00
+    uint8_t       Reserved1[0x02];
+    __IO uint32_t NVMCTRL_CTRLB;	// 0x04
+    __IO uint32_t NVMCTRL_CTRLC;	// 0x08
+} nvmctrl_registers_t;
+
+// EIC (datasheet section 27)
+typedef struct {
+    __IO uint8_t  EIC_CTRLA;		// 0x00
+    __IO uint8_t  EIC_NMICTRL;		// 0x01
+    __IO uint16_t EIC_NMIFLAG;		// 0x02
+    __I  uint32_t EIC_SYNCBUSY;		// 0x04
+    __IO uint32_t EIC_EVCTRL;		// 0x08
+    __IO uint32_t EIC_INTENCLR;		// 0x0C
+    __IO uint32_t EIC_INTENSET;		// 0x10
+    __IO uint32_t EIC_INTFLAG;		// 0x14
+    __IO uint32_t EIC_ASYNCH;		// 0x18
+    __IO uint32_t EIC_CONFIG0;		// 0x1C
+    __IO uint32_t EIC_CONFIG1;		// 0x20
+    uint8_t       Reserved1[0x0C];
+    __IO uint32_t EIC_DEBOUNCEN;	// 0x30
+    __IO uint32_t EIC_DPRESCALER;	// 0x34
+    __I  uint32_t EIC_PINSTATE;		// 0x38
+} eic_registers_t;
+
+// PORT (datasheet section 31)
+typedef struct {
+    __IO uint32_t PORT_DIR;		// 0x00
+    __IO uint32_t PORT_DIRCLR;		// 0x04
+    __IO uint32_t PORT_DIRSET;		// 0x08
+    __IO uint32_t PORT_DIRTGL;		// 0x0C
+    __IO uint32_t PORT_OUT;		// 0x10
+    __IO uint32_t PORT_OUTCLR;		// 0x14
+    __IO uint32_t PORT_OUTSET;		// 0x18
+    __IO uint32_t PORT_OUTTGL;		// 0x1C
+    __I  uint32_t PORT_IN;		// 0x20
+    __IO uint32_t PORT_CTRL;		// 0x24
+    __O  uint32_t PORT_WRCONFIG;	// 0x28
+    __IO uint32_t PORT_EVCTRL;		// 0x2C
+    __IO uint8_t  PORT_PMUX[16];	// 0x30
+    __IO uint8_t  PORT_PINCFG[32];	// 0x40
+    uint8_t       Reserved1[0x20];
+} port_group_registers_t;
+
+typedef struct {
+    port_group_registers_t GROUP[2];
+} port_registers_t;
+
+// EVSYS (datasheet section 30)
+typedef struct {
+    __IO uint8_t  EVSYS_CTRLA;		// 0x00
+    uint8_t       Reserved1[0x03];
+    __O  uint32_t EVSYS_SWEVT;		// 0x04
+    __IO uint8_t  EVSYS_PRICTRL;	// 0x08
+    uint8_t       Reserved2[0x17];
+    __IO uint32_t EVSYS_CHANNEL[8];	// 0x20
+    uint8_t       Reserved3[0xE0];
+    __IO uint8_t  EVSYS_USER[64];	// 0x120
+} evsys_registers_t;
+
+// SERCOM, USART with internal clock (datasheet section 33)
+typedef struct {
+    __IO uint32_t SERCOM_CTRLA;		// 0x00
+    __IO uint32_t SERCOM_CTRLB;		// 0x04
+    __IO uint32_t SERCOM_CTRLC;		// 0x08
+    __IO uint16_t SERCOM_BAUD;		// 0x0C
+    __IO uint8_t  SERCOM_RXPL;		// 0x0E
+    uint8_t       Reserved1[0x05];
+    __IO uint8_t  SERCOM_INTENCLR;	// 0x14
+    uint8_t       Reserved2[0x01];
+    __IO uint8_t  SERCOM_INTENSET;	// 0x16
+    uint8_t       Reserved3[0x01];
+    __IO uint8_t  SERCOM_INTFLAG;	// 0x18
+    uint8_t       Reserved4[0x01];
+    __IO uint16_t SERCOM_STATUS;	// 0x1A
+    __I  uint32_t SERCOM_SYNCBUSY;	// 0x1C
+    __I  uint8_t  SERCOM_RXERRCNT;	// 0x20
+    uint8_t       Reserved5[0x07];
+    __IO uint32_t SERCOM_DATA;		// 0x28
+    uint8_t       Reserved6[0x04];
+    __IO uint8_t  SERCOM_DBGCTRL;	// 0x30
+    uint8_t       Reserved7[0x03];
+    __I  uint16_t SERCOM_FIFOSPACE;	// 0x34
+    __IO uint16_t SERCOM_FIFOPTR;	// 0x36
+} sercom_usart_int_registers_t;
+
+typedef union {
+    sercom_usart_int_registers_t USART_INT;
+} sercom_registers_t;
+
+// TC, 16-bit counter mode (datasheet section 39)
+typedef struct {
+    __IO uint32_t TC_CTRLA;		// 0x00
+    __IO uint8_t  TC_CTRLBCLR;		// 0x04
+    __IO uint8_t  TC_CTRLBSET;		// 0x05
+    __IO uint16_t TC_EVCTRL;		// 0x06
+    __IO uint8_t  TC_INTENCLR;		// 0x08
+    __IO uint8_t  TC_INTENSET;		// 0x09
+    __IO uint8_t  TC_INTFLAG;		// 0x0A
+    __IO uint8_t  TC_STATUS;		// 0x0B
+    __IO uint8_t  TC_WAVE;		// 0x0C
+    __IO uint8_t  TC_DRVCTRL;		// 0x0D
+    uint8_t       Reserved1[0x01];
+    __IO uint8_t  TC_DBGCTRL;		// 0x0F
+    __I  uint32_t TC_SYNCBUSY;		// 0x10
+    __IO uint16_t TC_COUNT;		// 0x14
+    uint8_t       Reserved2[0x06];
+    __IO uint16_t TC_CC[2];		// 0x1C
+    uint8_t       Reserved3[0x10];
+    __IO uint16_t TC_CCBUF[2];		// 0x30
+} tc_count16_registers_t;
+
+typedef union {
+    tc_count16_registers_t COUNT16;
+} tc_registers_t;
+
+// DMAC (datasheet section 28)
+typedef struct {
+    __IO uint16_t DMAC_CTRL;		// 0x00
+    __IO uint16_t DMAC_CRCCTRL;		// 0x02
+    __IO uint32_t DMAC_CRCDATAIN;	// 0x04
+    __IO uint32_t DMAC_CRCCHKSUM;	// 0x08
+    __IO uint8_t  DMAC_CRCSTATUS;	// 0x0C
+    __IO uint8_t  DMAC_DBGCTRL;		// 0x0D
+    __IO uint8_t  DMAC_QOSCTRL;		// 0x0E
+    uint8_t       Reserved1[0x01];
+    __IO uint32_t DMAC_SWTRIGCTRL;	// 0x10
+    __IO uint32_t DMAC_PRICTRL0;	// 0x14
+    uint8_t       Reserved2[0x08];
+    __IO uint16_t DMAC_INTPEND;		// 0x20
+    uint8_t       Reserved3[0x02];
+    __I  uint32_t DMAC_INTSTATUS;	// 0x24
+    __I  uint32_t DMAC_BUSYCH;		// 0x28
+    __I  uint32_t DMAC_PENDCH;		// 0x2C
+    __I  uint32_t DMAC_ACTIVE;		// 0x30
+    __IO uint32_t DMAC_BASEADDR;	// 0x34
+    __IO uint32_t DMAC_WRBADDR;		// 0x38
+    uint8_t       Reserved4[0x03];
+    __IO uint8_t  DMAC_CHID;		// 0x3F
+    __IO uint8_t  DMAC_CHCTRLA;		// 0x40
+    uint8_t       Reserved5[0x03];
+    __IO uint32_t DMAC_CHCTRLB;		// 0x44
+    uint8_t       Reserved6[0x04];
+    __IO uint8_t  DMAC_CHINTENCLR;	// 0x4C
+    __IO uint8_t  DMAC_CHINTENSET;	// 0x4D
+    __IO uint8_t  DMAC_CHINTFLAG;	// 0x4E
+    __I  uint8_t  DMAC_CHSTATUS;	// 0x4F
+} dmac_registers_t;
+
+// SysTick (ARMv8-M Architecture Reference Manual, B11)
+typedef struct {
+    __IO uint32_t CTRL;			// 0x00
+    __IO uint32_t LOAD;			// 0x04
+    __IO uint32_t VAL;			// 0x08
+    __I  uint32_t CALIB;		// 0x0C
+} SysTick_Type;
+
+// System Control Block (ARMv8-M Architecture Reference Manual, B11); ICSR only
+typedef struct {
+    __I  uint32_t CPUID;		// 0x00
+    __IO uint32_t ICSR;			// 0x04
+} SCB_Type;
+
+#define SCB_ICSR_PENDSTSET_Msk	(1UL << 26)
+
+#define PM_REGS			((pm_registers_t *) SIM_PM_BASE)
+#define MCLK_REGS		((mclk_registers_t *) SIM_MCLK_BASE)
+#define OSCCTRL_REGS		((oscctrl_registers_t *) SIM_OSCCTRL_BASE)
+#define SUPC_REGS		((supc_registers_t *) SIM_SUPC_BASE)
+#define GCLK_REGS		((gclk_registers_t *) SIM_GCLK_BASE)
+#define NVMCTRL_SEC_REGS	((nvmctrl_registers_t *) SIM_NVMCTRL_BASE)
+#define EIC_SEC_REGS		((eic_registers_t *) SIM_EIC_BASE)
+#define PORT_SEC_REGS		((port_registers_t *) SIM_PORT_BASE)
+#define EVSYS_SEC_REGS		((evsys_registers_t *) SIM_EVSYS_BASE)
+#define SERCOM0_REGS		((sercom_registers_t *) SIM_SERCOM_BASE(0))
+#define SERCOM1_REGS		((sercom_registers_t *) SIM_SERCOM_BASE(1))
+#define SERCOM2_REGS		((sercom_registers_t *) SIM_SERCOM_BASE(2))
+#define SERCOM3_REGS		((sercom_registers_t *) SIM_SERCOM_BASE(3))
+#define TC0_REGS		((tc_registers_t *) SIM_TC0_BASE)
+#define DMAC_REGS		((dmac_registers_t *) SIM_DMAC_BASE)
+#define SysTick			((SysTick_Type *) SIM_SYSTICK_BASE)
+#define SCB			((SCB_Type *) SIM_SCB_BASE)
+
+/*
+ * Event generator and user numbering (datasheet, EVSYS "Event Generators"
+ * and "Event Users" tables). Only those that are modelled are listed.
+ */
+#define EVSYS_ID_GEN_EIC_EXTINT_0	(0x0C)
+#define EVSYS_ID_GEN_TC0_OVF		(0x2C)
+#define EVSYS_ID_GEN_TC0_MC_0		(0x2D)
+#define EVSYS_ID_GEN_TC0_MC_1		(0x2E)
+#define EVSYS_ID_USER_PORT_EV_0		(0x01)
+#define EVSYS_ID_USER_TC0_EVU		(0x0E)
+
+/////////////////////////////////////////////////////////////////////////////
+
+// Interrupt numbers
+typedef enum {
+    SysTick_IRQn		= -1,
+    EIC_EXTINT_0_IRQn		= 3,
+    EIC_EXTINT_1_IRQn		= 4,
+    EIC_EXTINT_2_IRQn		= 5,
+    EIC_EXTINT_3_IRQn		= 6,
+    EIC_OTHER_IRQn		= 10,
+    DMAC_0_IRQn			= 11,
+    DMAC_1_IRQn			= 12,
+    DMAC_2_IRQn			= 13,
+    DMAC_3_IRQn			= 14,
+    DMAC_OTHER_IRQn		= 15,
+    EVSYS_0_IRQn		= 16,
+    SERCOM0_0_IRQn		= 22,
+    SERCOM0_1_IRQn		= 23,
+    SERCOM0_2_IRQn		= 24,
+    SERCOM0_OTHER_IRQn		= 25,
+    SERCOM1_0_IRQn		= 26,
+    SERCOM1_1_IRQn		= 27,
+    SERCOM1_2_IRQn		= 28,
+    SERCOM1_OTHER_IRQn		= 29,
+    SERCOM2_0_IRQn		= 30,
+    SERCOM2_1_IRQn		= 31,
+    SERCOM2_2_IRQn		= 32,
+    SERCOM2_OTHER_IRQn		= 33,
+    SERCOM3_0_IRQn		= 34,
+    SERCOM3_1_IRQn		= 35,
+    SERCOM3_2_IRQn		= 36,
+    SERCOM3_OTHER_IRQn		= 37,
+    TC0_IRQn			= 40,
+    TC1_IRQn			= 41,
+    TC2_IRQn			= 42,
+} IRQn_Type;
+
+/////////////////////////////////////////////////////////////////////////////
+
+// CMSIS intrinsics, implemented by the simulator's interrupt model
+extern volatile uint32_t sim_primask;
+void sim_irq_unmasked(void);
+void sim_wfi(void);
+
+void NVIC_EnableIRQ(IRQn_Type irq);
+void NVIC_DisableIRQ(IRQn_Type irq);
+void NVIC_SetPendingIRQ(IRQn_Type irq);
+void NVIC_ClearPendingIRQ(IRQn_Type irq);
+uint32_t NVIC_GetPendingIRQ(IRQn_Type irq);
+void NVIC_SetPriority(IRQn_Type irq, uint32_t prio);
+uint32_t NVIC_GetPriority(IRQn_Type irq);
+
+static inline void __DMB(void) {
+    __asm__ volatile ("" ::: "memory");
+}
+
+static inline void __DSB(void) {
+    __asm__ volatile ("" ::: "memory");
+}
+
+static inline void __ISB(void) {
+    __asm__ volatile ("" ::: "memory");
+}
+
+static inline void __NOP(void) {
+    __asm__ volatile ("nop");
+}
+
+static inline uint32_t __get_PRIMASK(void) {
+    __asm__ volatile ("" ::: "memory");
+    return sim_primask;
+}
+
+static inline void __set_PRIMASK(uint32_t primask) {
+    __asm__ volatile ("" ::: "memory");
+    sim_primask = primask & 1;
+    __asm__ volatile ("" ::: "memory");
+    if (primask == 0)
+        sim_irq_unmasked();
+}
+
+static inline void __disable_irq(void) {
+    __set_PRIMASK(1);
+}
+
+static inline void __enable_irq(void) {
+    __set_PRIMASK(0);
+}
+
+static inline void __WFI(void) {
+    __asm__ volatile ("" ::: "memory");
+    sim_wfi();
+}
+
+#endif	// !defined(EEE158_EX05_HOST_XC_H_)
@@ -28,6 +28,7 @@
  */
 #define HOME_KEY 0x1B    // ASCII for Home key
 #define CTRL_E 0x05     // ASCII for CTRL+E
+#define CTRL_P 0x10     // ASCII for CTRL+P (dump the hot-path probes)
 
 static const char banner_msg[] =
         "\033[1;1H"
@@ -70,9 +71,12 @@ typedef struct prog_state_type {
 
     // Transmit stuff
     /*
-     * Declares a four element array with the buffer and length of the message.
+     * One fragment array per blink setting. Messages are queued rather than
+     * sent one at a time, so an array must not be rewritten while an earlier
+     * message using it may still be waiting; these are filled in once and
+     * never touched again.
      */
-    platform_usart_tx_bufdesc_t tx_desc[4];
+    platform_usart_tx_bufdesc_t blink_desc[NUM_SETTINGS][2];
 
     char tx_buf[64];
     uint16_t tx_blen; // [0, 65535]
@@ -89,8 +93,18 @@ typedef struct prog_state_type {
  * This style might be familiar to those accustomed to he programming
  * conventions employed by the Arduino platform.
  */
+static const char CHANGE_MODE[] = "\033[12;1H\033[0K";
+
 static void prog_setup(prog_state_t *ps) {
+    unsigned int x;
+
     memset(ps, 0, sizeof (*ps));
+    for (x = 0; x < NUM_SETTINGS; ++x) {
+        ps->blink_desc[x][0].buf = CHANGE_MODE;
+        ps->blink_desc[x][0].len = sizeof (CHANGE_MODE) - 1;
+        ps->blink_desc[x][1].buf = blinkSettingStrings[x];
+        ps->blink_desc[x][1].len = strlen(blinkSettingStrings[x]);
+    }
 
     platform_init();
 
@@ -108,33 +122,21 @@ const char *blinkSettingStrings[NUM_SETTINGS] = {
     "Blink Setting: [  SLOW  ]\r\n",
     "Blink Setting: [ MEDIUM ]\r\n",
     "Blink Setting: [  FAST  ]\r\n",
-    "Blink Setting: [   ON   ]\r\n"
+    "Blink Setting: [   ON   ]\r\n",
+    "Blink Setting: [ BREATHE]\r\n"
 };
 
 
-static const char CHANGE_MODE[] = "\033[12;1H\033[0K";
-
 static void updateBlinkSetting(prog_state_t *ps, bool increase) {
-    if (increase && currentSetting < ON) {
+    if (increase && currentSetting < NUM_SETTINGS - 1) {
         currentSetting++;
     } else if (!increase && currentSetting > OFF) {
         currentSetting--;
     }
 
-    ps->tx_desc[0].buf = CHANGE_MODE;
-    ps->tx_desc[0].len = sizeof (CHANGE_MODE) - 1;
-    ps->tx_desc[1].buf = blinkSettingStrings[currentSetting];
-    ps->tx_desc[1].len = strlen(blinkSettingStrings[currentSetting]);
-
-    platform_usart_cdc_tx_async(ps->tx_desc, 2);
+    platform_usart_cdc_tx_async(ps->blink_desc[currentSetting], 2);
 
-    if (currentSetting == OFF) {
-        PORT_SEC_REGS->GROUP[0].PORT_OUTCLR |= (1 << 15); // Turn off LED
-    } else if (currentSetting == ON) {
-        PORT_SEC_REGS->GROUP[0].PORT_OUTSET |= (1 << 15);
-    } else {
-        platform_blink_modify(); // Start blinking with new setting
-    }
+    platform_blink_modify(); // Apply the new setting
 }
 
 /*
@@ -150,33 +152,48 @@ static const char BUTTON_PRESSED[] = "On-board button: [Pressed] ";
 static const char BUTTON_RELEASED[] = "On-board button: [Released]";
 static char current_banner[sizeof (banner_msg)];
 
+// Three quick flashes on the LED, for a garbled keystroke
+static const platform_led_step_t rx_error_steps[] = {
+    PLATFORM_LED_ON(100), PLATFORM_LED_OFF(100),
+    PLATFORM_LED_ON(100), PLATFORM_LED_OFF(100),
+    PLATFORM_LED_ON(100), PLATFORM_LED_OFF(500)
+};
+static const platform_led_pattern_t rx_error_pattern = {
+    rx_error_steps, sizeof (rx_error_steps) / sizeof (rx_error_steps[0]), 1
+};
+
+static const platform_usart_tx_bufdesc_t init_banner_desc[] = {
+    {init_banner_msg, sizeof (init_banner_msg) - 1}
+};
+static const platform_usart_tx_bufdesc_t banner_desc[] = {
+    {banner_msg, sizeof (banner_msg) - 1}
+};
+static const platform_usart_tx_bufdesc_t pressed_desc[] = {
+    {ESC_SEQ_BUTTON_POS, sizeof (ESC_SEQ_BUTTON_POS) - 1},
+    {BUTTON_PRESSED, sizeof (BUTTON_PRESSED) - 1}
+};
+static const platform_usart_tx_bufdesc_t released_desc[] = {
+    {ESC_SEQ_BUTTON_POS, sizeof (ESC_SEQ_BUTTON_POS) - 1},
+    {BUTTON_RELEASED, sizeof (BUTTON_RELEASED) - 1}
+};
+
 static void prog_loop_one(prog_state_t *ps) {
-    uint16_t a = 0, b = 0, c = 0;
+    uint16_t b = 0, c = 0;
+    platform_pb_event_t pb;
 
     // Do one iteration of the platform event loop first.
     platform_do_loop_one();
     platform_blink_modify();
     // Print out the banner
-    if (init == 0) {
-        ps->tx_desc[0].buf = init_banner_msg;
-        ps->tx_desc[0].len = sizeof (init_banner_msg) - 1;
-        platform_usart_cdc_tx_async(&ps->tx_desc[0], 1);
+    if (init == 0 && platform_usart_cdc_tx_async(init_banner_desc, 1)) {
         init = 1;
     }
-    // Something happened to the pushbutton?
-    if ((a = platform_pb_get_event()) != 0) {
-        if ((a & PLATFORM_PB_ONBOARD_PRESS) != 0) {
-            ps->tx_desc[0].buf = ESC_SEQ_BUTTON_POS;
-            ps->tx_desc[0].len = sizeof (ESC_SEQ_BUTTON_POS) - 1;
-            ps->tx_desc[1].buf = BUTTON_PRESSED;
-            ps->tx_desc[1].len = sizeof (BUTTON_PRESSED) - 1;
-            platform_usart_cdc_tx_async(&ps->tx_desc[0], 2);
-        } else if ((a & PLATFORM_PB_ONBOARD_RELEASE) != 0) {
-            ps->tx_desc[0].buf = ESC_SEQ_BUTTON_POS;
-            ps->tx_desc[0].len = sizeof (ESC_SEQ_BUTTON_POS) - 1;
-            ps->tx_desc[1].buf = BUTTON_RELEASED;
-            ps->tx_desc[1].len = sizeof (BUTTON_RELEASED) - 1;
-            platform_usart_cdc_tx_async(&ps->tx_desc[0], 2);
+    // Something happened to the pushbutton? Report every edge, in order.
+    while (platform_pb_event_read(&pb)) {
+        if (pb.edge == PLATFORM_PB_EDGE_PRESS) {
+            platform_usart_cdc_tx_async(pressed_desc, 2);
+        } else {
+            platform_usart_cdc_tx_async(released_desc, 2);
         }
     }
 
@@ -190,6 +207,11 @@ static void prog_loop_one(prog_state_t *ps) {
             ps->flags |= PROG_FLAG_UPDATE_PENDING;
         }
         ps->rx_desc_blen = ps->rx_desc.compl_info.data_len;
+    } else if (ps->rx_desc.compl_type != PLATFORM_USART_RX_COMPL_NONE) {
+        // Line error; a partial keystroke is not worth acting on.
+        if (!platform_led_pattern_busy())
+            platform_led_pattern_queue(&rx_error_pattern);
+        platform_usart_cdc_rx_async(&ps->rx_desc);
     }
 
 
@@ -200,21 +222,15 @@ static void prog_loop_one(prog_state_t *ps) {
         if ((ps->flags & PROG_FLAG_BANNER_PENDING) == 0)
             break;
 
-        if (platform_usart_cdc_tx_busy())
-            break;
-
         if ((ps->flags & PROG_FLAG_GEN_COMPLETE) == 0) {
-
-
-            ps->tx_desc[0].buf = banner_msg;
-            ps->tx_desc[0].len = sizeof (banner_msg) - 1;
             ps->flags |= PROG_FLAG_GEN_COMPLETE;
             // Reset receive buffer immediately
             ps->rx_desc.compl_type = PLATFORM_USART_RX_COMPL_NONE;
             platform_usart_cdc_rx_async(&ps->rx_desc);
         }
 
-        if (platform_usart_cdc_tx_async(&ps->tx_desc[0], 1)) {
+        // Only retried if the transmit queue happens to be full
+        if (platform_usart_cdc_tx_async(banner_desc, 1)) {
             ps->flags &= ~(PROG_FLAG_BANNER_PENDING | PROG_FLAG_GEN_COMPLETE);
         }
     } while (0);
@@ -224,60 +240,40 @@ static void prog_loop_one(prog_state_t *ps) {
         if ((ps->flags & PROG_FLAG_UPDATE_PENDING) == 0)
             break;
 
-        if (platform_usart_cdc_tx_busy())
-            break;
-
-        if ((ps->flags & PROG_FLAG_GEN_COMPLETE) == 0) {
-            // Message has not been generated.
-
-            // Echo back the received packet as a hex dump.
-            char received_char = ps->rx_desc_buf[0];
-            if (received_char == '\033') {
-                // Escape sequence detected, could be an arrow key
-                if (ps->rx_desc_buf[1] == '[') {
-                    switch (ps->rx_desc_buf[2]) {
-                        case 'D': // Left arrow
-                            TC0_REGS -> COUNT16.TC_COUNT = 0;
-                            updateBlinkSetting(ps, false);
-                            break;
-                        case 'C': // Right arrow
-                            TC0_REGS -> COUNT16.TC_COUNT = 0;
-                            updateBlinkSetting(ps, true);
-                            break;
-                    }
+        // React to the received keystroke
+        char received_char = ps->rx_desc_buf[0];
+        if (received_char == '\033') {
+            // Escape sequence detected, could be an arrow key
+            if (ps->rx_desc_buf[1] == '[') {
+                switch (ps->rx_desc_buf[2]) {
+                    case 'D': // Left arrow
+                        updateBlinkSetting(ps, false);
+                        break;
+                    case 'C': // Right arrow
+                        updateBlinkSetting(ps, true);
+                        break;
                 }
-            } else if (received_char == 0x61 || received_char == 0x41) {
-                TC0_REGS -> COUNT16.TC_COUNT = 0;
-                while (TC0_REGS -> COUNT16.TC_SYNCBUSY & (1 << 4));
-                updateBlinkSetting(ps, false);
-            } else if (received_char == 'D' || received_char == 'd') {
-                TC0_REGS -> COUNT16.TC_COUNT = 0;
-                while (TC0_REGS -> COUNT16.TC_SYNCBUSY & (1 << 4));
-                updateBlinkSetting(ps, true);
-            } else {
-                // Handle other inputs as before
-                ps->flags |= PROG_FLAG_UPDATE_PENDING;
-                ps->rx_desc_blen = ps->rx_desc.compl_info.data_len;
-            }
-
-            // Reset receive buffer and wait for completion
-            while (platform_usart_cdc_tx_busy()) {
-                platform_do_loop_one();
             }
-
-            ps->rx_desc.compl_type = PLATFORM_USART_RX_COMPL_NONE;
-            platform_usart_cdc_rx_async(&ps->rx_desc);
-
-            ps->flags |= PROG_FLAG_GEN_COMPLETE;
-            ps->rx_desc_blen = 0;
+        } else if (received_char == 0x61 || received_char == 0x41) {
+            updateBlinkSetting(ps, false);
+        } else if (received_char == 'D' || received_char == 'd') {
+            updateBlinkSetting(ps, true);
         }
-
-        if (platform_usart_cdc_tx_async(&ps->tx_desc[0], 3)) {
-            ps->rx_desc.compl_type = PLATFORM_USART_RX_COMPL_NONE;
-            platform_usart_cdc_rx_async(&ps->rx_desc);
-            ps->flags &= ~(PROG_FLAG_UPDATE_PENDING | PROG_FLAG_GEN_COMPLETE);
+#if (PLATFORM_USE_PROBES != 0)
+        else if (received_char == CTRL_P) {
+            platform_probe_dump();
         }
-
+#endif
+        /*
+         * Other inputs are ignored. Any update has been queued behind
+         * whatever is still being sent, so there is no need to wait for
+         * the transmitter before listening again.
+         */
+        ps->rx_desc.compl_type = PLATFORM_USART_RX_COMPL_NONE;
+        platform_usart_cdc_rx_async(&ps->rx_desc);
+
+        ps->rx_desc_blen = 0;
+        ps->flags &= ~PROG_FLAG_UPDATE_PENDING;
 
     } while (0);
 
@@ -299,6 +295,8 @@ int main(void) {
      */
 
     for (;;) {
+        // Sleep until something needs attention
+        platform_wait_for_event();
         prog_loop_one(&ps);
     }
 
@@ -30,6 +30,46 @@ extern "C" {
      */
     void platform_do_loop_one(void);
 
+    /// Event bit: a SysTick period went by (software timers may have expired)
+#define PLATFORM_EVENT_TICK	0x0001
+
+    /// Event bit: USART activity, or a USART that must be polled for now
+#define PLATFORM_EVENT_USART	0x0002
+
+    /// Event bit: pushbutton activity
+#define PLATFORM_EVENT_PB	0x0004
+
+    /// Event bit: the LED pattern sequencer went idle
+#define PLATFORM_EVENT_LED	0x0008
+
+    /// First event bit free for application use
+#define PLATFORM_EVENT_APP	0x0100
+
+    /**
+     * Mark events as pending
+     *
+     * @note
+     * This may be called from thread mode and from any interrupt handler.
+     *
+     * @param[in]	events	Mask of @code PLATFORM_EVENT_* @endcode bits
+     */
+    void platform_event_post(uint32_t events);
+
+    /**
+     * Sleep (with WFI) until an event is pending
+     *
+     * @note
+     * Interrupt handlers post events for whatever needs the main loop's
+     * attention, and the USART driver keeps posting for as long as it must
+     * be polled (e.g., a reception waiting on its IDLE timeout); with
+     * @c PLATFORM_EVENT_TICK as a backstop, the main loop never sleeps for
+     * longer than one tick while something is due. Call this once per loop,
+     * before @c platform_do_loop_one().
+     *
+     * @return	The pending events, which are then cleared
+     */
+    uint32_t platform_wait_for_event(void);
+
     //////////////////////////////////////////////////////////////////////////////
 
     /// Pushbutton event mask for pressing the on-board button
@@ -45,6 +85,11 @@ extern "C" {
      * Determine which pushbutton events have pressed since this function was last
      * called
      * 
+     * @note
+     * This drains the pushbutton event queue (see @c platform_pb_event_read()),
+     * so a press and a release that both happened since the last call show
+     * up together; use the queue directly to tell their order.
+     * 
      * @return	A bitmask of @code PLATFORM_PB_* @endcode values denoting which
      * 	        event/s occurred
      */
@@ -74,6 +119,102 @@ extern "C" {
      */
     void platform_blink_modify();
 
+    /// Poll TC0 from the event loop, and drive the LED in software
+#define PLATFORM_BLINK_BACKEND_SOFT	0
+
+    /// Drive the LED straight from a TC0 waveform output
+#define PLATFORM_BLINK_BACKEND_PWM	1
+
+    /// Drive the LED from TC0 events, routed by EVSYS to the PORT
+#define PLATFORM_BLINK_BACKEND_EVSYS	2
+
+    /**
+     * Backend used for blinking the LED
+     * 
+     * @note
+     * With @c PLATFORM_BLINK_BACKEND_PWM, TC0 generates the blink on PA15 by
+     * itself; the CPU only touches TC0 when the blink setting changes, and
+     * the edges no longer depend on how often the event loop runs.
+     * @c PLATFORM_BLINK_BACKEND_EVSYS does the same with the LED left on its
+     * PORT output: TC0 compare-match and overflow events set and clear it,
+     * so any pin can blink, not only those with a TC0 waveform output.
+     */
+#if !defined(PLATFORM_BLINK_BACKEND)
+#define PLATFORM_BLINK_BACKEND	PLATFORM_BLINK_BACKEND_PWM
+#endif
+
+    //////////////////////////////////////////////////////////////////////////////
+
+    /**
+     * One step of an LED pattern: a level, held for a duration
+     * 
+     * @note
+     * Build these with @c PLATFORM_LED_ON() and @c PLATFORM_LED_OFF(). A step
+     * lasts from 1 ms up to @c PLATFORM_LED_STEP_MAX_MS, in steps of
+     * 1024/24000 ms (one TC0 count); split longer runs into several steps.
+     */
+    typedef uint16_t platform_led_step_t;
+
+    /// Longest duration of a single step, in ms
+#define PLATFORM_LED_STEP_MAX_MS	2796
+
+    /// A step with the LED lit for @p ms milliseconds
+#define PLATFORM_LED_ON(ms)	((platform_led_step_t) (0x8000u | (ms)))
+
+    /// A step with the LED dark for @p ms milliseconds
+#define PLATFORM_LED_OFF(ms)	((platform_led_step_t) (ms))
+
+    /**
+     * An LED pattern: a run-length table of steps, and how often to play it
+     * 
+     * @note
+     * The pattern, and the table it points to, must stay valid until it has
+     * finished playing; normally both are @c const globals.
+     */
+    typedef struct platform_led_pattern_type {
+        /// Steps, played in order
+        const platform_led_step_t *steps;
+
+        /// Number of steps; must not be zero
+        uint16_t nr_steps;
+
+        /**
+         * Number of times to play the steps, or zero to repeat them until
+         * another pattern is queued
+         */
+        uint16_t repeat;
+    } platform_led_pattern_t;
+
+    /**
+     * Queue a pattern to play once those before it are done
+     * 
+     * @note
+     * While patterns play, they take over the LED (and TC0) from the blink
+     * setting; @c platform_blink_modify() picks up from the current setting
+     * once the queue runs dry, and @c PLATFORM_EVENT_LED is posted. A
+     * pattern queued behind one that repeats forever starts at the end of
+     * its current run.
+     * 
+     * @return @c true if queued, @c false if the queue is full
+     */
+    bool platform_led_pattern_queue(const platform_led_pattern_t *pattern);
+
+    /**
+     * Drop any queued patterns, and play @p pattern right away
+     * 
+     * @param[in]	pattern	Pattern to play, or @c NULL to stop the
+     *                          sequencer and go back to the blink setting
+     */
+    void platform_led_pattern_replace(const platform_led_pattern_t *pattern);
+
+    /// Whether a pattern is playing (and the blink setting is on hold)
+    bool platform_led_pattern_busy(void);
+
+    /// Number of patterns that can be queued behind the one playing
+#if !defined(PLATFORM_LED_QUEUE_LEN)
+#define PLATFORM_LED_QUEUE_LEN	4
+#endif
+
     //////////////////////////////////////////////////////////////////////////////
 
     /**
@@ -112,10 +253,89 @@ extern "C" {
     int platform_timespec_compare(const platform_timespec_t *lhs,
             const platform_timespec_t *rhs);
 
+    /**
+     * Bring @c nr_nsec back onto [0, 999999999], carrying into @c nr_sec
+     * 
+     * @note
+     * The result saturates at @c UINT32_MAX seconds.
+     */
+    void platform_timespec_normalize(platform_timespec_t *ts);
+
+    /**
+     * Add two (normalized) timespec instances
+     * 
+     * @note
+     * Seconds wrap around modulo 2^32, like the tick counts.
+     * 
+     * @param[out]	sum	Sum; may alias either operand
+     * @param[in]	lhs	Left-hand side
+     * @param[in]	rhs	Right-hand side
+     */
+    void platform_timespec_add(platform_timespec_t *sum,
+            const platform_timespec_t *lhs, const platform_timespec_t *rhs);
+
+    /**
+     * Subtract two (normalized) timespec instances
+     * 
+     * @note
+     * Seconds wrap around modulo 2^32; if @c lhs is the later of the two
+     * (by less than 2^32 seconds), the result is their distance.
+     * 
+     * @param[out]	diff	Difference; may alias either operand
+     * @param[in]	lhs	Left-hand side
+     * @param[in]	rhs	Right-hand side
+     */
+    void platform_timespec_sub(platform_timespec_t *diff,
+            const platform_timespec_t *lhs, const platform_timespec_t *rhs);
+
     /// Number of microseconds for a single tick
 #define	PLATFORM_TICK_PERIOD_US	5000
 
-    /// Return the number of ticks since @c platform_init() was called
+    /**
+     * Monotonic tick, in CPU cycles since @c platform_init() was called
+     *
+     * @note
+     * At 24 MHz, 64 bits last for over 24,000 years; ticks can be compared
+     * and subtracted as plain integers, with no wrap-around to handle.
+     */
+    typedef uint64_t platform_tick_t;
+
+    /// Number of monotonic ticks per second (the CPU clock)
+#define PLATFORM_TICK_HZ	24000000UL
+
+    /// Convert microseconds to monotonic ticks
+#define PLATFORM_TICK_FROM_US(us) \
+	((platform_tick_t) (us) * (PLATFORM_TICK_HZ / 1000000))
+
+    /// Convert monotonic ticks to microseconds, rounding down
+#define PLATFORM_TICK_TO_US(t) \
+	((uint64_t) (t) / (PLATFORM_TICK_HZ / 1000000))
+
+    /**
+     * Return the current monotonic tick
+     *
+     * @note
+     * This may be called from thread mode and from any interrupt handler;
+     * it is accurate to the CPU cycle.
+     */
+    platform_tick_t platform_tick_now(void);
+
+    /**
+     * Convert a monotonic tick (or a difference of two) to a timespec
+     *
+     * @param[out]	ts	Timespec
+     * @param[in]	t	Monotonic tick
+     */
+    void platform_tick_to_timespec(platform_timespec_t *ts, platform_tick_t t);
+
+    /**
+     * Return the number of ticks since @c platform_init() was called
+     *
+     * @note
+     * Like the rest of the timespec-based API below, this is meant for
+     * interfacing with code outside the platform; @c platform_tick_now()
+     * is cheaper.
+     */
     void platform_tick_count(platform_timespec_t *tick);
 
     /**
@@ -130,7 +350,8 @@ extern "C" {
      * Get the difference between two ticks
      * 
      * @note
-     * This routine accounts for wrap-arounds, but only once.
+     * This routine accounts for wrap-arounds, but only once; it is the
+     * same as @c platform_timespec_sub().
      * 
      * @param[out]	diff	Difference
      * @param[in]	lhs	Left-hand side
@@ -143,6 +364,478 @@ extern "C" {
 
     //////////////////////////////////////////////////////////////////////////////
 
+    /// Pushbutton ID of the on-board button
+#define PLATFORM_PB_ID_ONBOARD		0
+
+    /// Pushbutton edge: pressed
+#define PLATFORM_PB_EDGE_PRESS		0
+
+    /// Pushbutton edge: released
+#define PLATFORM_PB_EDGE_RELEASE	1
+
+    /// A pushbutton edge, as seen by its interrupt handler
+    typedef struct platform_pb_event_type {
+        /// When the edge was handled
+        platform_tick_t t;
+
+        /// Which button (one of the @code PLATFORM_PB_ID_* @endcode values)
+        uint8_t id;
+
+        /// Which edge (one of the @code PLATFORM_PB_EDGE_* @endcode values)
+        uint8_t edge;
+    } platform_pb_event_t;
+
+    /**
+     * Number of pushbutton events that can be queued; must be a power of two
+     * 
+     * @note
+     * Once the queue is full, further events are dropped (and counted) until
+     * the application catches up.
+     */
+#if !defined(PLATFORM_PB_QUEUE_LEN)
+#define PLATFORM_PB_QUEUE_LEN	16
+#endif
+
+    /**
+     * Take the oldest pushbutton event off the queue
+     * 
+     * @note
+     * Events are queued by the interrupt handler, and taken off by the
+     * application, without either masking interrupts; only one context
+     * may take events off.
+     * 
+     * @param[out]	ev	Event
+     * @return @c true if there was one, @c false if the queue is empty
+     */
+    bool platform_pb_event_read(platform_pb_event_t *ev);
+
+    /// Number of pushbutton events dropped since start-up, for a full queue
+    uint32_t platform_pb_event_overflows(void);
+
+    //////////////////////////////////////////////////////////////////////////////
+
+    /**
+     * Number of slots in the software timer wheel; must be a power of two
+     *
+     * @note
+     * Timers are hashed onto slots by expiry tick, and SysTick visits one
+     * slot per tick; timers further out than this many ticks simply stay
+     * put for another turn of the wheel.
+     */
+#if !defined(PLATFORM_TIMER_WHEEL_SLOTS)
+#define PLATFORM_TIMER_WHEEL_SLOTS	32
+#endif
+
+    struct platform_timer_type;
+
+    /**
+     * Software timer callback
+     *
+     * @param[in]	timer	Timer that expired
+     * @param[in]	arg	Argument given to @c platform_timer_init()
+     */
+    typedef void (*platform_timer_cb_t)(
+            struct platform_timer_type *timer, void *arg);
+
+    /**
+     * Software timer
+     *
+     * @note
+     * Timers run off SysTick, with a resolution of one tick
+     * (@c PLATFORM_TICK_PERIOD_US). Expiry is detected in the SysTick
+     * handler, but callbacks are deferred to @c platform_do_loop_one(), so
+     * they may do anything the main loop does. Callbacks run in the order
+     * their timers expired, and those of timers that expired on the same
+     * tick in the order the timers were started. All members are private.
+     */
+    typedef struct platform_timer_type {
+        struct platform_timer_type *next;
+        struct platform_timer_type **pprev;
+
+        /// Tick on which the timer expires, and its period (zero if one-shot)
+        uint32_t expiry;
+        uint32_t period;
+
+        platform_timer_cb_t cb;
+        void *arg;
+    } platform_timer_t;
+
+    /// Prepare a timer for use; it starts out stopped
+    void platform_timer_init(platform_timer_t *timer,
+            platform_timer_cb_t cb, void *arg);
+
+    /**
+     * Start (or restart) a timer
+     *
+     * @note
+     * The delay is rounded up to whole ticks, and one more is added since
+     * the current tick is already partly over; a timer never expires early,
+     * but may do so up to one tick late. A periodic timer stays on its
+     * original schedule, even if callbacks run late.
+     *
+     * @param[in]	timer		Timer
+     * @param[in]	delay_us	Time until the first expiry
+     * @param[in]	period_us	Time between expiries, or zero for a
+     *                          one-shot timer
+     */
+    void platform_timer_start(platform_timer_t *timer,
+            uint32_t delay_us, uint32_t period_us);
+
+    /**
+     * Stop a timer
+     *
+     * @note
+     * A callback that was already due, but had not run yet, is dropped.
+     *
+     * @return @c true if the timer was running
+     */
+    bool platform_timer_cancel(platform_timer_t *timer);
+
+    /// Whether a timer is running (or due, with its callback yet to run)
+    static inline bool platform_timer_pending(const platform_timer_t *timer) {
+        return timer->pprev != NULL;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+
+    /**
+     * Compile in the hot-path probes
+     * 
+     * @note
+     * Probes time @c platform_do_loop_one(), the USART tick handler,
+     * @c platform_blink_modify() and the SysTick handler in CPU cycles,
+     * from SysTick. With zero (the default), they are removed completely,
+     * along with the API below.
+     */
+#if !defined(PLATFORM_USE_PROBES)
+#define PLATFORM_USE_PROBES	0
+#endif
+
+#if (PLATFORM_USE_PROBES != 0)
+    /// Probe IDs
+#define PLATFORM_PROBE_LOOP		0	// platform_do_loop_one()
+#define PLATFORM_PROBE_USART_TICK	1	// USART tick handler, per port
+#define PLATFORM_PROBE_BLINK		2	// platform_blink_modify()
+#define PLATFORM_PROBE_SYSTICK		3	// SysTick_Handler()
+#define NR_PLATFORM_PROBES		4
+
+    /// Probe statistics, in CPU cycles
+    typedef struct platform_probe_stats_type {
+        /// Probe name
+        const char *name;
+
+        /// Number of runs recorded
+        uint32_t nr_calls;
+
+        /// Shortest, longest and mean run
+        uint32_t min_cycles;
+        uint32_t max_cycles;
+        uint32_t mean_cycles;
+    } platform_probe_stats_t;
+
+    /**
+     * Get a snapshot of a probe's statistics
+     * 
+     * @return	@c false if @p id is out of range
+     */
+    bool platform_probe_get(unsigned int id, platform_probe_stats_t *stats);
+
+    /// Reset every probe's statistics
+    void platform_probe_clear(void);
+
+    /**
+     * Queue a table of every probe's statistics on the on-board debugger port
+     * 
+     * @return	@c false if the previous dump is still being sent, or the
+     *		transmit queue is full
+     */
+    bool platform_probe_dump(void);
+#endif
+
+    //////////////////////////////////////////////////////////////////////////////
+
+    /**
+     * Drive the USART from its SERCOM interrupts, instead of from
+     * @c platform_do_loop_one()
+     * 
+     * @note
+     * Set to zero to fall back to servicing the USART from the event loop,
+     * which caps throughput to how fast the application loop spins.
+     */
+#if !defined(PLATFORM_USART_USE_IRQ)
+#define PLATFORM_USART_USE_IRQ	1
+#endif
+
+    /**
+     * Clock the USART from the 48 MHz DFLL (via GCLK_GEN3), instead of from
+     * the 4 MHz GCLK_GEN2
+     * 
+     * @note
+     * This makes rates of 460800 baud up to 1 Mbaud usable (8x oversampling
+     * keeps their error well under 2%), at the cost of the DFLL's power
+     * draw. Rates are still chosen via @c platform_usart_configure().
+     */
+#if !defined(PLATFORM_USART_HIGH_SPEED)
+#define PLATFORM_USART_HIGH_SPEED	0
+#endif
+
+    /**
+     * Enable RTS/CTS hardware flow control on the data link
+     * 
+     * @note
+     * CTS holds back the transmitter in hardware. RTS is deasserted by the
+     * SERCOM once its receive buffer fills up, which the driver lets happen
+     * by no longer draining it once the reception ring is (nearly) full.
+     * 
+     * @note
+     * Requires @c PLATFORM_USART_USE_LINK. The port via the on-board
+     * debugger has no confirmed RTS/CTS pins, and never uses flow control.
+     */
+#if !defined(PLATFORM_USART_FLOW_CONTROL)
+#define PLATFORM_USART_FLOW_CONTROL	0
+#endif
+
+    /// Move USART data with the CPU (interrupt- or loop-driven)
+#define PLATFORM_USART_BACKEND_PIO	0
+
+    /// Move USART data with the DMAC
+#define PLATFORM_USART_BACKEND_DMA	1
+
+    /**
+     * Backend used for USART transmission
+     * 
+     * @note
+     * With @c PLATFORM_USART_BACKEND_DMA, a whole fragment array goes out
+     * with no CPU involvement per character.
+     */
+#if !defined(PLATFORM_USART_TX_BACKEND)
+#define PLATFORM_USART_TX_BACKEND	PLATFORM_USART_BACKEND_PIO
+#endif
+
+    /**
+     * Backend used for USART reception
+     * 
+     * @note
+     * With @c PLATFORM_USART_BACKEND_DMA, the DMAC continuously fills a
+     * circular buffer owned by the driver, so characters are not lost while
+     * no reception is enqueued or while the application is busy. Line breaks
+     * are then only detected with auto-baud; see
+     * @c PLATFORM_USART_RX_COMPL_BREAK.
+     */
+#if !defined(PLATFORM_USART_RX_BACKEND)
+#define PLATFORM_USART_RX_BACKEND	PLATFORM_USART_BACKEND_PIO
+#endif
+
+    /**
+     * Size of the streaming reception ring, in characters
+     * 
+     * @note
+     * Must be a power of two, no larger than 32768. With the DMA reception
+     * backend, this is also the size of the DMA buffer.
+     */
+#if !defined(PLATFORM_USART_RX_RING_SIZE)
+#define PLATFORM_USART_RX_RING_SIZE	256
+#endif
+
+    /**
+     * Size of the streaming transmission ring, in characters
+     * 
+     * @note
+     * Must be a power of two, no larger than 32768.
+     */
+#if !defined(PLATFORM_USART_TX_RING_SIZE)
+#define PLATFORM_USART_TX_RING_SIZE	256
+#endif
+
+    /**
+     * Number of fragment arrays that may be queued for transmission
+     * 
+     * @note
+     * Must be a power of two, no larger than 256.
+     */
+#if !defined(PLATFORM_USART_TX_QUEUE_LEN)
+#define PLATFORM_USART_TX_QUEUE_LEN	8
+#endif
+
+    /**
+     * Enable the SERCOM hardware FIFOs
+     * 
+     * @note
+     * With the FIFOs, each interrupt (or tick) moves as many characters as
+     * the FIFO holds or has room for, instead of just one.
+     */
+#if !defined(PLATFORM_USART_USE_FIFO)
+#define PLATFORM_USART_USE_FIFO	1
+#endif
+
+    /**
+     * Receive FIFO threshold (value for CTRLC.RXTRHOLD)
+     * 
+     * @note
+     * RXC is raised once the receive FIFO holds at least this many
+     * characters (0: 1, 1: 2, 2: 3, 3: 4). Characters below the threshold are
+     * picked up by the tick, so that the IDLE timeout still works. Forced
+     * to zero with the DMA reception backend.
+     */
+#if !defined(PLATFORM_USART_FIFO_RX_THRESHOLD)
+#define PLATFORM_USART_FIFO_RX_THRESHOLD	1
+#endif
+
+    /**
+     * Transmit FIFO threshold (value for CTRLC.TXTRHOLD)
+     * 
+     * @note
+     * DRE is raised once the transmit FIFO has room for at least this many
+     * characters (0: 1, 1: 2, 2: 3, 3: 4). Forced to zero with the DMA
+     * transmission backend.
+     */
+#if !defined(PLATFORM_USART_FIFO_TX_THRESHOLD)
+#define PLATFORM_USART_FIFO_TX_THRESHOLD	2
+#endif
+
+    /**
+     * Bring up a second USART port (data link) on SERCOM0, alongside the
+     * one via the on-board debugger
+     * 
+     * @note
+     * Pins: PA04 (TX, PAD[0]) and PA05 (RX, PAD[1]); with
+     * @c PLATFORM_USART_FLOW_CONTROL, also PA06 (RTS, PAD[2]) and PA07
+     * (CTS, PAD[3]). Every setting above except flow control applies to
+     * both ports, but each has its own rings, queue, line settings and
+     * statistics.
+     */
+#if !defined(PLATFORM_USART_USE_LINK)
+#define PLATFORM_USART_USE_LINK	0
+#endif
+
+#if ((PLATFORM_USART_RX_RING_SIZE & (PLATFORM_USART_RX_RING_SIZE - 1)) != 0) || \
+    (PLATFORM_USART_RX_RING_SIZE > 32768)
+#error "PLATFORM_USART_RX_RING_SIZE must be a power of two, up to 32768"
+#endif
+#if ((PLATFORM_USART_TX_RING_SIZE & (PLATFORM_USART_TX_RING_SIZE - 1)) != 0) || \
+    (PLATFORM_USART_TX_RING_SIZE > 32768)
+#error "PLATFORM_USART_TX_RING_SIZE must be a power of two, up to 32768"
+#endif
+#if ((PLATFORM_USART_TX_QUEUE_LEN & (PLATFORM_USART_TX_QUEUE_LEN - 1)) != 0) || \
+    (PLATFORM_USART_TX_QUEUE_LEN > 256)
+#error "PLATFORM_USART_TX_QUEUE_LEN must be a power of two, up to 256"
+#endif
+#if (PLATFORM_USART_FIFO_RX_THRESHOLD > 3) || (PLATFORM_USART_FIFO_TX_THRESHOLD > 3)
+#error "PLATFORM_USART_FIFO_*_THRESHOLD must be within [0, 3]"
+#endif
+
+    /// No parity bit
+#define PLATFORM_USART_PARITY_NONE	0
+
+    /// Even parity
+#define PLATFORM_USART_PARITY_EVEN	1
+
+    /// Odd parity
+#define PLATFORM_USART_PARITY_ODD	2
+
+    /// USART line settings
+
+    typedef struct platform_usart_config_type {
+        /// Target baud rate, in bits per second
+        uint32_t baud;
+
+        /// Number of data bits per character, within [5, 8]
+        uint8_t data_bits;
+
+        /// One of @code PLATFORM_USART_PARITY_* @endcode
+        uint8_t parity;
+
+        /// Number of stop bits, either 1 or 2
+        uint8_t stop_bits;
+
+        /**
+         * Samples per bit: 16, 8 or 3
+         * 
+         * @note
+         * For 16 and 8, whichever of arithmetic or fractional baud
+         * generation gets closer to @c baud is used.
+         */
+        uint8_t oversampling;
+
+        /**
+         * Follow the host's baud rate (non-zero) or not (zero)
+         * 
+         * @note
+         * The SERCOM then measures the sync field (0x55) that follows each
+         * break, and retunes itself; @c baud is only the initial guess.
+         * Requires 16x oversampling.
+         */
+        uint8_t autobaud;
+    } platform_usart_config_t;
+
+    /// Line settings applied by @c platform_init() to the on-board debugger port
+#if !defined(PLATFORM_USART_CONFIG_DEFAULT)
+#define PLATFORM_USART_CONFIG_DEFAULT \
+	{57600, 8, PLATFORM_USART_PARITY_EVEN, 1, 16, 0}
+#endif
+
+    /// Line settings applied by @c platform_init() to the data-link port
+#if !defined(PLATFORM_USART_LINK_CONFIG_DEFAULT)
+#define PLATFORM_USART_LINK_CONFIG_DEFAULT	PLATFORM_USART_CONFIG_DEFAULT
+#endif
+
+    /**
+     * Handle to a USART port
+     * 
+     * @note
+     * A handle is the address of the port's driver state, so every call on
+     * a port goes straight to it; use the @code PLATFORM_USART_CDC @endcode
+     * and @code PLATFORM_USART_LINK @endcode macros to obtain one.
+     */
+    typedef struct platform_usart_port_type platform_usart_port_t;
+
+    // Per-port driver state; only ever referred to via the macros below
+    extern platform_usart_port_t platform_usart_port_cdc;
+#if (PLATFORM_USART_USE_LINK != 0)
+    extern platform_usart_port_t platform_usart_port_link;
+#endif
+
+    /// USART port via the on-board debugger (SERCOM3)
+#define PLATFORM_USART_CDC	(&platform_usart_port_cdc)
+
+#if (PLATFORM_USART_USE_LINK != 0)
+    /// USART port for the data link (SERCOM0)
+#define PLATFORM_USART_LINK	(&platform_usart_port_link)
+#endif
+
+    /**
+     * Change the USART line settings
+     * 
+     * @note
+     * The BAUD register value and the IDLE timeout (three characters' worth)
+     * are computed from @c cfg. The change is refused while anything is
+     * queued for transmission; once accepted, this waits for the last
+     * character to leave, then briefly disables the SERCOM, so anything
+     * being received at that moment may be lost.
+     * 
+     * @p	port	Port handle
+     * @p	cfg		New line settings
+     * @p	baud_err_ppm	If not @c NULL, receives the error of the
+     *			resulting baud rate against @c cfg->baud, in parts
+     *			per million (whenever that rate is attainable)
+     * 
+     * @return	@c true if the settings were applied, @c false if they are
+     *		invalid or unattainable, or if the transmitter is busy
+     */
+    bool platform_usart_configure(platform_usart_port_t *port,
+            const platform_usart_config_t *cfg,
+            int32_t *baud_err_ppm);
+
+    /**
+     * Get the current USART baud rate
+     * 
+     * @note
+     * With auto-baud, this is the rate measured from the latest sync field
+     * that a character has since followed (as of the last call to
+     * @c platform_do_loop_one()).
+     */
+    uint32_t platform_usart_get_baud(platform_usart_port_t *port);
+
     /// Descriptor for reception via USART
 
     typedef struct platform_usart_rx_desc_type {
@@ -165,10 +858,35 @@ extern "C" {
          * Reception completed with a line break
          * 
          * @note
-         * This completion event is not implemented in this sample.
+         * With auto-baud, this is the SERCOM's own break detection (even if
+         * no usable sync field follows). The SERCOM only detects breaks in
+         * its auto-baud frame formats, which also retune the baud rate, so
+         * it cannot be had on its own.
+         * 
+         * @note
+         * Without auto-baud, a break is inferred from a NUL character with a
+         * framing error, by the CPU reception backend only. With the DMA
+         * reception backend (and no auto-baud), breaks are NOT detected:
+         * they complete as @c PLATFORM_USART_RX_COMPL_ERR_FRAME, and are not
+         * counted in @c nr_breaks.
          */
 #define PLATFORM_USART_RX_COMPL_BREAK	0x0002
 
+        /// Reception cut short by a character with a framing error
+#define PLATFORM_USART_RX_COMPL_ERR_FRAME	0x0003
+
+        /// Reception cut short by a character with a parity error
+#define PLATFORM_USART_RX_COMPL_ERR_PARITY	0x0004
+
+        /**
+         * Reception cut short by lost characters
+         * 
+         * @note
+         * Characters are lost either inside the SERCOM (receiver overrun),
+         * or because the reception ring was full.
+         */
+#define PLATFORM_USART_RX_COMPL_ERR_OVERFLOW	0x0005
+
         /// Extra information about a completion event, if applicable
 
         volatile union {
@@ -176,7 +894,11 @@ extern "C" {
              * Number of bytes that were received
              * 
              * @note
-             * This member is valid only if @code compl_type == PLATFORM_USART_RX_COMPL_DATA @endcode.
+             * This member is valid only if @code compl_type == PLATFORM_USART_RX_COMPL_DATA @endcode,
+             * or for @c PLATFORM_USART_RX_COMPL_BREAK and the
+             * @code PLATFORM_USART_RX_COMPL_ERR_* @endcode types (counting
+             * the good characters received before the event; the break or
+             * offending character itself is dropped).
              */
             uint16_t data_len;
         } compl_info;
@@ -193,26 +915,78 @@ extern "C" {
     } platform_usart_tx_bufdesc_t;
 
     /**
-     * Enqueue an array of fragments for transmission
+     * Completion callback for a queued fragment array
+     * 
+     * @note
+     * This is invoked from whatever context drives the transmitter (an
+     * interrupt handler, or @c platform_do_loop_one() without interrupts),
+     * so it must be short. Once it is called, the fragment array and its
+     * buffers may be reused.
+     * 
+     * @p	arg	Opaque pointer given at submission
+     * @p	seq	Sequence number of the completed fragment array
+     */
+    typedef void (*platform_usart_tx_cb_t)(void *arg, uint16_t seq);
+
+    /**
+     * Queue an array of fragments for transmission
+     * 
+     * @note
+     * All fragment-array elements and source buffer/s must remain valid until
+     * the array has been sent, as signalled by @c cb or by
+     * @c platform_usart_tx_seq_done(). Queued arrays go out back-to-back,
+     * in submission order.
+     * 
+     * @p	port	Port handle
+     * @p	desc	Descriptor array
+     * @p	nr_desc	Number of descriptors
+     * @p	cb	Completion callback; may be @c NULL
+     * @p	arg	Opaque pointer passed to @c cb
+     * 
+     * @return	Non-zero sequence number of the array if it is successfully
+     *		queued, zero otherwise (queue full or array invalid)
+     */
+    uint16_t platform_usart_tx_submit(platform_usart_port_t *port,
+            const platform_usart_tx_bufdesc_t *desc, unsigned int nr_desc,
+            platform_usart_tx_cb_t cb, void *arg);
+
+    /**
+     * Get the sequence number of the most recently completed fragment array
+     * 
+     * @note
+     * Sequence numbers wrap around (skipping zero); to check whether array
+     * @c seq is done, use @code (int16_t) (platform_usart_tx_seq_done(port) - seq) >= 0 @endcode.
+     */
+    uint16_t platform_usart_tx_seq_done(platform_usart_port_t *port);
+
+    /**
+     * Queue an array of fragments for transmission, without a callback
      * 
      * @note
      * All fragment-array elements and source buffer/s must remain valid for the
      * entire time transmission is on-going.
      * 
+     * @p	port	Port handle
      * @p	desc	Descriptor array
      * @p	nr_desc	Number of descriptors
      * 
      * @return	@c true if the transmission is successfully enqueued, @c false
-     *		otherwise
+     *		otherwise (e.g., if the queue is full)
      */
-    bool platform_usart_cdc_tx_async(const platform_usart_tx_bufdesc_t *desc,
-            unsigned int nr_desc);
+    bool platform_usart_tx_async(platform_usart_port_t *port,
+            const platform_usart_tx_bufdesc_t *desc, unsigned int nr_desc);
 
-    /// Abort an ongoing transmission
-    void platform_usart_cdc_tx_abort(void);
+    /**
+     * Abort an ongoing transmission
+     * 
+     * @note
+     * This also drops every queued fragment array (without invoking their
+     * callbacks) and empties the streaming transmission ring.
+     */
+    void platform_usart_tx_abort(platform_usart_port_t *port);
 
     /// Check whether a transmission is on-going
-    bool platform_usart_cdc_tx_busy(void);
+    bool platform_usart_tx_busy(platform_usart_port_t *port);
 
     /**
      * Enqueue a request for data reception
@@ -221,18 +995,188 @@ extern "C" {
      * Both descriptor and target buffer must remain valid for the entire time
      * reception is on-going.
      * 
+     * @p	port	Port handle
      * @p	desc	Descriptor
      * 
      * @return	@c true if the reception is successfully enqueued, @c false
      *		otherwise
      */
-    bool platform_usart_cdc_rx_async(platform_usart_rx_async_desc_t *desc);
+    bool platform_usart_rx_async(platform_usart_port_t *port,
+            platform_usart_rx_async_desc_t *desc);
 
     /// Abort an ongoing transmission
-    void platform_usart_cdc_rx_abort(void);
+    void platform_usart_rx_abort(platform_usart_port_t *port);
 
     /// Check whether a reception is on-going
-    bool platform_usart_cdc_rx_busy(void);
+    bool platform_usart_rx_busy(platform_usart_port_t *port);
+
+    /**
+     * Read characters from the streaming reception ring
+     * 
+     * @note
+     * Every received character passes through this ring. While a reception
+     * descriptor is pending (see @c platform_usart_rx_async()), the
+     * ring is drained into that descriptor instead, and this function
+     * returns zero.
+     * 
+     * @p	port	Port handle
+     * @p	buf	Destination buffer
+     * @p	len	Maximum number of characters to read
+     * 
+     * @return	Number of characters actually read
+     */
+    uint16_t platform_usart_read(platform_usart_port_t *port,
+            void *buf, uint16_t len);
+
+    /// Get the number of characters waiting in the streaming reception ring
+    uint16_t platform_usart_rx_available(platform_usart_port_t *port);
+
+    /**
+     * Write characters into the streaming transmission ring
+     * 
+     * @note
+     * The ring is drained whenever no fragment array (see
+     * @c platform_usart_tx_submit()) is queued; queued arrays take
+     * precedence.
+     * 
+     * @p	port	Port handle
+     * @p	buf	Source buffer; copied before this function returns
+     * @p	len	Number of characters to write
+     * 
+     * @return	Number of characters actually accepted, which may be less
+     *		than @c len if the ring is full
+     */
+    uint16_t platform_usart_write(platform_usart_port_t *port,
+            const void *buf, uint16_t len);
+
+    /// Get the free space in the streaming transmission ring
+    uint16_t platform_usart_tx_space(platform_usart_port_t *port);
+
+    /// USART driver statistics, counted since @c platform_init()
+
+    typedef struct platform_usart_stats_type {
+        /// Number of characters handed to the transmitter
+        uint32_t nr_tx_chars;
+
+        /// Number of characters taken from the receiver without errors
+        uint32_t nr_rx_chars;
+
+        /// Number of characters received with errors (and dropped), by type
+        uint32_t nr_err_frame;
+        uint32_t nr_err_parity;
+
+        /// Number of receiver overruns (characters lost inside the SERCOM)
+        uint32_t nr_err_overflow;
+
+        /// Number of characters dropped because the reception ring was full
+        uint32_t nr_rx_dropped;
+
+        /// Number of reception-descriptor completions, by cause
+        uint32_t nr_compl_idle;
+        uint32_t nr_compl_full;
+        uint32_t nr_compl_error;
+
+        /// Highest fill levels seen (queued arrays, ring characters)
+        uint16_t hwm_tx_queue;
+        uint16_t hwm_tx_ring;
+        uint16_t hwm_rx_ring;
+
+        /// Number of SERCOM interrupts taken, per IRQ line
+        uint32_t nr_irq_dre;
+        uint32_t nr_irq_txc;
+        uint32_t nr_irq_rxc;
+        uint32_t nr_irq_other;
+
+        /// Number of break + sync sequences the auto-baud logic locked onto
+        uint32_t nr_autobaud_sync;
+
+        /// Number of breaks whose sync field the auto-baud logic rejected
+        uint32_t nr_bad_sync;
+
+        /// Number of line breaks detected
+        uint32_t nr_breaks;
+    } platform_usart_stats_t;
+
+    /**
+     * Get a snapshot of the USART driver statistics
+     * 
+     * @note
+     * The snapshot is taken with interrupts masked, so all counters are
+     * mutually consistent. Comparing the character counts against the
+     * interrupt counts shows how many characters each interrupt moves.
+     * 
+     * @p	port	Port handle
+     * @p	stats	Destination
+     */
+    void platform_usart_stats(platform_usart_port_t *port,
+            platform_usart_stats_t *stats);
+
+    /// Reset all USART driver statistics (including high-water marks) to zero
+    void platform_usart_stats_clear(platform_usart_port_t *port);
+
+    /*
+     * Shorthands for the on-board debugger port
+     */
+
+    static inline uint16_t platform_usart_cdc_tx_submit(
+            const platform_usart_tx_bufdesc_t *desc, unsigned int nr_desc,
+            platform_usart_tx_cb_t cb, void *arg) {
+        return platform_usart_tx_submit(PLATFORM_USART_CDC, desc, nr_desc, cb, arg);
+    }
+
+    static inline uint16_t platform_usart_cdc_tx_seq_done(void) {
+        return platform_usart_tx_seq_done(PLATFORM_USART_CDC);
+    }
+
+    static inline bool platform_usart_cdc_tx_async(
+            const platform_usart_tx_bufdesc_t *desc, unsigned int nr_desc) {
+        return platform_usart_tx_async(PLATFORM_USART_CDC, desc, nr_desc);
+    }
+
+    static inline void platform_usart_cdc_tx_abort(void) {
+        platform_usart_tx_abort(PLATFORM_USART_CDC);
+    }
+
+    static inline bool platform_usart_cdc_tx_busy(void) {
+        return platform_usart_tx_busy(PLATFORM_USART_CDC);
+    }
+
+    static inline bool platform_usart_cdc_rx_async(
+            platform_usart_rx_async_desc_t *desc) {
+        return platform_usart_rx_async(PLATFORM_USART_CDC, desc);
+    }
+
+    static inline void platform_usart_cdc_rx_abort(void) {
+        platform_usart_rx_abort(PLATFORM_USART_CDC);
+    }
+
+    static inline bool platform_usart_cdc_rx_busy(void) {
+        return platform_usart_rx_busy(PLATFORM_USART_CDC);
+    }
+
+    static inline uint16_t platform_usart_cdc_read(void *buf, uint16_t len) {
+        return platform_usart_read(PLATFORM_USART_CDC, buf, len);
+    }
+
+    static inline uint16_t platform_usart_cdc_rx_available(void) {
+        return platform_usart_rx_available(PLATFORM_USART_CDC);
+    }
+
+    static inline uint16_t platform_usart_cdc_write(const void *buf, uint16_t len) {
+        return platform_usart_write(PLATFORM_USART_CDC, buf, len);
+    }
+
+    static inline uint16_t platform_usart_cdc_tx_space(void) {
+        return platform_usart_tx_space(PLATFORM_USART_CDC);
+    }
+
+    static inline void platform_usart_cdc_stats(platform_usart_stats_t *stats) {
+        platform_usart_stats(PLATFORM_USART_CDC, stats);
+    }
+
+    static inline void platform_usart_cdc_stats_clear(void) {
+        platform_usart_stats_clear(PLATFORM_USART_CDC);
+    }
 
     //////////////////////////////////////////////////////////////////////////////
 
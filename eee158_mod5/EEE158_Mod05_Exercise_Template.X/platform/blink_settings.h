@@ -7,6 +7,7 @@ typedef enum {
     MEDIUM,
     FAST,
     ON,
+    BREATHE,
     NUM_SETTINGS
 } BlinkSetting;
 
@@ -0,0 +1,190 @@
+/**
+ * @file platform/dmac.c
+ * @brief Platform-support routines, DMAC component
+ */
+
+/*
+ * PIC32CM5164LS00048 initial configuration:
+ * -- Architecture: ARMv8 Cortex-M23
+ * -- GCLK_GEN0: OSC16M @ 4 MHz, no additional prescaler
+ * -- Main Clock: No additional prescaling (always uses GCLK_GEN0 as input)
+ * -- Mode: Secure, NONSEC disabled
+ *
+ * The DMAC runs off the AHB/APB clocks only; no GCLK channel is needed.
+ */
+
+// Common include for the XC32 compiler
+#include <xc.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "../platform.h"
+#include "dmac.h"
+
+// Functions "exported" by this file
+void platform_dmac_init(void);
+
+/////////////////////////////////////////////////////////////////////////////
+
+/*
+ * Descriptor memory
+ *
+ * The DMAC fetches the first descriptor of channel N from base[N], and
+ * writes the channel state back to wb[N] whenever it is suspended or
+ * interrupted.
+ */
+static platform_dmac_desc_t dmac_desc_base[NR_PLATFORM_DMAC_CH];
+static platform_dmac_desc_t dmac_desc_wb[NR_PLATFORM_DMAC_CH];
+
+// Per-channel completion callbacks
+static struct {
+    platform_dmac_cb_t cb;
+    void *arg;
+} dmac_ch_cb[NR_PLATFORM_DMAC_CH];
+
+void platform_dmac_init(void) {
+    /*
+     * Enable the AHB/APB clocks for this peripheral
+     *
+     * NOTE: The chip resets with them enabled; hence, commented-out.
+     */
+    //MCLK_REGS->MCLK_AHBMASK |= (1 << 5);
+
+    // Reset; DMAENABLE must be cleared before SWRST takes effect.
+    DMAC_REGS->DMAC_CTRL = 0x0000;
+    DMAC_REGS->DMAC_CTRL = (1 << 0);
+    while ((DMAC_REGS->DMAC_CTRL & (1 << 0)) != 0)
+        asm("nop");
+
+    memset(dmac_desc_base, 0, sizeof (dmac_desc_base));
+    memset(dmac_desc_wb, 0, sizeof (dmac_desc_wb));
+    memset(dmac_ch_cb, 0, sizeof (dmac_ch_cb));
+    DMAC_REGS->DMAC_BASEADDR = (uint32_t) (uintptr_t) dmac_desc_base;
+    DMAC_REGS->DMAC_WRBADDR = (uint32_t) (uintptr_t) dmac_desc_wb;
+
+    // Enable, with all four priority levels
+    DMAC_REGS->DMAC_CTRL = (0xF << 8) | (1 << 1);
+    return;
+}
+
+platform_dmac_desc_t *platform_dmac_desc_base(unsigned int ch) {
+    return &dmac_desc_base[ch];
+}
+
+platform_dmac_desc_t *platform_dmac_desc_wb(unsigned int ch) {
+    return &dmac_desc_wb[ch];
+}
+
+/*
+ * The channel registers are banked behind CHID. Since both application code
+ * and interrupt handlers select channels, selection + access must happen
+ * with interrupts masked.
+ */
+void platform_dmac_ch_setup(unsigned int ch, uint32_t chctrlb, uint8_t inten,
+        platform_dmac_cb_t cb, void *arg) {
+    uint32_t primask = __get_PRIMASK();
+
+    __disable_irq();
+    dmac_ch_cb[ch].cb = cb;
+    dmac_ch_cb[ch].arg = arg;
+
+    DMAC_REGS->DMAC_CHID = ch;
+    DMAC_REGS->DMAC_CHCTRLA = 0x00;
+    DMAC_REGS->DMAC_CHCTRLA = (1 << 0);
+    while ((DMAC_REGS->DMAC_CHCTRLA & (1 << 0)) != 0)
+        asm("nop");
+    DMAC_REGS->DMAC_CHCTRLB = chctrlb;
+    DMAC_REGS->DMAC_CHINTENCLR = 0x07;
+    DMAC_REGS->DMAC_CHINTFLAG = 0x07;
+    DMAC_REGS->DMAC_CHINTENSET = inten;
+    __set_PRIMASK(primask);
+    return;
+}
+
+void platform_dmac_ch_enable(unsigned int ch) {
+    uint32_t primask = __get_PRIMASK();
+
+    __disable_irq();
+    DMAC_REGS->DMAC_CHID = ch;
+    DMAC_REGS->DMAC_CHCTRLA |= (1 << 1);
+    __set_PRIMASK(primask);
+    return;
+}
+
+void platform_dmac_ch_disable(unsigned int ch) {
+    uint32_t primask = __get_PRIMASK();
+
+    __disable_irq();
+    DMAC_REGS->DMAC_CHID = ch;
+    DMAC_REGS->DMAC_CHCTRLA &= ~(1 << 1);
+    while ((DMAC_REGS->DMAC_CHCTRLA & (1 << 1)) != 0)
+        asm("nop");
+    DMAC_REGS->DMAC_CHINTFLAG = 0x07;
+    __set_PRIMASK(primask);
+    return;
+}
+
+static void dmac_ch_command(unsigned int ch, uint32_t cmd) {
+    uint32_t primask = __get_PRIMASK();
+
+    __disable_irq();
+    DMAC_REGS->DMAC_CHID = ch;
+    DMAC_REGS->DMAC_CHCTRLB = (DMAC_REGS->DMAC_CHCTRLB & ~(0x3 << 24)) | cmd;
+    __set_PRIMASK(primask);
+    return;
+}
+
+void platform_dmac_ch_suspend(unsigned int ch) {
+    dmac_ch_command(ch, DMAC_CHCTRLB_CMD_SUSPEND);
+}
+
+void platform_dmac_ch_resume(unsigned int ch) {
+    dmac_ch_command(ch, DMAC_CHCTRLB_CMD_RESUME);
+}
+
+bool platform_dmac_ch_pending(unsigned int ch) {
+    return (DMAC_REGS->DMAC_INTSTATUS & (1u << ch)) != 0;
+}
+
+uint16_t platform_dmac_ch_btcnt(unsigned int ch) {
+    uint32_t active = DMAC_REGS->DMAC_ACTIVE;
+
+    if ((active & DMAC_ACTIVE_ABUSY) != 0 && DMAC_ACTIVE_ID(active) == ch)
+        return DMAC_ACTIVE_BTCNT(active);
+    return dmac_desc_wb[ch].btcnt;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+// Common channel interrupt handling
+
+static void dmac_ch_handler_common(unsigned int ch) {
+    uint8_t chid = DMAC_REGS->DMAC_CHID;
+    uint8_t flags;
+
+    // Application code might be in the middle of a CHID access.
+    DMAC_REGS->DMAC_CHID = ch;
+    flags = DMAC_REGS->DMAC_CHINTFLAG;
+    DMAC_REGS->DMAC_CHINTFLAG = flags;
+    DMAC_REGS->DMAC_CHID = chid;
+
+    if (dmac_ch_cb[ch].cb != NULL)
+        dmac_ch_cb[ch].cb(dmac_ch_cb[ch].arg, flags);
+    return;
+}
+
+void __attribute__((used, interrupt())) DMAC_0_Handler(void) {
+    dmac_ch_handler_common(0);
+}
+
+void __attribute__((used, interrupt())) DMAC_1_Handler(void) {
+    dmac_ch_handler_common(1);
+}
+
+void __attribute__((used, interrupt())) DMAC_2_Handler(void) {
+    dmac_ch_handler_common(2);
+}
+
+void __attribute__((used, interrupt())) DMAC_3_Handler(void) {
+    dmac_ch_handler_common(3);
+}
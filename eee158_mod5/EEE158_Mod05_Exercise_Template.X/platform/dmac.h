@@ -0,0 +1,132 @@
+/**
+ * @file  platform/dmac.h
+ * @brief Platform-internal declarations, DMAC component
+ *
+ * NOTE: This header is only meant for the platform/ sources; applications
+ *       should stick to platform.h.
+ */
+
+#if !defined(EEE158_EX05_PLATFORM_DMAC_H_)
+#define EEE158_EX05_PLATFORM_DMAC_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * DMAC transfer descriptor, as laid out in SRAM
+ *
+ * NOTE: The DMAC requires descriptors to be 128-bit aligned.
+ */
+typedef struct platform_dmac_desc_type {
+    volatile uint16_t btctrl;
+    volatile uint16_t btcnt;
+    volatile uint32_t srcaddr;
+    volatile uint32_t dstaddr;
+    volatile uint32_t descaddr;
+} __attribute__((aligned(16))) platform_dmac_desc_t;
+
+// BTCTRL fields
+#define DMAC_BTCTRL_VALID		(1 << 0)
+#define DMAC_BTCTRL_BLOCKACT_NOACT	(0x0 << 3)
+#define DMAC_BTCTRL_BLOCKACT_INT	(0x1 << 3)
+#define DMAC_BTCTRL_BEATSIZE_BYTE	(0x0 << 8)
+#define DMAC_BTCTRL_BEATSIZE_HWORD	(0x1 << 8)
+#define DMAC_BTCTRL_SRCINC		(1 << 10)
+#define DMAC_BTCTRL_DSTINC		(1 << 11)
+
+// CHCTRLB fields
+#define DMAC_CHCTRLB_TRIGSRC(x)		((uint32_t)(x) << 8)
+#define DMAC_CHCTRLB_TRIGACT_BEAT	(0x2 << 22)
+#define DMAC_CHCTRLB_CMD_SUSPEND	(0x1 << 24)
+#define DMAC_CHCTRLB_CMD_RESUME		(0x2 << 24)
+
+// ACTIVE fields
+#define DMAC_ACTIVE_ID(x)		(((x) >> 8) & 0x1F)
+#define DMAC_ACTIVE_ABUSY		(1 << 15)
+#define DMAC_ACTIVE_BTCNT(x)		((uint16_t) ((x) >> 16))
+
+// CHINTFLAG bits
+#define DMAC_CHINT_TERR			(1 << 0)
+#define DMAC_CHINT_TCMPL		(1 << 1)
+#define DMAC_CHINT_SUSP			(1 << 2)
+
+/*
+ * Peripheral trigger sources (datasheet, DMAC "Peripheral Trigger Source"
+ * table). Only those used by the platform are listed.
+ */
+#define DMAC_TRIG_SERCOM0_RX		(0x04)
+#define DMAC_TRIG_SERCOM0_TX		(0x05)
+#define DMAC_TRIG_SERCOM3_RX		(0x0A)
+#define DMAC_TRIG_SERCOM3_TX		(0x0B)
+#define DMAC_TRIG_TC0_OVF		(0x12)
+
+/*
+ * Channel assignments
+ *
+ * NOTE: Only channels 0-3 have dedicated IRQ lines; keep every channel that
+ *       needs a completion callback within that range.
+ */
+#define PLATFORM_DMAC_CH_USART_TX	0
+#define PLATFORM_DMAC_CH_USART_RX	1
+#define PLATFORM_DMAC_CH_LINK_TX	2
+#define PLATFORM_DMAC_CH_LINK_RX	3
+#define PLATFORM_DMAC_CH_BLINK		4
+#define NR_PLATFORM_DMAC_CH		5
+
+/**
+ * Channel callback, invoked from the DMAC interrupt
+ *
+ * @param[in]	arg	Opaque pointer given to @c platform_dmac_ch_setup()
+ * @param[in]	flags	CHINTFLAG bits that were raised (already cleared)
+ */
+typedef void (*platform_dmac_cb_t)(void *arg, uint8_t flags);
+
+/// Get the first (base) descriptor of a channel
+platform_dmac_desc_t *platform_dmac_desc_base(unsigned int ch);
+
+/// Get the write-back descriptor of a channel
+platform_dmac_desc_t *platform_dmac_desc_wb(unsigned int ch);
+
+/**
+ * Reset and configure a channel, leaving it disabled
+ *
+ * @param[in]	ch	Channel number
+ * @param[in]	chctrlb	Value for CHCTRLB (trigger source/action, etc.)
+ * @param[in]	inten	CHINTFLAG bits to raise an interrupt for
+ * @param[in]	cb	Completion callback; may be @c NULL
+ * @param[in]	arg	Opaque pointer passed to @c cb
+ */
+void platform_dmac_ch_setup(unsigned int ch, uint32_t chctrlb, uint8_t inten,
+        platform_dmac_cb_t cb, void *arg);
+
+/// Enable a channel, starting from its base descriptor
+void platform_dmac_ch_enable(unsigned int ch);
+
+/// Disable a channel, waiting for any on-going beat to finish
+void platform_dmac_ch_disable(unsigned int ch);
+
+/// Suspend a channel; it keeps its place, but ignores further triggers
+void platform_dmac_ch_suspend(unsigned int ch);
+
+/// Resume a channel suspended via @c platform_dmac_ch_suspend()
+void platform_dmac_ch_resume(unsigned int ch);
+
+/**
+ * Check whether a channel has an enabled interrupt flag raised, i.e., an
+ * event that has yet to reach its callback
+ *
+ * @note
+ * This reads INTSTATUS, so the channel selection (CHID) is left alone.
+ */
+bool platform_dmac_ch_pending(unsigned int ch);
+
+/**
+ * Get the number of beats left in the current block of a channel
+ *
+ * @note
+ * This is the live count if the channel currently owns the DMAC, and the
+ * write-back copy otherwise.
+ */
+uint16_t platform_dmac_ch_btcnt(unsigned int ch);
+
+#endif	// !defined(EEE158_EX05_PLATFORM_DMAC_H_)
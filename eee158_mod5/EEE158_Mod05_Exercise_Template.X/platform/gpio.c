@@ -30,12 +30,22 @@
 #include "blink_settings.h"
 
 #include "../platform.h"
+#include "dmac.h"
+#include "probe.h"
 
 int top = 23438;
 // Initializers defined in other platform_*.c files
 extern void platform_systick_init(void);
+extern void platform_dmac_init(void);
 extern void platform_usart_init(void);
-extern void platform_usart_tick_handler(const platform_timespec_t *tick);
+extern void platform_usart_tick_handler(platform_tick_t now);
+extern void platform_timer_run(void);
+#if (PLATFORM_USE_PROBES != 0)
+extern void platform_probe_init(void);
+#endif
+
+// Functions "exported" by this file
+void platform_blink_suspend(void);
 /////////////////////////////////////////////////////////////////////////////
 
 // Enable higher frequencies for higher performance
@@ -112,6 +122,16 @@ static void raise_perf_level(void) {
     while ((GCLK_REGS->GCLK_SYNCBUSY & (1 << 2)) != 0)
         asm("nop");
 
+#if (PLATFORM_USART_HIGH_SPEED != 0)
+    /*
+     * GCLK_GEN3 passes DFLL48M through undivided, for the USART's
+     * high-speed profile.
+     */
+    GCLK_REGS->GCLK_GENCTRL[3] = 0x00010107;
+    while ((GCLK_REGS->GCLK_SYNCBUSY & (1 << 5)) != 0)
+        asm("nop");
+#endif
+
     // Done. We're now at 24 MHz.
     return;
 }
@@ -197,6 +217,19 @@ static void EVSYS_init(void) {
     asm("nop");
     asm("nop");
     asm("nop");
+
+#if (PLATFORM_BLINK_BACKEND == PLATFORM_BLINK_BACKEND_EVSYS)
+    /*
+     * Channel 0: TC0 MC1 -> PORT event input 0 (sets the LED)
+     * Channel 1: TC0 OVF -> PORT event input 1 (clears the LED)
+     * 
+     * PORT event inputs need the asynchronous path; PATH[9:8] = 0x2.
+     */
+    EVSYS_SEC_REGS->EVSYS_CHANNEL[0] = EVSYS_ID_GEN_TC0_MC_1 | (0x2 << 8);
+    EVSYS_SEC_REGS->EVSYS_CHANNEL[1] = EVSYS_ID_GEN_TC0_OVF | (0x2 << 8);
+    EVSYS_SEC_REGS->EVSYS_USER[EVSYS_ID_USER_PORT_EV_0] = 0 + 1;
+    EVSYS_SEC_REGS->EVSYS_USER[EVSYS_ID_USER_PORT_EV_0 + 1] = 1 + 1;
+#endif
     return;
 }
 
@@ -204,6 +237,60 @@ static void EVSYS_init(void) {
 
 // Configure any peripheral/s used to effect blinking
 
+#if (PLATFORM_BLINK_BACKEND != PLATFORM_BLINK_BACKEND_SOFT)
+/*
+ * BREATHE: the DMAC copies one entry of blink_breathe[] into CCBUF1 on
+ * every TC0 overflow, with a descriptor that links back to itself. An
+ * entry thus lasts one PWM period (BREATHE_TOP + 1 counts, some 183 Hz);
+ * the duty rises over BREATHE_STEPS entries and falls over as many more,
+ * for a breath of about 2.8 s.
+ * 
+ * The duty follows the cube of the step, which is close enough to how
+ * brightness is perceived (CIE lightness). Entries are CC1 values, since
+ * the LED turns on at CC1; a full-scale entry keeps it lit for all but
+ * one count. The whole table is a constant expression, and lives in flash.
+ */
+#define BREATHE_TOP	127
+#define BREATHE_STEPS	256
+#define BREATHE_TRI(i)	((i) < BREATHE_STEPS ? (i) : 2 * BREATHE_STEPS - (i))
+#define BREATHE_CUBE	((uint32_t) BREATHE_STEPS * BREATHE_STEPS * BREATHE_STEPS)
+#define BREATHE_DUTY(i) \
+    (((uint32_t) BREATHE_TOP * BREATHE_TRI(i) * BREATHE_TRI(i) * \
+      BREATHE_TRI(i) + BREATHE_CUBE / 2) / BREATHE_CUBE)
+#define B1(i)	(BREATHE_TOP + 1 - BREATHE_DUTY(i))
+#define B4(i)	B1(i), B1((i) + 1), B1((i) + 2), B1((i) + 3)
+#define B16(i)	B4(i), B4((i) + 4), B4((i) + 8), B4((i) + 12)
+#define B64(i)	B16(i), B16((i) + 16), B16((i) + 32), B16((i) + 48)
+#define B256(i)	B64(i), B64((i) + 64), B64((i) + 128), B64((i) + 192)
+
+static const uint16_t blink_breathe[2 * BREATHE_STEPS] = {
+    B256(0), B256(BREATHE_STEPS)
+};
+
+static void blink_breathe_init(void) {
+    platform_dmac_desc_t *d = platform_dmac_desc_base(PLATFORM_DMAC_CH_BLINK);
+
+    platform_dmac_ch_setup(PLATFORM_DMAC_CH_BLINK,
+            DMAC_CHCTRLB_TRIGSRC(DMAC_TRIG_TC0_OVF) | DMAC_CHCTRLB_TRIGACT_BEAT,
+            0, NULL, NULL);
+    d->btctrl = DMAC_BTCTRL_VALID | DMAC_BTCTRL_BEATSIZE_HWORD |
+            DMAC_BTCTRL_SRCINC | DMAC_BTCTRL_BLOCKACT_NOACT;
+    d->btcnt = 2 * BREATHE_STEPS;
+    d->srcaddr = (uint32_t) (uintptr_t) (blink_breathe + 2 * BREATHE_STEPS);
+    d->dstaddr = (uint32_t) (uintptr_t) (&TC0_REGS->COUNT16.TC_CCBUF[1]);
+    d->descaddr = (uint32_t) (uintptr_t) d;
+    return;
+}
+
+// Stop feeding CCBUF1, and drop what is already buffered (CCBUFV1)
+
+static void blink_breathe_stop(void) {
+    platform_dmac_ch_disable(PLATFORM_DMAC_CH_BLINK);
+    TC0_REGS -> COUNT16.TC_STATUS = (1 << 5);
+    return;
+}
+#endif
+
 /*
  * @brief Initializes PA 15 as the output LED with input enabled.  Active-Hi.
  * PA23 as input. Active-LO
@@ -214,9 +301,117 @@ static void blink_init(void) {
     PORT_SEC_REGS->GROUP[0].PORT_DIRSET |= (1 << 15); // Set as output.
     // 31.7.14
     PORT_SEC_REGS->GROUP[0].PORT_PINCFG[15] |= (1 << 1); // Enables INEN 
+#if (PLATFORM_BLINK_BACKEND == PLATFORM_BLINK_BACKEND_PWM)
+    // Peripheral Function E (TC0 WO[1]) for PA15, PMUXO[3:0]; only takes
+    // effect while PMUXEN is set
+    PORT_SEC_REGS->GROUP[0].PORT_PMUX[(15 >> 1)] =
+            (PORT_SEC_REGS->GROUP[0].PORT_PMUX[(15 >> 1)] & 0x0F) | (0x4 << 4);
+#elif (PLATFORM_BLINK_BACKEND == PLATFORM_BLINK_BACKEND_EVSYS)
+    /*
+     * Event input 0 sets PA15, and event input 1 clears it; PID[4:0],
+     * EVACT[6:5]. PORTEIx (Bit 7) stays clear until blinking starts.
+     */
+    PORT_SEC_REGS->GROUP[0].PORT_EVCTRL = (15 << 0) | (0x1 << 5) |
+            (15 << 8) | (0x2 << 13);
+#endif
+#if (PLATFORM_BLINK_BACKEND != PLATFORM_BLINK_BACKEND_SOFT)
+    blink_breathe_init();
+#endif
     return;
 }
 
+// Setting TC0 and PA15 were last configured for
+static BlinkSetting blink_applied = NUM_SETTINGS;
+
+#if (PLATFORM_BLINK_BACKEND != PLATFORM_BLINK_BACKEND_SOFT)
+/*
+ * TC0 runs in MPWM mode: CC0 sets the period, and CC1 the point where the
+ * LED turns on. As with the software blink, the LED is lit for the last
+ * 10/20/50% of each period.
+ *
+ * -- PWM:   WO[1] drives PA15; it is inverted (via DRVCTRL) so that it goes
+ *           high once COUNT reaches CC1.
+ * -- EVSYS: the CC1 match event sets PA15, and the overflow event clears
+ *           it, through the PORT event inputs (see EVSYS_init()).
+ */
+static const struct {
+    uint16_t period;
+    uint16_t on_at;
+} blink_pwm[NUM_SETTINGS] = {
+    [SLOW] = {23438, 21094},
+    [MEDIUM] = {11719, 9375},
+    [FAST] = {7032, 3516},
+};
+
+#if (PLATFORM_BLINK_BACKEND == PLATFORM_BLINK_BACKEND_PWM)
+// Hand PA15 to TC0 WO[1] (PMUXEN), or back to PORT
+#define BLINK_PIN_ATTACH() \
+    (PORT_SEC_REGS -> GROUP[0].PORT_PINCFG[15] |= (1 << 0))
+#define BLINK_PIN_DETACH() \
+    (PORT_SEC_REGS -> GROUP[0].PORT_PINCFG[15] &= ~(1 << 0))
+#else
+// Let the events drive PA15 (PORTEI0/1), or stop them
+#define BLINK_PIN_ATTACH() \
+    (PORT_SEC_REGS -> GROUP[0].PORT_EVCTRL |= (1 << 7) | (1 << 15))
+#define BLINK_PIN_DETACH() \
+    (PORT_SEC_REGS -> GROUP[0].PORT_EVCTRL &= ~((1 << 7) | (1 << 15)))
+#endif
+
+void platform_blink_modify(void) {
+    PROBE_BEGIN(PLATFORM_PROBE_BLINK);
+
+    if (currentSetting != blink_applied && !platform_led_pattern_busy()) {
+        if (blink_applied == BREATHE)
+            blink_breathe_stop();
+        blink_applied = currentSetting;
+
+        /*
+         * OFF/ON write the level both before TC0 lets go of the pin, so
+         * that WO[1] hands over without a glitch, and after, in case an
+         * event landed in between.
+         */
+        switch (currentSetting) {
+            case OFF:
+                PORT_SEC_REGS -> GROUP[0].PORT_OUTCLR = (1 << 15);
+                BLINK_PIN_DETACH();
+                PORT_SEC_REGS -> GROUP[0].PORT_OUTCLR = (1 << 15);
+                break;
+            case ON:
+                PORT_SEC_REGS -> GROUP[0].PORT_OUTSET = (1 << 15);
+                BLINK_PIN_DETACH();
+                PORT_SEC_REGS -> GROUP[0].PORT_OUTSET = (1 << 15);
+                break;
+            case BREATHE:
+                TC0_REGS -> COUNT16.TC_CC[0] = BREATHE_TOP;
+                while (TC0_REGS -> COUNT16.TC_SYNCBUSY & (1 << 6));
+                TC0_REGS -> COUNT16.TC_CC[1] = blink_breathe[0];
+                while (TC0_REGS -> COUNT16.TC_SYNCBUSY & (1 << 7));
+
+                // The DMAC supplies the duty from the next period onwards.
+                PORT_SEC_REGS -> GROUP[0].PORT_OUTCLR = (1 << 15);
+                TC0_REGS -> COUNT16.TC_CTRLBSET = (0x1 << 5);
+                while (TC0_REGS -> COUNT16.TC_SYNCBUSY & (1 << 2));
+                platform_dmac_ch_enable(PLATFORM_DMAC_CH_BLINK);
+                BLINK_PIN_ATTACH();
+                break;
+            default:
+                TC0_REGS -> COUNT16.TC_CC[0] = blink_pwm[currentSetting].period;
+                while (TC0_REGS -> COUNT16.TC_SYNCBUSY & (1 << 6));
+                TC0_REGS -> COUNT16.TC_CC[1] = blink_pwm[currentSetting].on_at;
+                while (TC0_REGS -> COUNT16.TC_SYNCBUSY & (1 << 7));
+
+                // Start the new period from zero (RETRIGGER command)
+                PORT_SEC_REGS -> GROUP[0].PORT_OUTCLR = (1 << 15);
+                TC0_REGS -> COUNT16.TC_CTRLBSET = (0x1 << 5);
+                while (TC0_REGS -> COUNT16.TC_SYNCBUSY & (1 << 2));
+                BLINK_PIN_ATTACH();
+                break;
+        }
+    }
+
+    PROBE_END(PLATFORM_PROBE_BLINK);
+}
+#else
 int read_count() {
     // Allow read access of COUNT register
     // Return back the counter value
@@ -227,11 +422,26 @@ int read_count() {
 }
 
 void platform_blink_modify(void) {
+    PROBE_BEGIN(PLATFORM_PROBE_BLINK);
+
     // Start the timer if it's not running
     /*if (!(TC0_REGS->COUNT16.TC_STATUS & TC_STATUS_STOP_Msk)) {
         TC0_REGS->COUNT16.TC_CTRLA |= TC_CTRLA_ENABLE_Msk;
     }*/
     
+    // The pattern sequencer has the LED for now
+    if (platform_led_pattern_busy()) {
+        PROBE_END(PLATFORM_PROBE_BLINK);
+        return;
+    }
+
+    // A new setting starts on a fresh period
+    if (currentSetting != blink_applied) {
+        blink_applied = currentSetting;
+        TC0_REGS -> COUNT16.TC_COUNT = 0;
+        while (TC0_REGS -> COUNT16.TC_SYNCBUSY & (1 << 4));
+    }
+
     switch (currentSetting) {
         case OFF:
             PORT_SEC_REGS -> GROUP[0].PORT_OUTCLR = (1 << 15);
@@ -267,10 +477,25 @@ void platform_blink_modify(void) {
             }
             break;
         case ON:
+        case BREATHE: // Needs TC0 to drive the LED; stays lit instead
             PORT_SEC_REGS -> GROUP[0].PORT_OUTSET = (1 << 15);
             break;
     }
 
+    PROBE_END(PLATFORM_PROBE_BLINK);
+}
+#endif	// PLATFORM_BLINK_BACKEND != PLATFORM_BLINK_BACKEND_SOFT
+
+// Hand the LED over to the pattern sequencer, until it goes idle again
+
+void platform_blink_suspend(void) {
+#if (PLATFORM_BLINK_BACKEND != PLATFORM_BLINK_BACKEND_SOFT)
+    BLINK_PIN_DETACH();
+    if (blink_applied == BREATHE)
+        blink_breathe_stop();
+#endif
+    blink_applied = NUM_SETTINGS;
+    return;
 }
 //////////////////////////////////////////////////////////////////////////////
 
@@ -279,14 +504,45 @@ void platform_blink_modify(void) {
  * which in turn is Peripheral Function A. The corresponding Interrupt ReQuest
  * (IRQ) handler is thus named EIC_EXTINT_2_Handler.
  */
-static volatile uint16_t pb_press_mask = 0;
+
+#if (PLATFORM_PB_QUEUE_LEN & (PLATFORM_PB_QUEUE_LEN - 1)) != 0
+#error "PLATFORM_PB_QUEUE_LEN must be a power of two"
+#endif
+
+/*
+ * Pushbutton event queue: the EIC handler is the only writer of
+ * pb_queue_head, and the application the only writer of pb_queue_tail, so
+ * neither side needs to mask interrupts. Both count up freely.
+ */
+static platform_pb_event_t pb_queue[PLATFORM_PB_QUEUE_LEN];
+static volatile uint32_t pb_queue_head, pb_queue_tail;
+static volatile uint32_t pb_queue_overflows;
+
+static void pb_queue_put(uint8_t id, uint8_t edge) {
+    uint32_t head = pb_queue_head;
+    platform_pb_event_t *ev;
+
+    if (head - pb_queue_tail >= PLATFORM_PB_QUEUE_LEN) {
+        ++pb_queue_overflows;
+        return;
+    }
+    ev = &pb_queue[head & (PLATFORM_PB_QUEUE_LEN - 1)];
+    ev->t = platform_tick_now();
+    ev->id = id;
+    ev->edge = edge;
+
+    // The entry must be complete before the application can see it.
+    __DMB();
+    pb_queue_head = head + 1;
+    return;
+}
 
 void __attribute__((used, interrupt())) EIC_EXTINT_2_Handler(void) {
-    pb_press_mask &= ~PLATFORM_PB_ONBOARD_MASK;
     if ((EIC_SEC_REGS->EIC_PINSTATE & (1 << 2)) == 0)
-        pb_press_mask |= PLATFORM_PB_ONBOARD_PRESS;
+        pb_queue_put(PLATFORM_PB_ID_ONBOARD, PLATFORM_PB_EDGE_PRESS);
     else
-        pb_press_mask |= PLATFORM_PB_ONBOARD_RELEASE;
+        pb_queue_put(PLATFORM_PB_ID_ONBOARD, PLATFORM_PB_EDGE_RELEASE);
+    platform_event_post(PLATFORM_EVENT_PB);
 
     // Clear the interrupt before returning.
     EIC_SEC_REGS->EIC_INTFLAG |= (1 << 2);
@@ -335,13 +591,38 @@ static void PB_init(void) {
     return;
 }
 
-// Get the mask of currently-pressed buttons
+bool platform_pb_event_read(platform_pb_event_t *ev) {
+    uint32_t tail = pb_queue_tail;
 
-uint16_t platform_pb_get_event(void) {
-    uint16_t cache = pb_press_mask;
+    if (tail == pb_queue_head)
+        return false;
+
+    // Read the entry before handing its slot back to the handler.
+    __DMB();
+    *ev = pb_queue[tail & (PLATFORM_PB_QUEUE_LEN - 1)];
+    __DMB();
+    pb_queue_tail = tail + 1;
+    return true;
+}
 
-    pb_press_mask = 0;
-    return cache;
+uint32_t platform_pb_event_overflows(void) {
+    return pb_queue_overflows;
+}
+
+// Get the mask of button events since the last call
+
+uint16_t platform_pb_get_event(void) {
+    platform_pb_event_t ev;
+    uint16_t mask = 0;
+
+    // Only the on-board button exists, so its ID is not looked at.
+    while (platform_pb_event_read(&ev)) {
+        if (ev.edge == PLATFORM_PB_EDGE_PRESS)
+            mask |= PLATFORM_PB_ONBOARD_PRESS;
+        else
+            mask |= PLATFORM_PB_ONBOARD_RELEASE;
+    }
+    return mask;
 }
 
 //////////////////////////////////////////////////////////////////////////////
@@ -363,6 +644,46 @@ static void NVIC_init(void) {
     NVIC_SetPriority(SysTick_IRQn, 3);
     NVIC_EnableIRQ(EIC_EXTINT_2_IRQn);
     NVIC_EnableIRQ(SysTick_IRQn);
+    /*
+     * DMAC channels 0-3; each channel's own interrupt enables decide
+     * whether these ever fire.
+     */
+    NVIC_SetPriority(DMAC_0_IRQn, 3);
+    NVIC_SetPriority(DMAC_1_IRQn, 3);
+    NVIC_SetPriority(DMAC_2_IRQn, 3);
+    NVIC_SetPriority(DMAC_3_IRQn, 3);
+    NVIC_EnableIRQ(DMAC_0_IRQn);
+    NVIC_EnableIRQ(DMAC_1_IRQn);
+    NVIC_EnableIRQ(DMAC_2_IRQn);
+    NVIC_EnableIRQ(DMAC_3_IRQn);
+    // TC0 overflow, for the LED pattern sequencer
+    NVIC_SetPriority(TC0_IRQn, 3);
+    NVIC_EnableIRQ(TC0_IRQn);
+#if (PLATFORM_USART_USE_IRQ != 0)
+    /*
+     * SERCOM3 (USART) lines, at the same priority as SysTick so that
+     * neither preempts the other mid-update.
+     */
+    NVIC_SetPriority(SERCOM3_0_IRQn, 3);
+    NVIC_SetPriority(SERCOM3_1_IRQn, 3);
+    NVIC_SetPriority(SERCOM3_2_IRQn, 3);
+    NVIC_SetPriority(SERCOM3_OTHER_IRQn, 3);
+    NVIC_EnableIRQ(SERCOM3_0_IRQn);
+    NVIC_EnableIRQ(SERCOM3_1_IRQn);
+    NVIC_EnableIRQ(SERCOM3_2_IRQn);
+    NVIC_EnableIRQ(SERCOM3_OTHER_IRQn);
+#if (PLATFORM_USART_USE_LINK != 0)
+    // SERCOM0 (data-link USART) lines, likewise
+    NVIC_SetPriority(SERCOM0_0_IRQn, 3);
+    NVIC_SetPriority(SERCOM0_1_IRQn, 3);
+    NVIC_SetPriority(SERCOM0_2_IRQn, 3);
+    NVIC_SetPriority(SERCOM0_OTHER_IRQn, 3);
+    NVIC_EnableIRQ(SERCOM0_0_IRQn);
+    NVIC_EnableIRQ(SERCOM0_1_IRQn);
+    NVIC_EnableIRQ(SERCOM0_2_IRQn);
+    NVIC_EnableIRQ(SERCOM0_OTHER_IRQn);
+#endif
+#endif
     return;
 }
 
@@ -377,6 +698,7 @@ void platform_init(void) {
     // Early initialization
     EVSYS_init();
     EIC_init_early();
+    platform_dmac_init();
 
     // Regular initialization
     TC0_Init();
@@ -387,6 +709,9 @@ void platform_init(void) {
     // Late initialization
     EIC_init_late();
     platform_systick_init();
+#if (PLATFORM_USE_PROBES != 0)
+    platform_probe_init();
+#endif
     NVIC_init();
     return;
 }
@@ -405,7 +730,15 @@ void TC0_Init(void) {
     TC0_REGS -> COUNT16.TC_CTRLA = (0x7 << 8); // Prescaler Factor: 1024 Bit[10:8]]
 
     // Setting up the WAVE Register
+#if (PLATFORM_BLINK_BACKEND == PLATFORM_BLINK_BACKEND_PWM)
+    TC0_REGS -> COUNT16.TC_WAVE = (0x3 << 0); // Use MPWM Bit [1:0]
+    TC0_REGS -> COUNT16.TC_DRVCTRL = (1 << 1); // Invert WO[1]; INVEN1 Bit 1
+#elif (PLATFORM_BLINK_BACKEND == PLATFORM_BLINK_BACKEND_EVSYS)
+    TC0_REGS -> COUNT16.TC_WAVE = (0x3 << 0); // Use MPWM Bit [1:0]
+    TC0_REGS -> COUNT16.TC_EVCTRL = (1 << 8) | (1 << 13); // OVFEO, MCEO1
+#else
     TC0_REGS -> COUNT16.TC_WAVE = (0x1 << 0); // Use MFRQ Bit [1:0]
+#endif
 
     TC0_REGS -> COUNT16.TC_CTRLA |= (1 << 1); // Enable TC0 Peripheral Bit 1
 }
@@ -413,12 +746,54 @@ void TC0_Init(void) {
 // Do a single event loop
 
 void platform_do_loop_one(void) {
-    platform_timespec_t tick;
+    platform_tick_t now;
+    PROBE_BEGIN(PLATFORM_PROBE_LOOP);
 
     /*
      * Some routines must be serviced as quickly as is practicable. Do so
      * now.
      */
-    platform_tick_hrcount(&tick);
-    platform_usart_tick_handler(&tick);
+    now = platform_tick_now();
+    platform_usart_tick_handler(now);
+
+    // Callbacks of any software timers that expired since the last loop
+    platform_timer_run();
+    PROBE_END(PLATFORM_PROBE_LOOP);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+// Pending events; the first pass through the main loop needs no waiting.
+static volatile uint32_t platform_events = PLATFORM_EVENT_TICK;
+
+void platform_event_post(uint32_t events) {
+    uint32_t primask = __get_PRIMASK();
+
+    __disable_irq();
+    platform_events |= events;
+    __set_PRIMASK(primask);
+    return;
+}
+
+uint32_t platform_wait_for_event(void) {
+    uint32_t primask = __get_PRIMASK();
+    uint32_t events;
+
+    /*
+     * Check and sleep with interrupts masked, so that no event can slip in
+     * between the two. WFI still wakes up on a pending interrupt, which
+     * then runs once interrupts are unmasked.
+     */
+    __disable_irq();
+    while (platform_events == 0) {
+        __DSB();
+        __WFI();
+        __enable_irq();
+        __ISB();
+        __disable_irq();
+    }
+    events = platform_events;
+    platform_events = 0;
+    __set_PRIMASK(primask);
+    return events;
 }
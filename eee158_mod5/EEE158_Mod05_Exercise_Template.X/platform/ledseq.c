@@ -0,0 +1,211 @@
+/**
+ * @file platform/ledseq.c
+ * @brief Platform-support routines, LED pattern sequencer
+ */
+
+/*
+ * Patterns are played from the TC0 overflow interrupt, one step per
+ * period: CC0 (TOP) holds the duration of the step that is playing, and
+ * CCBUF0 that of the next, which the hardware moves into CC0 on overflow.
+ * The handler then only sets the LED to the new step's level and buffers
+ * the duration after it, so step edges keep the TC0 timing whatever the
+ * interrupt latency.
+ *
+ * While a pattern plays, the sequencer owns TC0 and the LED; the blink
+ * engine is put on hold (platform_blink_suspend()), and picks up from the
+ * current blink setting once the sequencer goes idle.
+ *
+ * The main loop adds patterns to the queue with interrupts masked; the TC0
+ * handler takes them off.
+ */
+
+// Common include for the XC32 compiler
+#include <xc.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "../platform.h"
+
+#if (PLATFORM_LED_QUEUE_LEN & (PLATFORM_LED_QUEUE_LEN - 1)) != 0 || \
+	(PLATFORM_LED_QUEUE_LEN > 128)
+#error "PLATFORM_LED_QUEUE_LEN must be a power of two, up to 128"
+#endif
+
+// Functions "exported" by other platform_*.c files
+extern void platform_blink_suspend(void);
+
+#define STEP_LEVEL(s)	(((s) & 0x8000u) != 0)
+#define STEP_MS(s)	((s) & 0x7FFFu)
+
+/////////////////////////////////////////////////////////////////////////////
+
+// Patterns waiting to play; both indices count up freely.
+static const platform_led_pattern_t *seq_queue[PLATFORM_LED_QUEUE_LEN];
+static volatile uint8_t seq_queue_head, seq_queue_tail;
+
+/*
+ * The step that starts on the next overflow (its duration is in CCBUF0);
+ * with no pattern, the sequence ends there unless one is queued by then.
+ */
+static struct {
+    const platform_led_pattern_t *pat;
+    uint16_t idx;
+    uint16_t runs;	// Runs left, for a pattern that does not repeat forever
+} seq_cur;
+
+static volatile bool seq_busy;
+
+static const platform_led_pattern_t *seq_pop(void) {
+    if (seq_queue_head == seq_queue_tail)
+        return NULL;
+    return seq_queue[(seq_queue_head++) & (PLATFORM_LED_QUEUE_LEN - 1)];
+}
+
+static bool seq_load(const platform_led_pattern_t *pat) {
+    seq_cur.pat = pat;
+    seq_cur.idx = 0;
+    seq_cur.runs = (pat != NULL) ? pat->repeat : 0;
+    return pat != NULL;
+}
+
+// Move the cursor one step on, into the next run or pattern if need be.
+
+static void seq_advance(void) {
+    const platform_led_pattern_t *pat = seq_cur.pat;
+
+    if (++seq_cur.idx < pat->nr_steps)
+        return;
+    seq_cur.idx = 0;
+    if (pat->repeat == 0) {
+        // Forever, unless something else is waiting
+        if (seq_queue_head == seq_queue_tail)
+            return;
+    } else if (--seq_cur.runs != 0) {
+        return;
+    }
+    seq_load(seq_pop());
+}
+
+// TOP value for a step; TC0 counts at 24 MHz / 1024, or 375/16 per ms.
+
+static uint16_t seq_top(platform_led_step_t s) {
+    uint32_t n = (STEP_MS(s) * 375u + 8) / 16;
+
+    if (n > 0x10000)
+        n = 0x10000;
+    return (n != 0) ? (uint16_t) (n - 1) : 0;
+}
+
+static void seq_set_led(platform_led_step_t s) {
+    if (STEP_LEVEL(s))
+        PORT_SEC_REGS->GROUP[0].PORT_OUTSET = (1 << 15);
+    else
+        PORT_SEC_REGS->GROUP[0].PORT_OUTCLR = (1 << 15);
+    return;
+}
+
+// Start the step under the cursor, and buffer the one after it.
+
+static void seq_step(void) {
+    seq_set_led(seq_cur.pat->steps[seq_cur.idx]);
+    seq_advance();
+    if (seq_cur.pat != NULL)
+        TC0_REGS->COUNT16.TC_CCBUF[0] = seq_top(seq_cur.pat->steps[seq_cur.idx]);
+    return;
+}
+
+static void seq_stop(void) {
+    TC0_REGS->COUNT16.TC_INTENCLR = (1 << 0); // OVF
+    TC0_REGS->COUNT16.TC_STATUS = (1 << 4); // CCBUFV0, if stopped early
+    seq_cur.pat = NULL;
+    seq_busy = false;
+    platform_event_post(PLATFORM_EVENT_LED);
+    return;
+}
+
+// Take TC0 and the LED over, and start @p pat; interrupts must be masked.
+
+static void seq_start(const platform_led_pattern_t *pat) {
+    platform_led_step_t first = pat->steps[0];
+
+    /*
+     * The level goes out before the blink engine lets go of the pin, so
+     * that the hand-over does not glitch; seq_step() writes it again, in
+     * case a TC0 event landed in between.
+     */
+    seq_set_led(first);
+    platform_blink_suspend();
+
+    seq_load(pat);
+    TC0_REGS->COUNT16.TC_STATUS = (1 << 4); // Drop any buffered CC0 (CCBUFV0)
+    TC0_REGS->COUNT16.TC_CC[0] = seq_top(first);
+    while (TC0_REGS->COUNT16.TC_SYNCBUSY & (1 << 6));
+
+    // Start the first step from zero (RETRIGGER command)
+    TC0_REGS->COUNT16.TC_CTRLBSET = (0x1 << 5);
+    while (TC0_REGS->COUNT16.TC_SYNCBUSY & (1 << 2));
+    seq_step();
+
+    TC0_REGS->COUNT16.TC_INTFLAG = (1 << 0);
+    TC0_REGS->COUNT16.TC_INTENSET = (1 << 0);
+    seq_busy = true;
+    return;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+void __attribute__((used, interrupt())) TC0_Handler(void) {
+    // A restart may have cleared the flag after it was taken
+    if ((TC0_REGS->COUNT16.TC_INTFLAG & (1 << 0)) == 0)
+        return;
+    TC0_REGS->COUNT16.TC_INTFLAG = (1 << 0);
+
+    if (seq_cur.pat == NULL) {
+        // The last step just ended; a pattern may have been queued since.
+        if (!seq_load(seq_pop())) {
+            seq_stop();
+            return;
+        }
+        // Nothing was buffered, but the count has only just wrapped.
+        TC0_REGS->COUNT16.TC_CC[0] = seq_top(seq_cur.pat->steps[0]);
+    }
+    seq_step();
+    return;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+bool platform_led_pattern_queue(const platform_led_pattern_t *pattern) {
+    uint32_t primask = __get_PRIMASK();
+    bool ok = true;
+
+    __disable_irq();
+    if (!seq_busy) {
+        seq_start(pattern);
+    } else if ((uint8_t) (seq_queue_tail - seq_queue_head) >=
+            PLATFORM_LED_QUEUE_LEN) {
+        ok = false;
+    } else {
+        seq_queue[seq_queue_tail & (PLATFORM_LED_QUEUE_LEN - 1)] = pattern;
+        ++seq_queue_tail;
+    }
+    __set_PRIMASK(primask);
+    return ok;
+}
+
+void platform_led_pattern_replace(const platform_led_pattern_t *pattern) {
+    uint32_t primask = __get_PRIMASK();
+
+    __disable_irq();
+    seq_queue_head = seq_queue_tail;
+    if (pattern != NULL)
+        seq_start(pattern);
+    else if (seq_busy)
+        seq_stop();
+    __set_PRIMASK(primask);
+    return;
+}
+
+bool platform_led_pattern_busy(void) {
+    return seq_busy;
+}
@@ -0,0 +1,175 @@
+/**
+ * @file platform/probe.c
+ * @brief Platform-support routines, hot-path probes
+ */
+
+/*
+ * Each probe keeps a call count, and the minimum, maximum and total of its
+ * durations in CPU cycles (24 MHz), as measured from SysTick VAL. A
+ * duration must stay below one platform tick (PLATFORM_TICK_PERIOD_US) to
+ * be measured correctly, since SysTick wraps at that point.
+ *
+ * Every probe has a single writer: the SysTick probe is only updated from
+ * its interrupt, the rest only from the main loop. Readers take their
+ * snapshot with interrupts masked.
+ */
+
+// Common include for the XC32 compiler
+#include <xc.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "../platform.h"
+#include "probe.h"
+
+#if (PLATFORM_USE_PROBES != 0)
+
+// Functions "exported" by this file
+void platform_probe_init(void);
+
+/////////////////////////////////////////////////////////////////////////////
+
+typedef struct probe_entry_type {
+    uint32_t nr_calls;
+    uint32_t min;
+    uint32_t max;
+    uint64_t sum;
+} probe_entry_t;
+
+static probe_entry_t probe_table[NR_PLATFORM_PROBES];
+
+static const char *const probe_names[NR_PLATFORM_PROBES] = {
+    [PLATFORM_PROBE_LOOP] = "loop",
+    [PLATFORM_PROBE_USART_TICK] = "usart_tick",
+    [PLATFORM_PROBE_BLINK] = "blink",
+    [PLATFORM_PROBE_SYSTICK] = "systick",
+};
+
+// Cycles taken by an empty probe, measured at start-up
+static uint32_t probe_overhead;
+
+void platform_probe_record(unsigned int id, uint32_t t0) {
+    uint32_t t1 = SysTick->VAL;
+    probe_entry_t *p = &probe_table[id];
+    uint32_t d;
+
+    // SysTick counts down; account for (at most) one wrap-around.
+    if (t1 <= t0)
+        d = t0 - t1;
+    else
+        d = t0 + (SysTick->LOAD + 1) - t1;
+
+    ++p->nr_calls;
+    p->sum += d;
+    if (d < p->min)
+        p->min = d;
+    if (d > p->max)
+        p->max = d;
+    return;
+}
+
+void platform_probe_clear(void) {
+    uint32_t primask = __get_PRIMASK();
+    unsigned int x;
+
+    __disable_irq();
+    memset(probe_table, 0, sizeof (probe_table));
+    for (x = 0; x < NR_PLATFORM_PROBES; ++x)
+        probe_table[x].min = UINT32_MAX;
+    __set_PRIMASK(primask);
+    return;
+}
+
+void platform_probe_init(void) {
+    platform_probe_clear();
+
+    // An empty probe, so that the dump can show what a probe itself costs
+    {
+        PROBE_BEGIN(PLATFORM_PROBE_LOOP);
+        PROBE_END(PLATFORM_PROBE_LOOP);
+    }
+    probe_overhead = probe_table[PLATFORM_PROBE_LOOP].min;
+    platform_probe_clear();
+    return;
+}
+
+bool platform_probe_get(unsigned int id, platform_probe_stats_t *stats) {
+    uint32_t primask;
+    probe_entry_t p;
+
+    if (id >= NR_PLATFORM_PROBES)
+        return false;
+
+    primask = __get_PRIMASK();
+    __disable_irq();
+    p = probe_table[id];
+    __set_PRIMASK(primask);
+
+    stats->name = probe_names[id];
+    stats->nr_calls = p.nr_calls;
+    stats->min_cycles = (p.nr_calls != 0) ? p.min : 0;
+    stats->max_cycles = p.max;
+    stats->mean_cycles = (p.nr_calls != 0) ? (uint32_t) (p.sum / p.nr_calls) : 0;
+    return true;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+/*
+ * Dump buffer; one header line, plus one line per probe. It stays in use
+ * until the transmission (sequence number probe_dump_seq) is done.
+ */
+#define PROBE_DUMP_LINE	72
+static char probe_dump_buf[PROBE_DUMP_LINE * (NR_PLATFORM_PROBES + 1)];
+static platform_usart_tx_bufdesc_t probe_dump_desc[1];
+static uint16_t probe_dump_seq;
+
+/*
+ * Append to the dump buffer at offset *n, which is moved past the text
+ * written; anything that does not fit is cut off.
+ */
+static void probe_dump_append(unsigned int *n, const char *fmt, ...) {
+    unsigned int space = sizeof (probe_dump_buf) - *n;
+    va_list ap;
+    int r;
+
+    if (space <= 1)
+        return;
+    va_start(ap, fmt);
+    r = vsnprintf(probe_dump_buf + *n, space, fmt, ap);
+    va_end(ap);
+    if (r < 0)
+        return;
+
+    // On truncation, vsnprintf() returns what it would have written.
+    *n += ((unsigned int) r < space) ? (unsigned int) r : space - 1;
+}
+
+bool platform_probe_dump(void) {
+    platform_probe_stats_t st;
+    unsigned int x, n = 0;
+
+    if (probe_dump_seq != 0 &&
+            (int16_t) (platform_usart_cdc_tx_seq_done() - probe_dump_seq) < 0)
+        return false;
+
+    probe_dump_append(&n,
+            "\r\nprobe        calls   min   max  mean (cycles, %lu/probe)\r\n",
+            (unsigned long) probe_overhead);
+    for (x = 0; x < NR_PLATFORM_PROBES; ++x) {
+        platform_probe_get(x, &st);
+        probe_dump_append(&n, "%-10s %7lu %5lu %5lu %5lu\r\n", st.name,
+                (unsigned long) st.nr_calls, (unsigned long) st.min_cycles,
+                (unsigned long) st.max_cycles, (unsigned long) st.mean_cycles);
+    }
+
+    probe_dump_desc[0].buf = probe_dump_buf;
+    probe_dump_desc[0].len = n;
+    probe_dump_seq = platform_usart_cdc_tx_submit(probe_dump_desc, 1,
+            NULL, NULL);
+    return probe_dump_seq != 0;
+}
+
+#endif	// PLATFORM_USE_PROBES != 0
@@ -0,0 +1,36 @@
+/**
+ * @file  platform/probe.h
+ * @brief Platform-internal declarations, hot-path probes
+ *
+ * Wrap a hot path in @c PROBE_BEGIN() / @c PROBE_END() to have its duration
+ * recorded under one of the @code PLATFORM_PROBE_* @endcode IDs. With
+ * @c PLATFORM_USE_PROBES at zero, both expand to nothing.
+ *
+ * NOTE: This header is only meant for the platform/ sources; applications
+ *       should stick to platform.h. It must come after <xc.h>.
+ */
+
+#if !defined(EEE158_EX05_PLATFORM_PROBE_H_)
+#define EEE158_EX05_PLATFORM_PROBE_H_
+
+#include <stdint.h>
+
+#include "../platform.h"
+
+#if (PLATFORM_USE_PROBES != 0)
+/// Record one run of probe @p id, which started at SysTick value @p t0
+void platform_probe_record(unsigned int id, uint32_t t0);
+
+/*
+ * Cortex-M23 has no DWT cycle counter, so probes read SysTick instead: it
+ * counts CPU cycles down from LOAD, and wraps once per platform tick.
+ * Only one probe may be open per scope.
+ */
+#define PROBE_BEGIN(id)	const uint32_t probe_t0_ = SysTick->VAL
+#define PROBE_END(id)	platform_probe_record((id), probe_t0_)
+#else
+#define PROBE_BEGIN(id)	do { } while (0)
+#define PROBE_END(id)	do { } while (0)
+#endif
+
+#endif	// !defined(EEE158_EX05_PLATFORM_PROBE_H_)
@@ -26,20 +26,45 @@
 #include <string.h>
 
 #include "../platform.h"
+#include "probe.h"
+
+// Defined in platform/timer.c
+extern void platform_timer_tick(void);
 
 /////////////////////////////////////////////////////////////////////////////
 
+/*
+ * The timespec routines in this file avoid division (Cortex-M23 has no
+ * divider for 64-bit operands) and data-dependent loops: each carry or
+ * borrow is a comparison, folded into the arithmetic, and each quotient is
+ * a multiplication by a reciprocal.
+ */
+#define NSEC_PER_SEC	1000000000UL
+
 // Normalize a timespec
 void platform_timespec_normalize(platform_timespec_t *ts)
 {
-	while (ts->nr_nsec >= 1000000000) {
-		ts->nr_nsec -= 1000000000;
-		if (ts->nr_sec < UINT32_MAX) {
-			++ts->nr_sec;
-		} else {
-			ts->nr_nsec = (1000000000 - 1);
-			break;
-		}
+	uint32_t ns = ts->nr_nsec;
+	uint32_t c2, c1;
+	uint64_t s;
+	
+	// nr_nsec < 2^32, i.e., at most four seconds' worth.
+	c2  = (ns >= 2 * NSEC_PER_SEC);
+	ns -= c2 * (2 * NSEC_PER_SEC);
+	c1  = (ns >= 2 * NSEC_PER_SEC);
+	ns -= c1 * (2 * NSEC_PER_SEC);
+	s   = (uint64_t) ts->nr_sec + 2 * (c2 + c1);
+	c1  = (ns >= NSEC_PER_SEC);
+	ns -= c1 * NSEC_PER_SEC;
+	s  += c1;
+	
+	if (s > UINT32_MAX) {
+		// Saturate
+		ts->nr_sec  = UINT32_MAX;
+		ts->nr_nsec = NSEC_PER_SEC - 1;
+	} else {
+		ts->nr_sec  = (uint32_t) s;
+		ts->nr_nsec = ns;
 	}
 }
 
@@ -47,42 +72,77 @@ void platform_timespec_normalize(platform_timespec_t *ts)
 int platform_timespec_compare(const platform_timespec_t *lhs,
 	const platform_timespec_t *rhs)
 {
-	if (lhs->nr_sec < rhs->nr_sec)
-		return -1;
-	else if (lhs->nr_sec > rhs->nr_sec)
-		return +1;
-	else if (lhs->nr_nsec < rhs->nr_nsec)
-		return -1;
-	else if (lhs->nr_nsec > rhs->nr_nsec)
-		return +1;
-	else
-		return 0;
+	uint64_t l = ((uint64_t) lhs->nr_sec << 32) | lhs->nr_nsec;
+	uint64_t r = ((uint64_t) rhs->nr_sec << 32) | rhs->nr_nsec;
+	
+	return (l > r) - (l < r);
+}
+
+// Add two timestamps
+void platform_timespec_add(platform_timespec_t *sum,
+	const platform_timespec_t *lhs, const platform_timespec_t *rhs)
+{
+	uint32_t ns = lhs->nr_nsec + rhs->nr_nsec;	// Below 2 * 10^9
+	uint32_t c  = (ns >= NSEC_PER_SEC);
+	
+	sum->nr_sec  = lhs->nr_sec + rhs->nr_sec + c;	// Wrap-around intentional
+	sum->nr_nsec = ns - c * NSEC_PER_SEC;
+}
+
+// Subtract two timestamps
+void platform_timespec_sub(platform_timespec_t *diff,
+	const platform_timespec_t *lhs, const platform_timespec_t *rhs)
+{
+	uint32_t b = (lhs->nr_nsec < rhs->nr_nsec);
+	
+	diff->nr_nsec = lhs->nr_nsec - rhs->nr_nsec + b * NSEC_PER_SEC;
+	diff->nr_sec  = lhs->nr_sec - rhs->nr_sec - b;	// Wrap-around intentional
 }
 
 /////////////////////////////////////////////////////////////////////////////
 
+/*
+ * SysTick counts the 24-MHz CPU clock (CTRL.CLKSOURCE = 1); a period of N
+ * cycles takes a reload value of N - 1.
+ */
+#define SYSTICK_CYCLES_PER_US	24
+#define SYSTICK_RELOAD_VAL ((SYSTICK_CYCLES_PER_US*PLATFORM_TICK_PERIOD_US) - 1)
+#define SYSTICK_PERIOD		(SYSTICK_RELOAD_VAL + 1)
+
+/*
+ * Monotonic tick at the last wrap-around of SysTick, also kept as whole
+ * seconds plus cycles into the second, so that readers need not divide.
+ * Only the handler writes these, and no interrupt runs above SysTick's
+ * priority (see NVIC_init()); a cookie tells thread-mode readers that they
+ * changed under them.
+ */
+static volatile platform_tick_t tick_base = 0;
+static volatile uint32_t tick_base_sec = 0;
+static volatile uint32_t tick_base_sub = 0;
+static volatile uint32_t tick_cookie = 0;
+
 // SysTick handling
-static volatile platform_timespec_t ts_wall = PLATFORM_TIMESPEC_ZERO;
-static volatile uint32_t ts_wall_cookie = 0;
 void __attribute__((used, interrupt())) SysTick_Handler(void)
 {
-	platform_timespec_t t = ts_wall;
-	
-	t.nr_nsec += (PLATFORM_TICK_PERIOD_US * 1000);
-	while (t.nr_nsec >= 1000000000) {
-		t.nr_nsec -= 1000000000;
-		++t.nr_sec;	// Wrap-around intentional
-	}
+	uint32_t sub = tick_base_sub + SYSTICK_PERIOD;
+	uint32_t c   = (sub >= PLATFORM_TICK_HZ);
 	
-	++ts_wall_cookie;	// Wrap-around intentional
-	ts_wall = t;
-	++ts_wall_cookie;	// Wrap-around intentional
+	PROBE_BEGIN(PLATFORM_PROBE_SYSTICK);
+	tick_base += SYSTICK_PERIOD;
+	tick_base_sec += c;
+	tick_base_sub  = sub - c * PLATFORM_TICK_HZ;
+	++tick_cookie;	// Wrap-around intentional
+	platform_timer_tick();
+	platform_event_post(PLATFORM_EVENT_TICK);
 	
-	// Reset before returning.
-	SysTick->VAL  = 0x00158158;	// Any value will clear
+	/*
+	 * SysTick reloads by itself on wrap-around. Clearing VAL here would
+	 * throw away whatever it counted since (the interrupt latency), and
+	 * stretch every tick by that much.
+	 */
+	PROBE_END(PLATFORM_PROBE_SYSTICK);
 	return;
 }
-#define SYSTICK_RELOAD_VAL ((24/2)*PLATFORM_TICK_PERIOD_US)
 void platform_systick_init(void)
 {
 	/*
@@ -98,29 +158,116 @@ void platform_systick_init(void)
 	SysTick->CTRL = 0x00000007;
 	return;
 }
-void platform_tick_count(platform_timespec_t *tick)
+
+/*
+ * Take a consistent copy of the tick state, returning the number of cycles
+ * counted since the last wrap-around (which may be a whole period or more,
+ * if the wrap-around has yet to reach the handler)
+ */
+static uint32_t tick_snapshot(platform_tick_t *base, uint32_t *sec,
+	uint32_t *sub)
 {
-	uint32_t cookie;
+	uint32_t cookie, val, pend;
 	
-	// A cookie is used to make sure we get coherent data.
 	do {
-		cookie = ts_wall_cookie;
-		*tick = ts_wall;
-	} while (ts_wall_cookie != cookie);
+		cookie = tick_cookie;
+		*base  = tick_base;
+		*sec   = tick_base_sec;
+		*sub   = tick_base_sub;
+		val    = SysTick->VAL;
+		pend   = 0;
+		
+		/*
+		 * A wrap-around whose interrupt is still pending (interrupts
+		 * masked, or called from a handler) is not in tick_base yet.
+		 * VAL, re-read, then belongs to the next period -- unless it
+		 * is still at zero, the last count of the current one.
+		 */
+		if ((SCB->ICSR & SCB_ICSR_PENDSTSET_Msk) != 0) {
+			val  = SysTick->VAL;
+			pend = (val != 0);
+		}
+	} while (tick_cookie != cookie);
+	
+	return pend * SYSTICK_PERIOD + (SYSTICK_RELOAD_VAL - val);
 }
-void platform_tick_hrcount(platform_timespec_t *tick)
+
+/*
+ * Cycles to nanoseconds, for fewer than 2^32 / 125 cycles
+ * 
+ * One cycle is 125/3 ns; 0xAAAAAAAB / 2^33 is 1/3, rounded up closely enough
+ * to give the exact quotient of any 32-bit dividend.
+ */
+static inline uint32_t tick_cycles_to_nsec(uint32_t cycles)
 {
-	platform_timespec_t t;
-	uint32_t s = SYSTICK_RELOAD_VAL - SysTick->VAL;
+	return (uint32_t) (((uint64_t) (cycles * 125) * 0xAAAAAAABU) >> 33);
+}
+
+// Seconds plus cycles into the second (up to two seconds' worth) to a timespec
+static void tick_sub_to_timespec(platform_timespec_t *ts, uint32_t sec,
+	uint32_t sub)
+{
+	uint32_t c = (sub >= PLATFORM_TICK_HZ);
 	
-	platform_tick_count(&t);
-	t.nr_nsec += (1000 * s)/12;
-	while (t.nr_nsec >= 1000000000) {
-		t.nr_nsec -= 1000000000;
-		++t.nr_sec;	// Wrap-around intentional
-	}
+	ts->nr_sec  = sec + c;	// Wrap-around intentional
+	ts->nr_nsec = tick_cycles_to_nsec(sub - c * PLATFORM_TICK_HZ);
+}
+
+platform_tick_t platform_tick_now(void)
+{
+	platform_tick_t t;
+	uint32_t sec, sub, n;
+	
+	n = tick_snapshot(&t, &sec, &sub);
+	return t + n;
+}
+
+/*
+ * Quotient of a 64-bit tick by PLATFORM_TICK_HZ, i.e., (t / 2^9) / 46875
+ * 
+ * With M = ceil(2^71 / 46875), M * 46875 overshoots 2^71 by less than 2^16;
+ * hence, (n * M) / 2^71 is the exact quotient of any n below 2^55. The
+ * 128-bit product is put together from 32-bit halves.
+ */
+#define TICK_HZ_RECIP	0x00B2F4FC0794908DULL
+
+static uint64_t tick_div_hz(platform_tick_t t)
+{
+	uint64_t n = t >> 9;
+	uint64_t ll = (n & 0xFFFFFFFFU) * (TICK_HZ_RECIP & 0xFFFFFFFFU);
+	uint64_t lh = (n & 0xFFFFFFFFU) * (TICK_HZ_RECIP >> 32);
+	uint64_t hl = (n >> 32) * (TICK_HZ_RECIP & 0xFFFFFFFFU);
+	uint64_t hh = (n >> 32) * (TICK_HZ_RECIP >> 32);
+	uint64_t mid = (ll >> 32) + (lh & 0xFFFFFFFFU) + (hl & 0xFFFFFFFFU);
+	
+	// Bits 64 and up, then 71 and up
+	return (hh + (lh >> 32) + (hl >> 32) + (mid >> 32)) >> 7;
+}
+
+void platform_tick_to_timespec(platform_timespec_t *ts, platform_tick_t t)
+{
+	uint64_t q = tick_div_hz(t);
+	
+	ts->nr_sec  = (uint32_t) q;	// Wrap-around intentional
+	ts->nr_nsec = tick_cycles_to_nsec((uint32_t) (t - q * PLATFORM_TICK_HZ));
+}
+void platform_tick_count(platform_timespec_t *tick)
+{
+	platform_tick_t t;
+	uint32_t sec, sub, n;
 	
-	*tick = t;
+	// Round down to the last whole tick period
+	n = tick_snapshot(&t, &sec, &sub);
+	tick_sub_to_timespec(tick, sec,
+		sub + (n >= SYSTICK_PERIOD) * SYSTICK_PERIOD);
+}
+void platform_tick_hrcount(platform_timespec_t *tick)
+{
+	platform_tick_t t;
+	uint32_t sec, sub, n;
+	
+	n = tick_snapshot(&t, &sec, &sub);
+	tick_sub_to_timespec(tick, sec, sub + n);
 }
 
 // Difference between two ticks
@@ -129,41 +276,5 @@ void platform_tick_delta(
 	const platform_timespec_t *lhs, const platform_timespec_t *rhs
 	)
 {
-	platform_timespec_t d = PLATFORM_TIMESPEC_ZERO;
-	uint32_t c = 0;
-	
-	// Seconds...
-	if (lhs->nr_sec < rhs->nr_sec) {
-		// Wrap-around
-		d.nr_sec = (UINT32_MAX - rhs->nr_sec) + lhs->nr_sec + 1;
-	} else {
-		// No wrap-around
-		d.nr_sec = lhs->nr_sec - rhs->nr_sec;
-	}
-	
-	// Nano-seconds...
-	if (lhs->nr_sec < rhs->nr_sec) {
-		// Wrap-around
-		c = rhs->nr_sec - lhs->nr_sec;
-		while (c >= 1000000000) {
-			c -= 1000000000;
-			if (d.nr_sec == 0) {
-				d.nr_sec = UINT32_MAX;
-			} else {
-				--d.nr_sec;
-			}
-		}
-		if (d.nr_sec == 0) {
-			d.nr_sec = UINT32_MAX;
-		} else {
-			--d.nr_sec;
-		}
-	} else {
-		// No wrap-around
-		d.nr_nsec = lhs->nr_nsec - rhs->nr_nsec;
-	}
-	
-	// Normalize...
-	*diff = d;
-	return;
+	platform_timespec_sub(diff, lhs, rhs);
 }
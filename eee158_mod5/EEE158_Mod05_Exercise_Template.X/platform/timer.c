@@ -0,0 +1,178 @@
+/**
+ * @file platform/timer.c
+ * @brief Platform-support routines, software timer wheel
+ */
+
+/*
+ * A hashed timer wheel: a running timer sits on the slot of its expiry tick
+ * (modulo the number of slots). Each SysTick interrupt advances the tick
+ * count and visits only the matching slot, moving the timers that are due
+ * onto the expired list; platform_do_loop_one() then runs their callbacks.
+ *
+ * Lists are linked through next and pprev (the pointer that points to the
+ * timer), so that a timer leaves whichever list it is on in O(1). The
+ * SysTick handler and the main loop share them; the main loop masks
+ * interrupts around each list operation.
+ *
+ * Slots are pushed onto at the front, so each holds its timers newest
+ * first. Due timers are taken off in reverse, and appended to the expired
+ * list as a batch: callbacks run in expiry order, and, within a tick, in
+ * the order the timers were started.
+ */
+
+// Common include for the XC32 compiler
+#include <xc.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "../platform.h"
+
+#if (PLATFORM_TIMER_WHEEL_SLOTS & (PLATFORM_TIMER_WHEEL_SLOTS - 1)) != 0
+#error "PLATFORM_TIMER_WHEEL_SLOTS must be a power of two"
+#endif
+#define TIMER_SLOT(tick)	((tick) & (PLATFORM_TIMER_WHEEL_SLOTS - 1))
+
+// Functions "exported" by this file
+void platform_timer_tick(void);
+void platform_timer_run(void);
+
+/////////////////////////////////////////////////////////////////////////////
+
+// Ticks since start-up; wraps around after some 248 days
+static volatile uint32_t timer_jiffies;
+
+static platform_timer_t *timer_wheel[PLATFORM_TIMER_WHEEL_SLOTS];
+static platform_timer_t *timer_expired;
+
+// Where the next expired timer goes: the last one's next, or timer_expired
+static platform_timer_t **timer_expired_tail = &timer_expired;
+
+static void timer_link(platform_timer_t **head, platform_timer_t *t) {
+    t->next = *head;
+    if (t->next != NULL)
+        t->next->pprev = &t->next;
+    t->pprev = head;
+    *head = t;
+}
+
+static void timer_unlink(platform_timer_t *t) {
+    if (timer_expired_tail == &t->next)
+        timer_expired_tail = t->pprev;
+    *t->pprev = t->next;
+    if (t->next != NULL)
+        t->next->pprev = t->pprev;
+    t->next = NULL;
+    t->pprev = NULL;
+}
+
+// Convert a delay to ticks, rounding up; zero stays zero.
+
+static uint32_t timer_ticks(uint32_t us) {
+    return (us / PLATFORM_TICK_PERIOD_US) +
+            ((us % PLATFORM_TICK_PERIOD_US) != 0);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+void platform_timer_init(platform_timer_t *timer,
+        platform_timer_cb_t cb, void *arg) {
+    timer->next = NULL;
+    timer->pprev = NULL;
+    timer->expiry = 0;
+    timer->period = 0;
+    timer->cb = cb;
+    timer->arg = arg;
+    return;
+}
+
+void platform_timer_start(platform_timer_t *timer,
+        uint32_t delay_us, uint32_t period_us) {
+    uint32_t primask = __get_PRIMASK();
+
+    __disable_irq();
+    if (timer->pprev != NULL)
+        timer_unlink(timer);
+    timer->expiry = timer_jiffies + timer_ticks(delay_us) + 1;
+    timer->period = timer_ticks(period_us);
+    timer_link(&timer_wheel[TIMER_SLOT(timer->expiry)], timer);
+    __set_PRIMASK(primask);
+    return;
+}
+
+bool platform_timer_cancel(platform_timer_t *timer) {
+    uint32_t primask = __get_PRIMASK();
+    bool was_pending = false;
+
+    __disable_irq();
+    if (timer->pprev != NULL) {
+        timer_unlink(timer);
+        was_pending = true;
+    }
+    __set_PRIMASK(primask);
+    return was_pending;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+// Advance the wheel by one tick; called from SysTick_Handler().
+
+void platform_timer_tick(void) {
+    uint32_t now = timer_jiffies + 1;
+    platform_timer_t *t, *next;
+    platform_timer_t *due = NULL, *due_last = NULL;
+
+    timer_jiffies = now;
+    for (t = timer_wheel[TIMER_SLOT(now)]; t != NULL; t = next) {
+        next = t->next;
+
+        // Timers due on a later turn of the wheel stay where they are.
+        if ((int32_t) (now - t->expiry) >= 0) {
+            timer_unlink(t);
+            timer_link(&due, t);
+            if (due_last == NULL)
+                due_last = t;
+        }
+    }
+
+    // Oldest first now; on to the end of the expired list
+    if (due != NULL) {
+        due->pprev = timer_expired_tail;
+        *timer_expired_tail = due;
+        timer_expired_tail = &due_last->next;
+    }
+    return;
+}
+
+// Run the callbacks of expired timers; called from platform_do_loop_one().
+
+void platform_timer_run(void) {
+    uint32_t primask;
+    platform_timer_t *t;
+    platform_timer_cb_t cb;
+    uint32_t now;
+
+    for (;;) {
+        // Cheap check first; the list only ever grows behind our back.
+        if (timer_expired == NULL)
+            return;
+
+        primask = __get_PRIMASK();
+        __disable_irq();
+        t = timer_expired;
+        timer_unlink(t);
+        if (t->period != 0) {
+            // Re-arm on the original schedule, skipping missed expiries.
+            now = timer_jiffies;
+            do {
+                t->expiry += t->period;
+            } while ((int32_t) (t->expiry - now) <= 0);
+            timer_link(&timer_wheel[TIMER_SLOT(t->expiry)], t);
+        }
+        cb = t->cb;
+        __set_PRIMASK(primask);
+
+        // The callback may restart, or cancel, its own timer.
+        if (cb != NULL)
+            cb(t, t->arg);
+    }
+}
@@ -17,6 +17,10 @@
  * Board:
  * -- ???: UART via debugger (TX, SERCOM03, PAD[0]); PB09 PAD[1]
  * -- ???: UART via debugger (RX, SERCOM03, PAD[1]); PB08 PAD[0]
+ * -- PA04: Data link (TX, SERCOM00, PAD[0]), only with PLATFORM_USART_USE_LINK
+ * -- PA05: Data link (RX, SERCOM00, PAD[1]), only with PLATFORM_USART_USE_LINK
+ * -- PA06: Data link (RTS, SERCOM00, PAD[2]), with both of the above
+ * -- PA07: Data link (CTS, SERCOM00, PAD[3]), with both of the above
  */
 
 // Common include for the XC32 compiler
@@ -25,32 +29,300 @@
 #include <string.h>
 
 #include "../platform.h"
+#include "dmac.h"
+#include "probe.h"
 
 // Functions "exported" by this file
 void platform_usart_init(void);
-void platform_usart_tick_handler(const platform_timespec_t *tick);
+void platform_usart_tick_handler(platform_tick_t now);
 
 /////////////////////////////////////////////////////////////////////////////
 
+/// Maximum number of bytes that may be sent (or received) in one transaction
+#define NR_USART_CHARS_MAX (65528)
+
+/// Maximum number of fragments for USART TX
+#define NR_USART_TX_FRAG_MAX (32)
+
+/// GCLK generator feeding the SERCOM, and its frequency
+#if (PLATFORM_USART_HIGH_SPEED != 0)
+#define USART_GCLK_GEN (3)
+#define USART_GCLK_HZ (48000000UL)
+#else
+#define USART_GCLK_GEN (2)
+#define USART_GCLK_HZ (4000000UL)
+#endif
+
+/// CTRLA/CTRLB fields that follow from the line settings (SAMPR, FORM; CHSIZE, SBMODE, PMODE)
+#define USART_CTRLA_LINE_MASK ((0x7UL << 13) | (0xFUL << 24))
+#define USART_CTRLB_LINE_MASK ((0x7UL << 0) | (1UL << 6) | (1UL << 13))
+
+/// Index mask for the streaming rings
+#define USART_RX_RING_MASK (PLATFORM_USART_RX_RING_SIZE - 1)
+#define USART_TX_RING_MASK (PLATFORM_USART_TX_RING_SIZE - 1)
+
+/// Index mask for the TX fragment-array queue
+#define USART_TX_QUEUE_MASK (PLATFORM_USART_TX_QUEUE_LEN - 1)
+
+/*
+ * FIFO thresholds actually used
+ * 
+ * The DMAC moves one beat per trigger, so it needs RXC/DRE for every single
+ * character; anything left below a threshold would never be fetched.
+ */
+#if (PLATFORM_USART_RX_BACKEND == PLATFORM_USART_BACKEND_DMA)
+#define USART_FIFO_RXTRHOLD (0)
+#else
+#define USART_FIFO_RXTRHOLD (PLATFORM_USART_FIFO_RX_THRESHOLD)
+#endif
+#if (PLATFORM_USART_TX_BACKEND == PLATFORM_USART_BACKEND_DMA)
+#define USART_FIFO_TXTRHOLD (0)
+#else
+#define USART_FIFO_TXTRHOLD (PLATFORM_USART_FIFO_TX_THRESHOLD)
+#endif
+
+/*
+ * Characters below the RX threshold never raise RXC, so the main loop could
+ * sleep through a keystroke. Receive-start (RXS) wakes it instead; it is
+ * armed one-shot while the loop may sleep, and after it fires the tick keeps
+ * polling for an IDLE timeout's worth, by which time the character is in.
+ */
+#if (PLATFORM_USART_USE_IRQ != 0) && \
+    (PLATFORM_USART_RX_BACKEND == PLATFORM_USART_BACKEND_PIO) && \
+    (PLATFORM_USART_USE_FIFO != 0) && (USART_FIFO_RXTRHOLD > 0)
+#define USART_RXS_WAKE 1
+#else
+#define USART_RXS_WAKE 0
+#endif
+
+/*
+ * RX ring fill levels at which reception is throttled and released again
+ * (flow control only)
+ * 
+ * With the CPU draining the SERCOM, throttling can wait until the ring is
+ * completely full, as the SERCOM's own buffer then provides the margin. The
+ * DMAC is only checked whenever the ring is consumed, so it needs headroom
+ * for whatever arrives until then.
+ */
+#if (PLATFORM_USART_RX_BACKEND == PLATFORM_USART_BACKEND_DMA)
+#define USART_RX_THROTTLE_LEVEL (PLATFORM_USART_RX_RING_SIZE - PLATFORM_USART_RX_RING_SIZE / 4)
+#else
+#define USART_RX_THROTTLE_LEVEL (PLATFORM_USART_RX_RING_SIZE)
+#endif
+#define USART_RX_RELEASE_LEVEL (PLATFORM_USART_RX_RING_SIZE / 2)
+
+// FIFOSPACE fields (34.8.14)
+#define USART_FIFOSPACE_TX(x) ((x) & 0x1F)
+#define USART_FIFOSPACE_RX(x) (((x) >> 8) & 0x1F)
+
 /**
- * State variables for UART
+ * Single-producer/single-consumer character ring
+ * 
+ * The indices are free-running and only masked on access, so that
+ * (head - tail) is the fill level even when the ring is completely full.
+ * Each index is stored by exactly one side and only loaded by the other;
+ * since 16-bit loads and stores are single-copy atomic on this core, no
+ * critical section is ever needed.
+ */
+typedef struct usart_ring_type {
+    /// Index of the next free slot; stored by the producer only
+    volatile uint16_t head;
+
+    /// Index of the oldest character; stored by the consumer only
+    volatile uint16_t tail;
+} usart_ring_t;
+
+/// A fragment array waiting in (or at the front of) the TX queue
+typedef struct usart_tx_batch_type {
+    const platform_usart_tx_bufdesc_t *desc;
+    uint16_t nr_desc;
+
+    /// Sequence number handed out at submission
+    uint16_t seq;
+
+    /// Completion callback, if any
+    platform_usart_tx_cb_t cb;
+    void *arg;
+} usart_tx_batch_t;
+
+/// Register values (and derived items) for a set of line settings
+typedef struct usart_line_regs_type {
+    uint32_t ctrla;
+    uint32_t ctrlb;
+    uint16_t baud;
+
+    /// IDLE timeout, in monotonic ticks; three characters' worth
+    platform_tick_t idle_timeout;
+} usart_line_regs_t;
+
+/// A port pin, and the PORT group it belongs to
+typedef struct usart_pin_type {
+    uint8_t group;
+    uint8_t pin;
+} usart_pin_t;
+
+/**
+ * Hardware description of a USART port
+ * 
+ * NOTE: Only consulted by platform_usart_init(); whatever the driver needs
+ *       afterwards is copied into the port's context.
+ */
+typedef struct usart_hw_type {
+    /// SERCOM instance
+    sercom_registers_t *sercom;
+
+    /// GCLK peripheral channel (PCHCTRL index) of the SERCOM core clock
+    uint8_t gclk_id;
+
+    /// Bit of the SERCOM in MCLK.APBCMASK
+    uint8_t mclk_apbc_bit;
+
+    /// Pad assignment (CTRLA.TXPO, CTRLA.RXPO)
+    uint8_t txpo;
+    uint8_t rxpo;
+
+    /// PMUX function routing the pins below to the SERCOM
+    uint8_t pmux_func;
+    usart_pin_t pin_tx;
+    usart_pin_t pin_rx;
+    usart_pin_t pin_rts;
+    usart_pin_t pin_cts;
+
+    /// Whether RTS/CTS are wired up (PLATFORM_USART_FLOW_CONTROL)
+    bool flow_control;
+
+    /// DMAC channels and trigger sources (DMA backends only)
+    uint8_t dma_ch_tx;
+    uint8_t dma_ch_rx;
+    uint8_t dma_trig_tx;
+    uint8_t dma_trig_rx;
+
+    /// Line settings applied at initialization
+    platform_usart_config_t line;
+} usart_hw_t;
+
+/*
+ * TXPO for TX on PAD[0]; with flow control, RTS and CTS are then on PAD[2]
+ * and PAD[3].
+ */
+#define USART_TXPO_PAD0 (0x0)
+#define USART_TXPO_PAD0_RTS_CTS (0x2)
+
+#if (PLATFORM_USART_FLOW_CONTROL != 0) && (PLATFORM_USART_USE_LINK == 0)
+#error "PLATFORM_USART_FLOW_CONTROL only applies to the data link (PLATFORM_USART_USE_LINK)"
+#endif
+
+/*
+ * SERCOM3, via the on-board debugger
+ * 
+ * NOTE: No RTS/CTS pins between the debugger and SERCOM3 have been
+ *       confirmed against the board schematic; this port never uses flow
+ *       control.
+ */
+static const usart_hw_t usart_hw_cdc = {
+    .sercom = SERCOM3_REGS,
+    .gclk_id = 20,
+    .mclk_apbc_bit = 4,
+    .txpo = USART_TXPO_PAD0,
+    .rxpo = 0x1,
+    .pmux_func = 0x3, // D
+    .pin_tx = {1, 9},
+    .pin_rx = {1, 8},
+    .flow_control = false,
+    .dma_ch_tx = PLATFORM_DMAC_CH_USART_TX,
+    .dma_ch_rx = PLATFORM_DMAC_CH_USART_RX,
+    .dma_trig_tx = DMAC_TRIG_SERCOM3_TX,
+    .dma_trig_rx = DMAC_TRIG_SERCOM3_RX,
+    .line = PLATFORM_USART_CONFIG_DEFAULT
+};
+
+#if (PLATFORM_USART_USE_LINK != 0)
+// SERCOM0, for the data link
+static const usart_hw_t usart_hw_link = {
+    .sercom = SERCOM0_REGS,
+    .gclk_id = 17,
+    .mclk_apbc_bit = 1,
+#if (PLATFORM_USART_FLOW_CONTROL != 0)
+    .txpo = USART_TXPO_PAD0_RTS_CTS,
+#else
+    .txpo = USART_TXPO_PAD0,
+#endif
+    .rxpo = 0x1,
+    .pmux_func = 0x3, // D
+    .pin_tx = {0, 4},
+    .pin_rx = {0, 5},
+    .pin_rts = {0, 6},
+    .pin_cts = {0, 7},
+    .flow_control = (PLATFORM_USART_FLOW_CONTROL != 0),
+    .dma_ch_tx = PLATFORM_DMAC_CH_LINK_TX,
+    .dma_ch_rx = PLATFORM_DMAC_CH_LINK_RX,
+    .dma_trig_tx = DMAC_TRIG_SERCOM0_TX,
+    .dma_trig_rx = DMAC_TRIG_SERCOM0_RX,
+    .line = PLATFORM_USART_LINK_CONFIG_DEFAULT
+};
+#endif
+
+/**
+ * State variables for one USART port
+ * 
+ * Everything a port needs at runtime lives here (the register set and DMAC
+ * channels included), so each routine works off its context pointer alone.
  * 
  * NOTE: Since these are shared between application code and interrupt handlers
  *       (SysTick and SERCOM), these must be declared volatile.
  */
-typedef struct ctx_usart_type {
+typedef platform_usart_port_t ctx_usart_t;
+struct platform_usart_port_type {
     /// Pointer to the underlying register set
     sercom_usart_int_registers_t *regs;
 
     /// State variables for the transmitter
 
     struct {
-        volatile platform_usart_tx_bufdesc_t *desc;
+        /**
+         * Fragment-array queue; the application produces, the transmitter
+         * consumes. While @c active is set, the entry at the tail is the
+         * one being sent, and it is only released once it is done.
+         */
+        usart_ring_t q;
+        usart_tx_batch_t q_buf[PLATFORM_USART_TX_QUEUE_LEN];
+        volatile bool active;
+
+        /// Last sequence number handed out, and last one completed
+        uint16_t seq_next;
+        volatile uint16_t seq_done;
+
+        /// Whether anything was ever queued (TXC is meaningless before that)
+        volatile bool used;
+
+        // Remaining fragments of the array being sent
+        volatile const platform_usart_tx_bufdesc_t *desc;
         volatile uint16_t nr_desc;
 
         // Current descriptor
         volatile const char *buf;
         volatile uint16_t len;
+
+        /// Streaming ring; the application produces, the transmitter consumes
+        usart_ring_t ring;
+        uint8_t ring_buf[PLATFORM_USART_TX_RING_SIZE];
+
+#if (PLATFORM_USART_TX_BACKEND == PLATFORM_USART_BACKEND_DMA)
+        /// DMAC channel
+        uint8_t dma_ch;
+
+        /*
+         * DMAC descriptors for the second fragment onwards; the first
+         * one always lives in the DMAC base-descriptor table.
+         */
+        platform_dmac_desc_t dma_desc[NR_USART_TX_FRAG_MAX - 1];
+
+        /// Length of the ring segment the DMAC is working on, if any
+        volatile uint16_t dma_ring_len;
+
+        /// Number of characters in the fragment array being sent
+        uint16_t dma_batch_len;
+#endif
     } tx;
 
     /// State variables for the receiver
@@ -59,35 +331,247 @@ typedef struct ctx_usart_type {
         /// Receive descriptor, held by the client
         volatile platform_usart_rx_async_desc_t * volatile desc;
 
-        /// Tick since the last character was received
-        volatile platform_timespec_t ts_idle;
+        /// Tick at which the last character was received
+        volatile platform_tick_t idle_start;
 
         /// Index at which to place an incoming character
         volatile uint16_t idx;
 
+        /**
+         * Streaming ring; the receiver (RXC or the DMAC) produces, and
+         * either the tick (for descriptors) or the application consumes
+         */
+        usart_ring_t ring;
+        uint8_t ring_buf[PLATFORM_USART_RX_RING_SIZE];
+
+        /// Producer index as of the previous tick
+        uint16_t last_head;
+
+        /**
+         * Error mailbox
+         * 
+         * The receiver posts an error (type, and the producer index at
+         * which it occurred) only while the mailbox is empty, i.e., while
+         * err_post == err_ack; the tick takes it by bumping err_ack.
+         */
+        volatile uint16_t err_type;
+        volatile uint16_t err_pos;
+        volatile uint8_t err_post;
+        volatile uint8_t err_ack;
+
+#if (PLATFORM_USART_RX_BACKEND == PLATFORM_USART_BACKEND_DMA)
+        /// DMAC channel
+        uint8_t dma_ch;
+
+        /// Number of times the DMAC has wrapped around ring_buf
+        volatile uint16_t dma_laps;
+
+        /// Characters written by the DMAC as of the last update
+        uint16_t dma_written;
+#endif
+
+#if (PLATFORM_USART_FLOW_CONTROL != 0)
+        /// Whether this port has RTS/CTS at all
+        bool flow_control;
+
+        /// Whether the SERCOM is being left to fill up (and deassert RTS)
+        volatile bool throttled;
+#endif
+
+#if (USART_RXS_WAKE != 0)
+        /// Whether the RXS interrupt is armed, and when it last fired
+        volatile bool rxs_armed;
+        volatile platform_tick_t rxs_at;
+#endif
     } rx;
 
     /// Configuration items
 
     struct {
-        /// Idle timeout (reception only)
-        platform_timespec_t ts_idle_timeout;
+        /// Idle timeout (reception only), in monotonic ticks
+        platform_tick_t idle_timeout;
+
+        /// Current line settings
+        platform_usart_config_t line;
+
+        /**
+         * Auto-baud: a break was seen, and the sync field after it is yet
+         * to be picked up; the receiver was at sync_pos then.
+         */
+        volatile bool sync_pending;
+        volatile uint16_t sync_pos;
     } cfg;
 
-} ctx_usart_t;
-static ctx_usart_t ctx_uart;
+    /**
+     * Statistics
+     * 
+     * NOTE: Updated from interrupt handlers; only read with interrupts
+     *       masked.
+     */
+    platform_usart_stats_t stats;
+
+};
+platform_usart_port_t platform_usart_port_cdc;
+#if (PLATFORM_USART_USE_LINK != 0)
+platform_usart_port_t platform_usart_port_link;
+#endif
+
+#if (PLATFORM_USART_TX_BACKEND == PLATFORM_USART_BACKEND_DMA)
+static void usart_tx_dma_callback(void *arg, uint8_t flags);
+#endif
+#if (PLATFORM_USART_RX_BACKEND == PLATFORM_USART_BACKEND_DMA)
+static void usart_rx_dma_init(ctx_usart_t *ctx, uint8_t trig);
+static void usart_rx_dma_callback(void *arg, uint8_t flags);
+#endif
+
+/*
+ * Derive register values from a set of line settings
+ * 
+ * Returns false if the settings are invalid, or if the baud rate cannot be
+ * reached from USART_GCLK_HZ with the given oversampling.
+ */
+static bool usart_line_calc(const platform_usart_config_t *cfg,
+        usart_line_regs_t *r, int32_t *baud_err_ppm) {
+    uint64_t scaled, eighths, den;
+    int64_t err = INT64_MAX;
+    int64_t err_frac;
+    uint32_t nr_bits;
+
+    if (cfg->baud == 0)
+        return false;
+
+    // 34.8.1: SAMPR (arithmetic modes; fractional ones are one above)
+    switch (cfg->oversampling) {
+        case 16:
+            r->ctrla = (0x0 << 13);
+            break;
+        case 8:
+            r->ctrla = (0x2 << 13);
+            break;
+        case 3:
+            r->ctrla = (0x4 << 13);
+            break;
+        default:
+            return false;
+    }
 
-// Configure USART
+    // 34.8.2: CHSIZE; 8 bits is 0x0, while 5-7 bits encode as-is
+    if (cfg->data_bits < 5 || cfg->data_bits > 8)
+        return false;
+    r->ctrlb = (cfg->data_bits == 8) ? 0x0 : cfg->data_bits;
+
+    // FORM (CTRLA) and PMODE (CTRLB); auto-baud has its own FORMs
+    switch (cfg->parity) {
+        case PLATFORM_USART_PARITY_NONE:
+            r->ctrla |= (cfg->autobaud ? (0x4 << 24) : (0x0 << 24));
+            break;
+        case PLATFORM_USART_PARITY_EVEN:
+            r->ctrla |= (cfg->autobaud ? (0x5 << 24) : (0x1 << 24));
+            break;
+        case PLATFORM_USART_PARITY_ODD:
+            r->ctrla |= (cfg->autobaud ? (0x5 << 24) : (0x1 << 24));
+            r->ctrlb |= (1 << 13);
+            break;
+        default:
+            return false;
+    }
+
+    // The sync field is measured in 16x fractional mode only.
+    if (cfg->autobaud && cfg->oversampling != 16)
+        return false;
+
+    // SBMODE
+    if (cfg->stop_bits == 2)
+        r->ctrlb |= (1 << 6);
+    else if (cfg->stop_bits != 1)
+        return false;
 
-void platform_usart_init(void) {
     /*
-     * For ease of typing, #define a macro corresponding to the SERCOM
-     * peripheral and its internally-clocked USART view.
-     * 
-     * To avoid namespace pollution, this macro is #undef'd at the end of
-     * this function.
+     * Arithmetic mode: BAUD = 65536 * (1 - S * f_baud / f_ref), where S
+     * is the oversampling. The rounded value of 65536 * S * f_baud / f_ref
+     * must therefore lie on [1, 65535].
+     */
+    den = (uint64_t) cfg->baud * cfg->oversampling * 65536;
+    scaled = (den + USART_GCLK_HZ / 2) / USART_GCLK_HZ;
+    if (scaled > 0 && scaled <= 65535 && !cfg->autobaud) {
+        // Actual rate is f_ref * scaled / (65536 * S); compare without dividing.
+        err = ((int64_t) (USART_GCLK_HZ * scaled) - (int64_t) den) *
+                1000000 / (int64_t) den;
+        r->baud = (uint16_t) (65536 - scaled);
+    }
+
+    /*
+     * Fractional mode (16x and 8x only): f_ref / (S * f_baud) is split into
+     * an integer part BAUD[12:0] on [1, 8191] and eighths FP[15:13].
      */
-#define UART_REGS (&(SERCOM3_REGS->USART_INT))
+    if (cfg->oversampling != 3) {
+        den = (uint64_t) cfg->baud * cfg->oversampling;
+        eighths = (8 * (uint64_t) USART_GCLK_HZ + den / 2) / den;
+        if (eighths >= 8 && (eighths >> 3) <= 8191) {
+            // Actual rate is 8 * f_ref / (S * eighths)
+            err_frac = ((int64_t) (8 * (uint64_t) USART_GCLK_HZ) -
+                    (int64_t) (eighths * den)) * 1000000 /
+                    (int64_t) (eighths * den);
+            if (cfg->autobaud || (err_frac < 0 ? -err_frac : err_frac) <
+                    (err < 0 ? -err : err)) {
+                err = err_frac;
+                r->ctrla |= (0x1 << 13);
+                r->baud = (uint16_t) ((eighths >> 3) | ((eighths & 0x7) << 13));
+            }
+        }
+    }
+    if (err == INT64_MAX)
+        return false;
+    if (baud_err_ppm != NULL)
+        *baud_err_ppm = (int32_t) err;
+
+    /*
+     * IDLE timeout: three characters, each being a start bit, the data
+     * bits, the parity bit (if any) and the stop bit/s, plus one bit of
+     * margin. One baud period corresponds to one bit.
+     */
+    nr_bits = 1 + cfg->data_bits + cfg->stop_bits + 1;
+    if (cfg->parity != PLATFORM_USART_PARITY_NONE)
+        ++nr_bits;
+    r->idle_timeout = ((platform_tick_t) 3 * nr_bits * PLATFORM_TICK_HZ +
+            cfg->baud - 1) / cfg->baud;
+    return true;
+}
+
+// Apply line settings; the SERCOM must be disabled.
+
+static void usart_line_apply(ctx_usart_t *ctx,
+        const platform_usart_config_t *cfg, const usart_line_regs_t *r) {
+    ctx->regs->SERCOM_CTRLA =
+            (ctx->regs->SERCOM_CTRLA & ~USART_CTRLA_LINE_MASK) | r->ctrla;
+    ctx->regs->SERCOM_CTRLB =
+            (ctx->regs->SERCOM_CTRLB & ~USART_CTRLB_LINE_MASK) | r->ctrlb;
+    while ((ctx->regs->SERCOM_SYNCBUSY & (1 << 2)) != 0);
+    ctx->regs->SERCOM_BAUD = r->baud;
+    ctx->cfg.idle_timeout = r->idle_timeout;
+    ctx->cfg.line = *cfg;
+    ctx->cfg.sync_pending = false;
+    return;
+}
+
+// Route a pin to the SERCOM; INEN is only needed on inputs
+
+static void usart_pin_mux(const usart_pin_t *p, uint8_t func, bool input) {
+    port_group_registers_t *g = &(PORT_SEC_REGS->GROUP[p->group]);
+
+    g->PORT_PINCFG[p->pin] |= (input ? (0x3 << 0) : (0x1 << 0));
+    if ((p->pin & 1) != 0)
+        g->PORT_PMUX[p->pin >> 1] |= (func << 4);
+    else
+        g->PORT_PMUX[p->pin >> 1] |= (func << 0);
+    return;
+}
+
+// Configure one USART port
+
+static void usart_port_init(ctx_usart_t *ctx, const usart_hw_t *hw) {
+    sercom_usart_int_registers_t *regs = &(hw->sercom->USART_INT);
+    usart_line_regs_t line;
 
     /*
      * Enable the APB clock for this peripheral
@@ -98,21 +582,30 @@ void platform_usart_init(void) {
      *          only be rectified via a hardware reset/power-cycle.
      */
     //18.6
-    MCLK_REGS->MCLK_APBCMASK |= (1 << 4);
+    MCLK_REGS->MCLK_APBCMASK |= (1 << hw->mclk_apbc_bit);
 
     /*
      * Enable the GCLK generator for this peripheral
      * 
      * NOTE: GEN2 (4 MHz) is used, as GEN0 (24 MHz) is too fast for our
-     *       use case.
+     *       use case. The high-speed profile uses GEN3 (48 MHz) instead.
      */
     // 17.7.5
-    GCLK_REGS->GCLK_PCHCTRL[20] = 0x00000042;
-    while ((GCLK_REGS->GCLK_PCHCTRL[20] & 0x00000040) == 0);
+    GCLK_REGS->GCLK_PCHCTRL[hw->gclk_id] = 0x00000040 | USART_GCLK_GEN;
+    while ((GCLK_REGS->GCLK_PCHCTRL[hw->gclk_id] & 0x00000040) == 0);
 
     // Initialize the peripheral's context structure
-    memset(&ctx_uart, 0, sizeof (ctx_uart));
-    ctx_uart.regs = UART_REGS;
+    memset(ctx, 0, sizeof (*ctx));
+    ctx->regs = regs;
+#if (PLATFORM_USART_TX_BACKEND == PLATFORM_USART_BACKEND_DMA)
+    ctx->tx.dma_ch = hw->dma_ch_tx;
+#endif
+#if (PLATFORM_USART_RX_BACKEND == PLATFORM_USART_BACKEND_DMA)
+    ctx->rx.dma_ch = hw->dma_ch_rx;
+#endif
+#if (PLATFORM_USART_FLOW_CONTROL != 0)
+    ctx->rx.flow_control = hw->flow_control;
+#endif
 
     /*
      * This is the classic "SWRST" (software-triggered reset).
@@ -122,9 +615,9 @@ void platform_usart_init(void) {
      *       across all modes, so set it first after reset.
      */
     // 34.7.1: Reset
-    UART_REGS->SERCOM_CTRLA = (1 << 0);
-    while ((UART_REGS -> SERCOM_SYNCBUSY & (1 << 0)) != 0);
-    UART_REGS->SERCOM_CTRLA = (0x1 << 2); // Internally clocked
+    regs->SERCOM_CTRLA = (1 << 0);
+    while ((regs->SERCOM_SYNCBUSY & (1 << 0)) != 0);
+    regs->SERCOM_CTRLA = (0x1 << 2); // Internally clocked
     /*
      * Select further settings compatible with the 16550 UART:
      * 
@@ -142,48 +635,76 @@ void platform_usart_init(void) {
      */
     // For sake of clarity, I still added configurations where their bit position is zero.
     // 34.7.1
-    UART_REGS->SERCOM_CTRLA |= (1 << 30); // LSB First
-    UART_REGS->SERCOM_CTRLA |= (0x1 << 20); // PAD[1] Rx
-    UART_REGS->SERCOM_CTRLB |= (0 << 6); // 1 Stop Bit
-    
-    UART_REGS->SERCOM_CTRLA |= (0x1 << 24); // USART frame w/ parity
-    UART_REGS->SERCOM_CTRLB |= (0 << 13); // Even Parity
-    UART_REGS->SERCOM_CTRLA |= (0x0 << 13); // 16 bit oversampling, arithmetic
-    UART_REGS->SERCOM_CTRLA |= (0x0 << 16); // PAD[0] Tx
-    UART_REGS->SERCOM_CTRLB |= (0 << 8); // No collision detection
-    UART_REGS->SERCOM_CTRLB |= (0x0 << 0); // 8 bits
-    UART_REGS->SERCOM_CTRLC |= (0 << 27); // FIFO disabled
+    regs->SERCOM_CTRLA |= (1 << 30); // LSB First
+    regs->SERCOM_CTRLA |= ((uint32_t) hw->rxpo << 20); // RX pad
+    regs->SERCOM_CTRLA |= ((uint32_t) hw->txpo << 16); // TX (and RTS/CTS) pads
+    regs->SERCOM_CTRLB |= (0 << 8); // No collision detection
+#if (PLATFORM_USART_USE_FIFO != 0)
+    regs->SERCOM_CTRLC |= (1 << 27); // FIFO enabled
+    regs->SERCOM_CTRLC |= (USART_FIFO_RXTRHOLD << 28); // RX threshold
+    regs->SERCOM_CTRLC |= (USART_FIFO_TXTRHOLD << 24); // TX threshold
+#else
+    regs->SERCOM_CTRLC |= (0 << 27); // FIFO disabled
+#endif
+#if (USART_RXS_WAKE != 0)
+    regs->SERCOM_CTRLB |= (1 << 9); // Start-of-frame detection, for RXS
+#endif
 
 
     /*
-     * This value is determined from f_{GCLK} and f_{baud}, the latter
-     * being the actual target baudrate (here, 57600 bps).
+     * Frame format (stop bits, parity, oversampling, character size), BAUD
+     * and the IDLE timeout all follow from the line settings; see
+     * usart_line_calc() for the formulas.
      */
-    // SERCOM_BAUD = 65536 (1 - (16*57600)/4e6)
-    UART_REGS->SERCOM_BAUD = 0xC505; // 50437
-    /*
-     * Configure the IDLE timeout, which should be the length of 3
-     * USART characters.
-     * 
-     * NOTE: Each character is composed of 12 bits (must include parity
-     *       and stop bits); add one bit for margin purposes. In addition,
-     *       for UART one baud period corresponds to one bit.
-     */
-    // start bit - 1; stop bits - 1; 8 bits/char; 1 bit margin; 1 parity bit; 12 bits total
+    usart_line_calc(&hw->line, &line, NULL);
+    usart_line_apply(ctx, &hw->line, &line);
 
-    ctx_uart.cfg.ts_idle_timeout.nr_sec = 0;
-    ctx_uart.cfg.ts_idle_timeout.nr_nsec = 0xE4E1C;
-    // 12*3 = 36 / baud rate = 937500 nano seconds
     /*
      * Third-to-the-last setup:
      * 
      * - Enable receiver and transmitter
-     * - Clear the FIFOs (even though they're disabled)
+     * - Clear the FIFOs (even if they're disabled)
      */
     
-    UART_REGS->SERCOM_CTRLB |= (1 << 16) | (0x3 << 22) | (1 << 17);
+    regs->SERCOM_CTRLB |= (1 << 16) | (0x3 << 22) | (1 << 17);
+
+    while ((regs->SERCOM_SYNCBUSY & (1 << 2)) != 0);
 
-    while ((UART_REGS->SERCOM_SYNCBUSY & (1 << 2)) != 0);
+#if (PLATFORM_USART_TX_BACKEND == PLATFORM_USART_BACKEND_DMA)
+    /*
+     * Each DRE moves one beat from the fragment chain into DATA; only the
+     * last descriptor in a chain raises TCMPL.
+     */
+    platform_dmac_ch_setup(ctx->tx.dma_ch,
+            DMAC_CHCTRLB_TRIGSRC(hw->dma_trig_tx) |
+            DMAC_CHCTRLB_TRIGACT_BEAT,
+            DMAC_CHINT_TCMPL | DMAC_CHINT_TERR,
+            usart_tx_dma_callback, ctx);
+#endif
+
+#if (PLATFORM_USART_RX_BACKEND == PLATFORM_USART_BACKEND_DMA)
+    usart_rx_dma_init(ctx, hw->dma_trig_rx);
+#endif
+
+#if (PLATFORM_USART_USE_IRQ != 0)
+    /*
+     * Reception is always armed (RXC + ERROR); DRE is only enabled while
+     * there is something to send, and TXC only after the last character.
+     * 
+     * NOTE: The NVIC lines themselves are enabled in NVIC_init().
+     * 
+     * NOTE: With DMA reception, RXC belongs to the DMAC; enabling its
+     *       interrupt would have the CPU steal characters.
+     */
+    regs->SERCOM_INTENCLR = 0xBF;
+#if (PLATFORM_USART_RX_BACKEND == PLATFORM_USART_BACKEND_DMA)
+    regs->SERCOM_INTENSET = (1 << 7);
+#else
+    regs->SERCOM_INTENSET = (1 << 2) | (1 << 7);
+#endif
+    if (ctx->cfg.line.autobaud)
+        regs->SERCOM_INTENSET = (1 << 5);
+#endif
 
     /*
      * Second-to-last: Configure the physical pins.
@@ -191,209 +712,1210 @@ void platform_usart_init(void) {
      * NOTE: Consult both the chip and board datasheets to determine the
      *       correct port pins to use.
      */
-    // D Peripheral for SERCOM
-    // PB 08 rx; 
-    PORT_SEC_REGS -> GROUP[1].PORT_PINCFG[8] |= (0x3 << 0);
-    PORT_SEC_REGS -> GROUP[1].PORT_PMUX[4] |= (0x3 << 0);
-    // PB 09 tx; 
-    PORT_SEC_REGS -> GROUP[1].PORT_PINCFG[9] |= (0x3 << 0);
-    PORT_SEC_REGS -> GROUP[1].PORT_PMUX[4] |= (0x3 << 4);
+    usart_pin_mux(&hw->pin_rx, hw->pmux_func, true);
+    usart_pin_mux(&hw->pin_tx, hw->pmux_func, true);
+#if (PLATFORM_USART_FLOW_CONTROL != 0)
+    if (hw->flow_control) {
+        usart_pin_mux(&hw->pin_rts, hw->pmux_func, false);
+        usart_pin_mux(&hw->pin_cts, hw->pmux_func, true);
+    }
+#endif
 
     // Last: enable the peripheral, after resetting the state machine
-    UART_REGS->SERCOM_CTRLA |= (1 << 1);
-    while ((UART_REGS -> SERCOM_SYNCBUSY & (1 << 1)) != 0);
+    regs->SERCOM_CTRLA |= (1 << 1);
+    while ((regs->SERCOM_SYNCBUSY & (1 << 1)) != 0);
     return;
+}
 
-#undef UART_REGS
+void platform_usart_init(void) {
+    usart_port_init(&platform_usart_port_cdc, &usart_hw_cdc);
+#if (PLATFORM_USART_USE_LINK != 0)
+    usart_port_init(&platform_usart_port_link, &usart_hw_link);
+#endif
+    return;
 }
 
-// Helper abort routine for USART reception
+// Helper completion routine for USART reception
 
-static void usart_rx_abort_helper(ctx_usart_t *ctx) {
+static void usart_rx_complete(ctx_usart_t *ctx, uint16_t compl_type) {
     if (ctx->rx.desc != NULL) {
-        ctx->rx.desc->compl_type = PLATFORM_USART_RX_COMPL_DATA;
+        ctx->rx.desc->compl_type = compl_type;
         ctx->rx.desc->compl_info.data_len = ctx->rx.idx;
         ctx->rx.desc = NULL;
     }
-    ctx->rx.ts_idle.nr_sec = 0;
-    ctx->rx.ts_idle.nr_nsec = 0;
+    ctx->rx.idle_start = 0;
     ctx->rx.idx = 0;
     return;
 }
 
-// Tick handler for the USART
+// Helper abort routine for USART reception
+
+static void usart_rx_abort_helper(ctx_usart_t *ctx) {
+    usart_rx_complete(ctx, PLATFORM_USART_RX_COMPL_DATA);
+    return;
+}
+
+/*
+ * Post a reception error for the tick to pick up
+ * 
+ * NOTE: Called from the producer side of the RX ring. If an earlier error is
+ *       still pending, this one only shows up in the statistics.
+ */
+static void usart_rx_post_error(ctx_usart_t *ctx, uint16_t type, uint16_t pos) {
+    if (ctx->rx.err_post != ctx->rx.err_ack)
+        return;
+    ctx->rx.err_type = type;
+    ctx->rx.err_pos = pos;
+    __DMB();
+    ++ctx->rx.err_post;
+    return;
+}
+
+/*
+ * Retire the fragment array at the front of the TX queue
+ * 
+ * NOTE: Only to be called from the consumer side of the queue (the DRE
+ *       interrupt, the DMAC interrupt, or the polled tick).
+ */
+static void usart_tx_batch_done(ctx_usart_t *ctx) {
+    uint16_t tail = ctx->tx.q.tail;
+    const usart_tx_batch_t *b = &ctx->tx.q_buf[tail & USART_TX_QUEUE_MASK];
+    platform_usart_tx_cb_t cb = b->cb;
+    void *arg = b->arg;
+    uint16_t seq = b->seq;
+
+    ctx->tx.active = false;
+    ctx->tx.desc = NULL;
+    ctx->tx.nr_desc = 0;
+    ctx->tx.seq_done = seq;
+    __DMB();
+    ctx->tx.q.tail = tail + 1;
+
+    // The slot is free again, so the callback may submit right away.
+    if (cb != NULL)
+        cb(arg, seq);
+    platform_event_post(PLATFORM_EVENT_USART);
+    return;
+}
+
+#if (PLATFORM_USART_FLOW_CONTROL != 0)
+/*
+ * Stop taking characters from the SERCOM (or, with DMA, stop the DMAC from
+ * doing so), so that it fills up and deasserts RTS
+ * 
+ * NOTE: Called from the producer side of the RX ring.
+ */
+static void usart_rx_throttle(ctx_usart_t *ctx) {
+    ctx->rx.throttled = true;
+#if (PLATFORM_USART_RX_BACKEND == PLATFORM_USART_BACKEND_DMA)
+    platform_dmac_ch_suspend(ctx->rx.dma_ch);
+#elif (PLATFORM_USART_USE_IRQ != 0)
+    ctx->regs->SERCOM_INTENCLR = (1 << 2);
+#endif
+    return;
+}
+
+/*
+ * Resume reception once enough of the RX ring has been consumed
+ * 
+ * NOTE: Called from the consumer side of the RX ring.
+ */
+static void usart_rx_unthrottle(ctx_usart_t *ctx) {
+    if (!ctx->rx.throttled)
+        return;
+    if ((uint16_t) (ctx->rx.ring.head - ctx->rx.ring.tail) > USART_RX_RELEASE_LEVEL)
+        return;
+
+    ctx->rx.throttled = false;
+#if (PLATFORM_USART_RX_BACKEND == PLATFORM_USART_BACKEND_DMA)
+    platform_dmac_ch_resume(ctx->rx.dma_ch);
+#elif (PLATFORM_USART_USE_IRQ != 0)
+    ctx->regs->SERCOM_INTENSET = (1 << 2);
+#endif
+    return;
+}
+#endif
+
+#if (PLATFORM_USART_TX_BACKEND == PLATFORM_USART_BACKEND_PIO)
+/*
+ * Fetch the next character to transmit, if any
+ * 
+ * The current fragment goes first, then the rest of the fragment array, then
+ * the next queued array, and only then the streaming ring. Empty fragments
+ * and arrays are skipped here, so that there is no gap between queued arrays.
+ */
+static bool usart_tx_next(ctx_usart_t *ctx, uint8_t *c) {
+    const usart_tx_batch_t *b;
+    uint16_t tail;
+
+    while (ctx->tx.len == 0) {
+        if (ctx->tx.nr_desc > 0) {
+            ctx->tx.buf = ctx->tx.desc->buf;
+            ctx->tx.len = ctx->tx.desc->len;
+            if (ctx->tx.buf == NULL)
+                ctx->tx.len = 0;
+
+            ++ctx->tx.desc;
+            --ctx->tx.nr_desc;
+        } else if (ctx->tx.active) {
+            // Every fragment of this array has been written out.
+            usart_tx_batch_done(ctx);
+        } else if (ctx->tx.q.tail != ctx->tx.q.head) {
+            b = &ctx->tx.q_buf[ctx->tx.q.tail & USART_TX_QUEUE_MASK];
+            __DMB();
+            ctx->tx.desc = b->desc;
+            ctx->tx.nr_desc = b->nr_desc;
+            ctx->tx.active = true;
+        } else {
+            break;
+        }
+    }
+    if (ctx->tx.len > 0) {
+        *c = *(ctx->tx.buf++);
+        --ctx->tx.len;
+        return true;
+    }
+
+    // No fragment array is queued; feed from the streaming ring instead.
+    tail = ctx->tx.ring.tail;
+    if (tail != ctx->tx.ring.head) {
+        *c = ctx->tx.ring_buf[tail & USART_TX_RING_MASK];
+        __DMB();
+        ctx->tx.ring.tail = tail + 1;
+        return true;
+    }
+    ctx->tx.buf = NULL;
+    return false;
+}
+
+// Feed the transmitter; called on DRE (interrupt or polled)
 
-static void usart_tick_handler_common(
-        ctx_usart_t *ctx, const platform_timespec_t *tick) {
-    uint16_t status = 0x0000;
-    uint8_t data = 0x00;
-    platform_timespec_t ts_delta;
+static void usart_tx_service(ctx_usart_t *ctx) {
+    uint16_t room = 1;
+    uint8_t c;
 
-    // TX handling
-    if ((ctx->regs->SERCOM_INTFLAG & (1 << 0)) != 0) {
-        if (ctx->tx.len > 0) {
+    if ((ctx->regs->SERCOM_INTFLAG & (1 << 0)) == 0)
+        return;
+
+#if (PLATFORM_USART_USE_FIFO != 0)
+    // Top up the whole FIFO, not just one character
+    room = USART_FIFOSPACE_TX(ctx->regs->SERCOM_FIFOSPACE);
+    if (room == 0)
+        room = 1;
+#endif
+    do {
+        if (!usart_tx_next(ctx, &c)) {
             /*
-             * There is still something to transmit in the working
-             * copy of the current descriptor.
+             * Nothing left to send
+             * 
+             * With interrupts, TXC then marks the point where the
+             * last stop bit leaves.
              */
-            ctx->regs->SERCOM_DATA = *(ctx->tx.buf++);
-            --ctx->tx.len;
+#if (PLATFORM_USART_USE_IRQ != 0)
+            ctx->regs->SERCOM_INTENCLR = (1 << 0);
+            ctx->regs->SERCOM_INTENSET = (1 << 1);
+
+            // A submit() or write() may have slipped in before DRE was disabled.
+            if (ctx->tx.q.tail != ctx->tx.q.head ||
+                    ctx->tx.ring.tail != ctx->tx.ring.head)
+                ctx->regs->SERCOM_INTENSET = (1 << 0);
+#endif
+            return;
         }
-        if (ctx->tx.len == 0) {
-            // Load a new descriptor
-            ctx->tx.buf = NULL;
-            if (ctx->tx.nr_desc > 0) {
-                /*
-                 * There's at least one descriptor left to
-                 * transmit
-                 * 
-                 * If either ->buf or ->len of the candidate
-                 * descriptor refer to an empty buffer, the
-                 * next invocation of this routine will cause
-                 * the next descriptor to be evaluated.
-                 */
-                ctx->tx.buf = ctx->tx.desc->buf;
-                ctx->tx.len = ctx->tx.desc->len;
-
-                ++ctx->tx.desc;
-                --ctx->tx.nr_desc;
-
-                if (ctx->tx.buf == NULL || ctx->tx.len == 0) {
-                    ctx->tx.buf = NULL;
-                    ctx->tx.len = 0;
-                }
-            } else {
-                /*
-                 * No more descriptors available
-                 * 
-                 * Clean up the corresponding context data so
-                 * that we don't trip over them on the next
-                 * invocation.
-                 */
-                ctx->regs->SERCOM_INTENCLR = 0x01;
-                ctx->tx.desc = NULL;
-                ctx->tx.buf = NULL;
-            }
+        ctx->regs->SERCOM_DATA = c;
+        ++ctx->stats.nr_tx_chars;
+    } while (--room > 0);
+    return;
+}
+#endif
+
+#if (PLATFORM_USART_RX_BACKEND == PLATFORM_USART_BACKEND_PIO)
+// Drain the receiver into the ring; called on RXC (interrupt or polled)
+
+static void usart_rx_service(ctx_usart_t *ctx) {
+    uint16_t status;
+    uint16_t head;
+    uint16_t count;
+    uint8_t data;
+
+#if (PLATFORM_USART_FLOW_CONTROL != 0)
+    if (ctx->rx.throttled)
+        return;
+#endif
+
+#if (PLATFORM_USART_USE_FIFO != 0)
+    /*
+     * RXC only says the threshold was reached; the FIFO may hold more
+     * (or, when polled, fewer) characters than that.
+     */
+    count = USART_FIFOSPACE_RX(ctx->regs->SERCOM_FIFOSPACE);
+#else
+    count = ((ctx->regs->SERCOM_INTFLAG & (1 << 2)) != 0) ? 1 : 0;
+#endif
+    while (count-- > 0) {
+#if (PLATFORM_USART_FLOW_CONTROL != 0)
+        if (ctx->rx.flow_control &&
+                (uint16_t) (ctx->rx.ring.head - ctx->rx.ring.tail) >=
+                USART_RX_THROTTLE_LEVEL) {
+            // Leave the rest in the SERCOM, rather than dropping them.
+            usart_rx_throttle(ctx);
+            return;
         }
-    }
+#endif
 
-    // RX handling
-    if ((ctx->regs->SERCOM_INTFLAG & (1 << 2)) != 0) {
         /*
          * There are unread data
          * 
          * To enable readout of error conditions, STATUS must be read
          * before reading DATA.
-         * 
-         * NOTE: Piggyback on Bit 15, as it is undefined for this
-         *       platform.
          */
-        status = ctx->regs->SERCOM_STATUS | 0x8000;
+        status = ctx->regs->SERCOM_STATUS;
         data = (uint8_t) (ctx->regs->SERCOM_DATA);
+
+        // ISF (bit 4) is left for usart_rx_status_service().
+        if ((status & 0x00E7) != 0)
+            ctx->regs->SERCOM_STATUS = (status & 0x00E7);
+
+        head = ctx->rx.ring.head;
+        if ((status & (1 << 2)) != 0) {
+            // Characters were lost before this one
+            ++ctx->stats.nr_err_overflow;
+            usart_rx_post_error(ctx, PLATFORM_USART_RX_COMPL_ERR_OVERFLOW, head);
+        }
+        if ((status & (1 << 1)) != 0 && data == 0x00) {
+            /*
+             * A NUL whose stop bit is missing: the line was held low for
+             * a whole character or longer, i.e., a break.
+             */
+            ++ctx->stats.nr_breaks;
+            usart_rx_post_error(ctx, PLATFORM_USART_RX_COMPL_BREAK, head);
+            continue;
+        } else if ((status & (1 << 1)) != 0) {
+            ++ctx->stats.nr_err_frame;
+            usart_rx_post_error(ctx, PLATFORM_USART_RX_COMPL_ERR_FRAME, head);
+            continue;
+        } else if ((status & (1 << 0)) != 0) {
+            ++ctx->stats.nr_err_parity;
+            usart_rx_post_error(ctx, PLATFORM_USART_RX_COMPL_ERR_PARITY, head);
+            continue;
+        }
+        ++ctx->stats.nr_rx_chars;
+        if ((uint16_t) (head - ctx->rx.ring.tail) >= PLATFORM_USART_RX_RING_SIZE) {
+            // Ring full; the character is dropped.
+            ++ctx->stats.nr_rx_dropped;
+            usart_rx_post_error(ctx, PLATFORM_USART_RX_COMPL_ERR_OVERFLOW, head);
+            continue;
+        }
+        ctx->rx.ring_buf[head & USART_RX_RING_MASK] = data;
+        __DMB();
+        ctx->rx.ring.head = head + 1;
+        if ((uint16_t) (head + 1 - ctx->rx.ring.tail) > ctx->stats.hwm_rx_ring)
+            ctx->stats.hwm_rx_ring = head + 1 - ctx->rx.ring.tail;
     }
+    return;
+}
+#endif
+
+#if (PLATFORM_USART_RX_BACKEND == PLATFORM_USART_BACKEND_DMA)
+/*
+ * DMA backend for reception
+ * 
+ * A single DMAC descriptor that links back to itself turns the RX ring buffer
+ * into a true ring, with RXC as the beat trigger. The DMAC's write position is
+ * derived from the remaining beat count, and each wrap raises TCMPL, so that
+ * the consumer can tell how far the DMAC got even if it went around the ring
+ * more than once since the last look.
+ */
+static void usart_rx_dma_init(ctx_usart_t *ctx, uint8_t trig) {
+    platform_dmac_desc_t *d = platform_dmac_desc_base(ctx->rx.dma_ch);
+
+    ctx->rx.dma_laps = 0;
+    ctx->rx.dma_written = 0;
+    platform_dmac_ch_setup(ctx->rx.dma_ch,
+            DMAC_CHCTRLB_TRIGSRC(trig) |
+            DMAC_CHCTRLB_TRIGACT_BEAT,
+            DMAC_CHINT_TCMPL, usart_rx_dma_callback, ctx);
+
+    d->btctrl = DMAC_BTCTRL_VALID | DMAC_BTCTRL_BEATSIZE_BYTE |
+            DMAC_BTCTRL_DSTINC | DMAC_BTCTRL_BLOCKACT_INT;
+    d->btcnt = PLATFORM_USART_RX_RING_SIZE;
+    d->srcaddr = (uint32_t) (uintptr_t) (&ctx->regs->SERCOM_DATA);
+
+    // With DSTINC, DSTADDR must point one past the last beat.
+    d->dstaddr = (uint32_t) (uintptr_t)
+            (ctx->rx.ring_buf + PLATFORM_USART_RX_RING_SIZE);
+    d->descaddr = (uint32_t) (uintptr_t) d;
+    platform_dmac_ch_enable(ctx->rx.dma_ch);
+    return;
+}
+
+// The DMAC wrapped around the RX ring.
+
+static void usart_rx_dma_callback(void *arg, uint8_t flags) {
+    ctx_usart_t *ctx = arg;
+
+    if ((flags & DMAC_CHINT_TCMPL) != 0)
+        ++ctx->rx.dma_laps;
+    return;
+}
+
+/*
+ * Get the number of characters the DMAC has written so far (modulo 2^16)
+ * 
+ * A wrap that has yet to reach usart_rx_dma_callback() is still pending,
+ * and is counted here; the beat count is then read again, in case the wrap
+ * came after the first read. Should the callback run in the middle of all
+ * this, everything is read again.
+ * 
+ * A zero beat count is the end of a lap, which is also the start of the
+ * next one; it stands for the former until the wrap is raised.
+ */
+static uint16_t usart_rx_dma_written(ctx_usart_t *ctx) {
+    uint16_t laps;
+    uint16_t pos;
+
     do {
-        if (ctx->rx.desc == NULL) {
-            // Nowhere to store any read data
-            break;
+        laps = ctx->rx.dma_laps;
+        pos = PLATFORM_USART_RX_RING_SIZE -
+                platform_dmac_ch_btcnt(ctx->rx.dma_ch);
+        if (platform_dmac_ch_pending(ctx->rx.dma_ch)) {
+            pos = PLATFORM_USART_RX_RING_SIZE +
+                    ((PLATFORM_USART_RX_RING_SIZE -
+                    platform_dmac_ch_btcnt(ctx->rx.dma_ch)) &
+                    USART_RX_RING_MASK);
         }
+    } while (ctx->rx.dma_laps != laps);
+    return laps * PLATFORM_USART_RX_RING_SIZE + pos;
+}
+#endif
+
+/*
+ * Get the current RX producer index
+ * 
+ * With the DMA backend, the DMAC is the producer, and this is where its
+ * write position gets folded into the (free-running) head index. If the
+ * DMAC has lapped the consumer, the oldest characters are gone; the tail
+ * skips past them, and an overflow is reported there.
+ * 
+ * NOTE: Only to be called from the consumer side (i.e., never from an
+ *       interrupt handler).
+ */
+static uint16_t usart_rx_head(ctx_usart_t *ctx) {
+#if (PLATFORM_USART_RX_BACKEND == PLATFORM_USART_BACKEND_DMA)
+    uint32_t primask;
+    uint16_t written;
+    uint16_t count;
+    uint16_t head;
+
+    /*
+     * usart_rx_head_peek() works from the head and the written count as a
+     * pair; an interrupt must not see one updated without the other.
+     */
+    primask = __get_PRIMASK();
+    __disable_irq();
+    written = usart_rx_dma_written(ctx);
+    count = written - ctx->rx.dma_written;
+    head = ctx->rx.ring.head + count;
+    ctx->rx.dma_written = written;
+    ctx->rx.ring.head = head;
+    __set_PRIMASK(primask);
+    ctx->stats.nr_rx_chars += count;
+
+    if ((uint16_t) (head - ctx->rx.ring.tail) > PLATFORM_USART_RX_RING_SIZE) {
+        ctx->stats.nr_rx_dropped += (uint16_t) (head - ctx->rx.ring.tail) -
+                PLATFORM_USART_RX_RING_SIZE;
+        ctx->rx.ring.tail = head - PLATFORM_USART_RX_RING_SIZE;
+
+        /*
+         * The receiver posts errors too. One that went down with the
+         * dropped characters makes way for the overflow.
+         */
+        __disable_irq();
+        if (ctx->rx.err_post != ctx->rx.err_ack &&
+                (int16_t) (ctx->rx.err_pos - ctx->rx.ring.tail) < 0)
+            ++ctx->rx.err_ack;
+        usart_rx_post_error(ctx, PLATFORM_USART_RX_COMPL_ERR_OVERFLOW,
+                ctx->rx.ring.tail);
+        __set_PRIMASK(primask);
+    }
+    if ((uint16_t) (head - ctx->rx.ring.tail) > ctx->stats.hwm_rx_ring)
+        ctx->stats.hwm_rx_ring = head - ctx->rx.ring.tail;
+
+#if (PLATFORM_USART_FLOW_CONTROL != 0)
+    // The DMAC cannot hold back by itself; stop it before it laps the ring.
+    if (ctx->rx.flow_control && !ctx->rx.throttled &&
+            (uint16_t) (ctx->rx.ring.head - ctx->rx.ring.tail) >=
+            USART_RX_THROTTLE_LEVEL)
+        usart_rx_throttle(ctx);
+#endif
+#endif
+    return ctx->rx.ring.head;
+}
+
+#if (PLATFORM_USART_RX_BACKEND == PLATFORM_USART_BACKEND_DMA)
+/*
+ * Estimate the current RX producer index, without folding anything in
+ * 
+ * NOTE: For the interrupt side, which must not touch the ring indices;
+ *       usart_rx_head() only updates them with interrupts masked.
+ */
+static uint16_t usart_rx_head_peek(ctx_usart_t *ctx) {
+    return ctx->rx.ring.head +
+            (uint16_t) (usart_rx_dma_written(ctx) - ctx->rx.dma_written);
+}
+#endif
+
+/*
+ * Get the RX producer index, for positioning errors and breaks
+ * 
+ * NOTE: For the producer (interrupt) side.
+ */
+static uint16_t usart_rx_pos(ctx_usart_t *ctx) {
+#if (PLATFORM_USART_RX_BACKEND == PLATFORM_USART_BACKEND_DMA)
+    return usart_rx_head_peek(ctx);
+#else
+    return ctx->rx.ring.head;
+#endif
+}
+
+/*
+ * Check STATUS for errors not tied to a character the CPU reads, i.e., an
+ * overrun, or (with DMA) anything at all; called on ERROR (interrupt or
+ * polled)
+ */
+static void usart_rx_status_service(ctx_usart_t *ctx) {
+    uint16_t status = ctx->regs->SERCOM_STATUS;
+    uint16_t pos;
+
+#if (PLATFORM_USART_RX_BACKEND == PLATFORM_USART_BACKEND_DMA)
+    ctx->regs->SERCOM_STATUS = status & ((1 << 0) | (1 << 1) | (1 << 2) | (1 << 4));
+    pos = usart_rx_pos(ctx);
+    if ((status & (1 << 1)) != 0) {
+        ++ctx->stats.nr_err_frame;
+        usart_rx_post_error(ctx, PLATFORM_USART_RX_COMPL_ERR_FRAME, pos);
+    } else if ((status & (1 << 0)) != 0) {
+        ++ctx->stats.nr_err_parity;
+        usart_rx_post_error(ctx, PLATFORM_USART_RX_COMPL_ERR_PARITY, pos);
+    }
+#else
+    // PERR/FERR belong to the character the RXC handler is about to read.
+    ctx->regs->SERCOM_STATUS = status & ((1 << 2) | (1 << 4));
+    pos = usart_rx_pos(ctx);
+#endif
+    if ((status & (1 << 4)) != 0) {
+        /*
+         * ISF: the sync field after a break was unusable, and the rate
+         * stays as-is; the break itself was reported on RXBRK.
+         */
+        ctx->cfg.sync_pending = false;
+        ++ctx->stats.nr_bad_sync;
+    }
+    if ((status & (1 << 2)) != 0) {
+        ++ctx->stats.nr_err_overflow;
+        usart_rx_post_error(ctx, PLATFORM_USART_RX_COMPL_ERR_OVERFLOW, pos);
+    }
+    return;
+}
+
+// Hand newly-arrived characters over to the pending descriptor, if any
+
+static void usart_rx_deliver(ctx_usart_t *ctx, platform_tick_t now) {
+    uint16_t head = usart_rx_head(ctx);
+    uint16_t limit = head;
+    uint16_t tail;
+    bool err = false;
 
-        if ((status & 0x8003) == 0x8000) {
-            // No errors detected
-            ctx->rx.desc->buf[ctx->rx.idx++] = data;
-            ctx->rx.ts_idle = *tick;
+    if (head != ctx->rx.last_head) {
+        // Something arrived since the last tick
+        ctx->rx.last_head = head;
+        ctx->rx.idle_start = now;
+    }
+
+    tail = ctx->rx.ring.tail;
+    if (ctx->rx.err_post != ctx->rx.err_ack) {
+        __DMB();
+        if ((int16_t) (ctx->rx.err_pos - tail) < 0) {
+            // Already streamed past via read(); nobody left to tell
+            ++ctx->rx.err_ack;
+        } else {
+            // Only deliver what came before the error
+            err = true;
+            limit = ctx->rx.err_pos;
         }
-        ctx->regs->SERCOM_STATUS |= (status & 0x00F7);
+    }
 
-        // Some housekeeping
+    /*
+     * Characters stay in the ring until a descriptor is available, so
+     * nothing is lost between a completion and the next re-arm (as long
+     * as the ring does not fill up in the meantime).
+     */
+    __DMB();
+    while (ctx->rx.desc != NULL && tail != limit) {
+        ctx->rx.desc->buf[ctx->rx.idx++] =
+                ctx->rx.ring_buf[tail++ & USART_RX_RING_MASK];
         if (ctx->rx.idx >= ctx->rx.desc->max_len) {
             // Buffer completely filled
+            ++ctx->stats.nr_compl_full;
             usart_rx_abort_helper(ctx);
-            break;
-        } else if (ctx->rx.idx > 0) {
-            platform_tick_delta(&ts_delta, tick, &ctx->rx.ts_idle);
-            if (platform_timespec_compare(&ts_delta, &ctx->cfg.ts_idle_timeout) >= 0) {
-                // IDLE timeout
-                usart_rx_abort_helper(ctx);
-                break;
-            }
         }
-    } while (0);
+    }
+    __DMB();
+    ctx->rx.ring.tail = tail;
+
+    /*
+     * Everything before the error is out; report it to the pending
+     * descriptor, if any.
+     */
+    if (err && tail == limit) {
+        if (ctx->rx.desc != NULL) {
+            ++ctx->stats.nr_compl_error;
+            usart_rx_complete(ctx, ctx->rx.err_type);
+        }
+        ++ctx->rx.err_ack;
+    }
+#if (PLATFORM_USART_FLOW_CONTROL != 0)
+    usart_rx_unthrottle(ctx);
+#endif
+    return;
+}
+
+/*
+ * Note a break detected by the auto-baud logic; called on RXBRK (interrupt
+ * or polled)
+ */
+static void usart_rxbrk_service(ctx_usart_t *ctx) {
+    if ((ctx->regs->SERCOM_INTFLAG & (1 << 5)) == 0)
+        return;
+    ctx->regs->SERCOM_INTFLAG = (1 << 5);
+    if (!ctx->cfg.line.autobaud)
+        return;
+
+    // Whatever the rate turns out to be, this is a break.
+    ++ctx->stats.nr_breaks;
+    usart_rx_post_error(ctx, PLATFORM_USART_RX_COMPL_BREAK, usart_rx_pos(ctx));
+
+#if (PLATFORM_USART_USE_IRQ != 0) && \
+    (PLATFORM_USART_RX_BACKEND == PLATFORM_USART_BACKEND_PIO)
+    /*
+     * Characters from before the break may still sit below the RX
+     * threshold; take them now, so they are not mistaken for what follows
+     * the sync field.
+     */
+    usart_rx_service(ctx);
+#endif
+
+    /*
+     * RXBRK is raised at the end of the break, before the sync field is
+     * even on the line; BAUD still holds the old rate. It is rewritten
+     * once the sync field completes, which is only known from the next
+     * character arriving (with no ISF in between).
+     */
+    ctx->cfg.sync_pos = usart_rx_pos(ctx);
+    ctx->cfg.sync_pending = true;
+    return;
+}
+
+/*
+ * Pick up the rate the auto-baud logic measured, once a character has
+ * followed the sync field, and recompute the IDLE timeout for it
+ */
+static void usart_autobaud_refit(ctx_usart_t *ctx) {
+    platform_usart_config_t line = ctx->cfg.line;
+    usart_line_regs_t r;
+    uint32_t primask;
+    uint16_t baud;
+    uint32_t eighths;
+
+    if (!ctx->cfg.sync_pending)
+        return;
+    primask = __get_PRIMASK();
+    __disable_irq();
+    if (!ctx->cfg.sync_pending || usart_rx_pos(ctx) == ctx->cfg.sync_pos) {
+        __set_PRIMASK(primask);
+        return;
+    }
+    ctx->cfg.sync_pending = false;
+
+    /*
+     * BAUD has been rewritten (16x fractional) by the hardware; the rate
+     * is 8 * f_ref / (16 * eighths).
+     */
+    baud = ctx->regs->SERCOM_BAUD;
+    __set_PRIMASK(primask);
+    eighths = (uint32_t) (baud & 0x1FFF) * 8 + (baud >> 13);
+    if (eighths == 0)
+        return;
+    line.baud = (8 * USART_GCLK_HZ + 8 * eighths) / (16 * eighths);
+    if (!usart_line_calc(&line, &r, NULL))
+        return;
+    ++ctx->stats.nr_autobaud_sync;
+    ctx->cfg.line.baud = line.baud;
+    ctx->cfg.idle_timeout = r.idle_timeout;
+    return;
+}
+
+// Complete a reception whose line has gone idle
+
+static void usart_rx_idle_check(ctx_usart_t *ctx, platform_tick_t now) {
+    if (ctx->rx.desc == NULL || ctx->rx.idx == 0)
+        return;
+
+    if (now - ctx->rx.idle_start >= ctx->cfg.idle_timeout) {
+        // IDLE timeout
+        ++ctx->stats.nr_compl_idle;
+        usart_rx_abort_helper(ctx);
+    }
+    return;
+}
+
+// Tick handler for the USART
+
+static void usart_tick_handler_common(ctx_usart_t *ctx, platform_tick_t now) {
+#if (PLATFORM_USART_USE_IRQ != 0) && \
+    (PLATFORM_USART_RX_BACKEND == PLATFORM_USART_BACKEND_PIO) && \
+    (PLATFORM_USART_USE_FIFO != 0) && (USART_FIFO_RXTRHOLD > 0)
+    uint32_t primask;
+#endif
+    PROBE_BEGIN(PLATFORM_PROBE_USART_TICK);
+
+#if (PLATFORM_USART_USE_IRQ == 0)
+    /*
+     * Without interrupts, the tick is also what moves characters between
+     * the SERCOM and the rings.
+     */
+#if (PLATFORM_USART_TX_BACKEND == PLATFORM_USART_BACKEND_PIO)
+    usart_tx_service(ctx);
+#endif
+    usart_rxbrk_service(ctx);
+#if (PLATFORM_USART_RX_BACKEND == PLATFORM_USART_BACKEND_PIO)
+    usart_rx_service(ctx);
+#endif
+    usart_rx_status_service(ctx);
+#elif (PLATFORM_USART_RX_BACKEND == PLATFORM_USART_BACKEND_PIO) && \
+    (PLATFORM_USART_USE_FIFO != 0) && (USART_FIFO_RXTRHOLD > 0)
+    /*
+     * Characters below the RX threshold never raise RXC; pick them up here,
+     * with the RXC handler masked since both push into the ring.
+     */
+    primask = __get_PRIMASK();
+    __disable_irq();
+    usart_rx_service(ctx);
+    __set_PRIMASK(primask);
+#endif
+
+    /*
+     * Descriptor completion (buffer full or IDLE timeout) is always done
+     * here, on the consumer side of the RX ring, so that the descriptor is
+     * never shared with an interrupt handler.
+     */
+    usart_autobaud_refit(ctx);
+    usart_rx_deliver(ctx, now);
+    usart_rx_idle_check(ctx, now);
+
+    /*
+     * Keep the main loop awake for what no interrupt would announce: a
+     * reception waiting on its IDLE timeout, and, depending on the
+     * configuration, characters that only the tick moves or notices.
+     */
+#if (PLATFORM_USART_USE_IRQ == 0) || \
+    (PLATFORM_USART_RX_BACKEND == PLATFORM_USART_BACKEND_DMA)
+    platform_event_post(PLATFORM_EVENT_USART);
+#elif (USART_RXS_WAKE != 0)
+    if ((ctx->rx.desc != NULL && ctx->rx.idx != 0) ||
+            (!ctx->rx.rxs_armed &&
+            now - ctx->rx.rxs_at < ctx->cfg.idle_timeout)) {
+        platform_event_post(PLATFORM_EVENT_USART);
+    } else if (!ctx->rx.rxs_armed) {
+        /*
+         * RXS is left set by any start since the handler last cleared it;
+         * if so, this fires right away, for another round of polling.
+         */
+        ctx->rx.rxs_armed = true;
+        ctx->regs->SERCOM_INTENSET = (1 << 3);
+    }
+#else
+    if (ctx->rx.desc != NULL && ctx->rx.idx != 0)
+        platform_event_post(PLATFORM_EVENT_USART);
+#endif
 
     // Done
+    PROBE_END(PLATFORM_PROBE_USART_TICK);
     return;
 }
 
-void platform_usart_tick_handler(const platform_timespec_t *tick) {
-    usart_tick_handler_common(&ctx_uart, tick);
+void platform_usart_tick_handler(platform_tick_t now) {
+    usart_tick_handler_common(&platform_usart_port_cdc, now);
+#if (PLATFORM_USART_USE_LINK != 0)
+    usart_tick_handler_common(&platform_usart_port_link, now);
+#endif
 }
 
-/// Maximum number of bytes that may be sent (or received) in one transaction
-#define NR_USART_CHARS_MAX (65528)
+#if (PLATFORM_USART_USE_IRQ != 0)
+/*
+ * SERCOM interrupt handling, common to all ports
+ * 
+ * Per the datasheet, each SERCOM instance has four IRQ lines on this
+ * platform: DRE (0), TXC (1), RXC (2) and everything else (OTHER).
+ */
+static inline void usart_irq_dre(ctx_usart_t *ctx) {
+    ++ctx->stats.nr_irq_dre;
+#if (PLATFORM_USART_TX_BACKEND == PLATFORM_USART_BACKEND_PIO)
+    usart_tx_service(ctx);
+#endif
+    return;
+}
 
-/// Maximum number of fragments for USART TX
-#define NR_USART_TX_FRAG_MAX (32)
+static inline void usart_irq_txc(ctx_usart_t *ctx) {
+    ++ctx->stats.nr_irq_txc;
+
+    /*
+     * The last character has been shifted out; nothing is left to do
+     * but acknowledge.
+     * 
+     * NOTE: The flag itself is left set (the next write to DATA clears it),
+     *       as platform_usart_configure() waits on it.
+     */
+    ctx->regs->SERCOM_INTENCLR = (1 << 1);
+    platform_event_post(PLATFORM_EVENT_USART);
+    return;
+}
+
+static inline void usart_irq_rxc(ctx_usart_t *ctx) {
+    ++ctx->stats.nr_irq_rxc;
+#if (PLATFORM_USART_RX_BACKEND == PLATFORM_USART_BACKEND_PIO)
+    usart_rx_service(ctx);
+#endif
+    platform_event_post(PLATFORM_EVENT_USART);
+    return;
+}
+
+static inline void usart_irq_other(ctx_usart_t *ctx) {
+    ++ctx->stats.nr_irq_other;
+
+    usart_rxbrk_service(ctx);
+
+    /*
+     * ERROR is raised alongside RXC for parity/frame errors, which the
+     * RXC handler already consumes (except with DMA reception); what
+     * remains is a BUFOVF, which has no data attached, or an ISF.
+     */
+    usart_rx_status_service(ctx);
+    ctx->regs->SERCOM_INTFLAG = (1 << 7);
+#if (USART_RXS_WAKE != 0)
+    // A character is on its way in; disarm, and have the tick poll for it.
+    if (ctx->rx.rxs_armed && (ctx->regs->SERCOM_INTFLAG & (1 << 3)) != 0) {
+        ctx->regs->SERCOM_INTENCLR = (1 << 3);
+        ctx->regs->SERCOM_INTFLAG = (1 << 3);
+        ctx->rx.rxs_armed = false;
+        ctx->rx.rxs_at = platform_tick_now();
+    }
+#endif
+    platform_event_post(PLATFORM_EVENT_USART);
+    return;
+}
+
+// SERCOM3 interrupt handlers (on-board debugger port)
+
+void __attribute__((used, interrupt())) SERCOM3_0_Handler(void) {
+    usart_irq_dre(&platform_usart_port_cdc);
+}
+
+void __attribute__((used, interrupt())) SERCOM3_1_Handler(void) {
+    usart_irq_txc(&platform_usart_port_cdc);
+}
+
+void __attribute__((used, interrupt())) SERCOM3_2_Handler(void) {
+    usart_irq_rxc(&platform_usart_port_cdc);
+}
+
+void __attribute__((used, interrupt())) SERCOM3_OTHER_Handler(void) {
+    usart_irq_other(&platform_usart_port_cdc);
+}
+
+#if (PLATFORM_USART_USE_LINK != 0)
+// SERCOM0 interrupt handlers (data-link port)
+
+void __attribute__((used, interrupt())) SERCOM0_0_Handler(void) {
+    usart_irq_dre(&platform_usart_port_link);
+}
+
+void __attribute__((used, interrupt())) SERCOM0_1_Handler(void) {
+    usart_irq_txc(&platform_usart_port_link);
+}
+
+void __attribute__((used, interrupt())) SERCOM0_2_Handler(void) {
+    usart_irq_rxc(&platform_usart_port_link);
+}
+
+void __attribute__((used, interrupt())) SERCOM0_OTHER_Handler(void) {
+    usart_irq_other(&platform_usart_port_link);
+}
+#endif
+#endif
+
+#if (PLATFORM_USART_TX_BACKEND == PLATFORM_USART_BACKEND_DMA)
+/*
+ * DMA backend for transmission
+ * 
+ * The fragment array is turned into a chain of DMAC descriptors, each moving
+ * one fragment into DATA on DRE. The CPU is only involved again once the
+ * whole chain has been written out (TCMPL on the last descriptor).
+ * 
+ * Queued arrays are started back-to-back from the completion interrupt; the
+ * streaming ring is only fed to the DMAC once the queue has run dry.
+ */
+static bool usart_tx_dma_start(ctx_usart_t *ctx,
+        const platform_usart_tx_bufdesc_t *desc,
+        unsigned int nr_desc) {
+    platform_dmac_desc_t *d = platform_dmac_desc_base(ctx->tx.dma_ch);
+    platform_dmac_desc_t *prev = NULL;
+    unsigned int x, y;
+
+    ctx->tx.dma_batch_len = 0;
+    for (x = 0, y = 0; x < nr_desc; ++x) {
+        // The DMAC cannot do zero-length blocks; skip empty fragments.
+        if (desc[x].buf == NULL || desc[x].len == 0)
+            continue;
+
+        if (prev != NULL) {
+            d = &ctx->tx.dma_desc[y++];
+            prev->descaddr = (uint32_t) (uintptr_t) d;
+        }
+        d->btctrl = DMAC_BTCTRL_VALID | DMAC_BTCTRL_BEATSIZE_BYTE |
+                DMAC_BTCTRL_SRCINC | DMAC_BTCTRL_BLOCKACT_NOACT;
+        d->btcnt = desc[x].len;
+
+        // With SRCINC, SRCADDR must point one past the last beat.
+        d->srcaddr = (uint32_t) (uintptr_t) (desc[x].buf + desc[x].len);
+        d->dstaddr = (uint32_t) (uintptr_t) (&ctx->regs->SERCOM_DATA);
+        d->descaddr = 0;
+        ctx->tx.dma_batch_len += desc[x].len;
+        prev = d;
+    }
+    if (prev == NULL) {
+        // All fragments were empty; nothing was started.
+        return false;
+    }
+    prev->btctrl |= DMAC_BTCTRL_BLOCKACT_INT;
+
+    platform_dmac_ch_enable(ctx->tx.dma_ch);
+    return true;
+}
+
+/*
+ * Start the next queued fragment array or, failing that, the next contiguous
+ * run of the TX ring, if the channel is free
+ * 
+ * NOTE: Must be called either from the DMAC interrupt or with interrupts
+ *       masked, as both sides may want to start the channel.
+ */
+static void usart_tx_dma_kick(ctx_usart_t *ctx) {
+    platform_dmac_desc_t *d = platform_dmac_desc_base(ctx->tx.dma_ch);
+    const usart_tx_batch_t *b;
+    uint16_t tail, n, off;
+
+    if (ctx->tx.active || ctx->tx.dma_ring_len > 0)
+        return;
+
+    while (ctx->tx.q.tail != ctx->tx.q.head) {
+        b = &ctx->tx.q_buf[ctx->tx.q.tail & USART_TX_QUEUE_MASK];
+        __DMB();
+        ctx->tx.active = true;
+        if (usart_tx_dma_start(ctx, b->desc, b->nr_desc))
+            return;
+
+        // Nothing to send in this one; complete it on the spot.
+        usart_tx_batch_done(ctx);
+    }
+
+    tail = ctx->tx.ring.tail;
+    n = ctx->tx.ring.head - tail;
+    off = tail & USART_TX_RING_MASK;
+    if (n == 0)
+        return;
+
+    // The DMAC cannot wrap around; stop at the end of the buffer.
+    if (n > PLATFORM_USART_TX_RING_SIZE - off)
+        n = PLATFORM_USART_TX_RING_SIZE - off;
+
+    d->btctrl = DMAC_BTCTRL_VALID | DMAC_BTCTRL_BEATSIZE_BYTE |
+            DMAC_BTCTRL_SRCINC | DMAC_BTCTRL_BLOCKACT_INT;
+    d->btcnt = n;
+    d->srcaddr = (uint32_t) (uintptr_t) (ctx->tx.ring_buf + off + n);
+    d->dstaddr = (uint32_t) (uintptr_t) (&ctx->regs->SERCOM_DATA);
+    d->descaddr = 0;
+    ctx->tx.dma_ring_len = n;
+    platform_dmac_ch_enable(ctx->tx.dma_ch);
+    return;
+}
+
+// Called from the DMAC interrupt once the chain is done (or has failed)
+
+static void usart_tx_dma_callback(void *arg, uint8_t flags) {
+    ctx_usart_t *ctx = arg;
+
+    (void) flags;
+    if (ctx->tx.dma_ring_len > 0) {
+        // A ring segment went out; release it to the producer.
+        ctx->stats.nr_tx_chars += ctx->tx.dma_ring_len;
+        ctx->tx.ring.tail += ctx->tx.dma_ring_len;
+        ctx->tx.dma_ring_len = 0;
+        platform_event_post(PLATFORM_EVENT_USART);
+    } else if (ctx->tx.active) {
+        ctx->stats.nr_tx_chars += ctx->tx.dma_batch_len;
+        usart_tx_batch_done(ctx);
+    }
+    usart_tx_dma_kick(ctx);
+    return;
+}
+#endif
 
 // Enqueue a buffer for transmission
 
 static bool usart_tx_busy(ctx_usart_t *ctx) {
-    return (ctx->tx.len > 0) || (ctx->tx.nr_desc > 0) ||
+    return ctx->tx.active || (ctx->tx.q.tail != ctx->tx.q.head) ||
+            (ctx->tx.ring.tail != ctx->tx.ring.head) ||
             ((ctx->regs->SERCOM_INTFLAG & (1 << 0)) == 0);
 }
 
-static bool usart_tx_async(ctx_usart_t *ctx,
-        const platform_usart_tx_bufdesc_t *desc,
-        unsigned int nr_desc) {
+static uint16_t usart_tx_submit(ctx_usart_t *ctx,
+        const platform_usart_tx_bufdesc_t *desc, unsigned int nr_desc,
+        platform_usart_tx_cb_t cb, void *arg) {
     uint16_t avail = NR_USART_CHARS_MAX;
-    unsigned int x, y;
+    usart_tx_batch_t *b;
+    uint32_t primask;
+    uint16_t head, seq;
+    unsigned int x;
 
-    if (!desc || nr_desc == 0)
-        return true;
+    if (!desc && nr_desc > 0)
+        return 0;
     else if (nr_desc > NR_USART_TX_FRAG_MAX)
         // Too many descriptors
-        return false;
+        return 0;
 
-    // Don't clobber an existing buffer
-    if (usart_tx_busy(ctx))
-        return false;
-
-    for (x = 0, y = 0; x < nr_desc; ++x) {
+    for (x = 0; x < nr_desc; ++x) {
         if (desc[x].len > avail) {
             // IF the message is too long, don't enqueue.
-            return false;
+            return 0;
         }
-
         avail -= desc[x].len;
-        ++y;
     }
 
-    // The tick will trigger the transfer
-    ctx->tx.desc = desc;
-    ctx->tx.nr_desc = nr_desc;
+    /*
+     * Completion callbacks may submit too, so the producer side is not
+     * necessarily single-threaded; keep it short and masked.
+     */
+    primask = __get_PRIMASK();
+    __disable_irq();
+    head = ctx->tx.q.head;
+    if ((uint16_t) (head - ctx->tx.q.tail) >= PLATFORM_USART_TX_QUEUE_LEN) {
+        // Queue full
+        __set_PRIMASK(primask);
+        return 0;
+    }
+
+    // Zero is reserved for "not queued".
+    seq = ++ctx->tx.seq_next;
+    if (seq == 0)
+        seq = ++ctx->tx.seq_next;
+
+    ctx->tx.used = true;
+    b = &ctx->tx.q_buf[head & USART_TX_QUEUE_MASK];
+    b->desc = desc;
+    b->nr_desc = nr_desc;
+    b->seq = seq;
+    b->cb = cb;
+    b->arg = arg;
+    __DMB();
+    ctx->tx.q.head = head + 1;
+    if ((uint16_t) (head + 1 - ctx->tx.q.tail) > ctx->stats.hwm_tx_queue)
+        ctx->stats.hwm_tx_queue = head + 1 - ctx->tx.q.tail;
+
+#if (PLATFORM_USART_TX_BACKEND == PLATFORM_USART_BACKEND_DMA)
+    usart_tx_dma_kick(ctx);
+#elif (PLATFORM_USART_USE_IRQ != 0)
+    // The DRE interrupt will trigger the transfer
+    ctx->regs->SERCOM_INTENSET = (1 << 0);
+#endif
+    __set_PRIMASK(primask);
+    return seq;
+}
+
+// Change the line settings at runtime
+
+static bool usart_configure(ctx_usart_t *ctx,
+        const platform_usart_config_t *cfg, int32_t *baud_err_ppm) {
+    usart_line_regs_t line;
+    uint32_t primask;
+
+    if (!cfg || !usart_line_calc(cfg, &line, baud_err_ppm))
+        return false;
+
+    // Nothing may be queued, as it would go out at the wrong rate.
+    if (usart_tx_busy(ctx))
+        return false;
+
+    /*
+     * Let the last character (and, with the FIFO, those behind it) leave;
+     * TXC is raised once the shift register runs dry.
+     */
+    if (ctx->tx.used) {
+        while ((ctx->regs->SERCOM_INTFLAG & (1 << 1)) == 0)
+            asm("nop");
+    }
+
+    /*
+     * BAUD and the frame format are enable-protected. Interrupts stay
+     * masked throughout, so that no handler sees a half-configured SERCOM.
+     */
+    primask = __get_PRIMASK();
+    __disable_irq();
+    ctx->regs->SERCOM_CTRLA &= ~(1 << 1);
+    while ((ctx->regs->SERCOM_SYNCBUSY & (1 << 1)) != 0);
+
+    usart_line_apply(ctx, cfg, &line);
+#if (PLATFORM_USART_USE_IRQ != 0)
+    // RXBRK marks a break; the sync field after it is picked up later.
+    if (cfg->autobaud)
+        ctx->regs->SERCOM_INTENSET = (1 << 5);
+    else
+        ctx->regs->SERCOM_INTENCLR = (1 << 5);
+#endif
+
+    // Anything half-received was sampled at the old rate.
+    ctx->regs->SERCOM_CTRLB |= (0x3 << 22);
+    while ((ctx->regs->SERCOM_SYNCBUSY & (1 << 2)) != 0);
+
+    ctx->regs->SERCOM_CTRLA |= (1 << 1);
+    while ((ctx->regs->SERCOM_SYNCBUSY & (1 << 1)) != 0);
+    __set_PRIMASK(primask);
     return true;
 }
 
 static void usart_tx_abort(ctx_usart_t *ctx) {
+    uint32_t primask = __get_PRIMASK();
+
+    __disable_irq();
+#if (PLATFORM_USART_TX_BACKEND == PLATFORM_USART_BACKEND_DMA)
+    platform_dmac_ch_disable(ctx->tx.dma_ch);
+    ctx->tx.dma_ring_len = 0;
+#elif (PLATFORM_USART_USE_IRQ != 0)
+    ctx->regs->SERCOM_INTENCLR = (1 << 0);
+#endif
+    ctx->tx.active = false;
     ctx->tx.nr_desc = 0;
     ctx->tx.desc = NULL;
     ctx->tx.len = 0;
     ctx->tx.buf = NULL;
+
+    // The consumer is stopped, so the queue and ring can be emptied here.
+    ctx->tx.q.tail = ctx->tx.q.head;
+    ctx->tx.ring.tail = ctx->tx.ring.head;
+    __set_PRIMASK(primask);
     return;
 }
 
+// Stream characters into the TX ring
+
+static uint16_t usart_write(ctx_usart_t *ctx, const void *buf, uint16_t len) {
+    const uint8_t *src = buf;
+    uint16_t head = ctx->tx.ring.head;
+    uint16_t space = PLATFORM_USART_TX_RING_SIZE -
+            (uint16_t) (head - ctx->tx.ring.tail);
+    uint16_t x;
+#if (PLATFORM_USART_TX_BACKEND == PLATFORM_USART_BACKEND_DMA)
+    uint32_t primask;
+#endif
+
+    if (len > space)
+        len = space;
+    if (len > 0)
+        ctx->tx.used = true;
+    for (x = 0; x < len; ++x)
+        ctx->tx.ring_buf[(head + x) & USART_TX_RING_MASK] = src[x];
+    __DMB();
+    ctx->tx.ring.head = head + len;
+    if ((uint16_t) (head + len - ctx->tx.ring.tail) > ctx->stats.hwm_tx_ring)
+        ctx->stats.hwm_tx_ring = head + len - ctx->tx.ring.tail;
+
+    // Make sure the consumer is running
+#if (PLATFORM_USART_TX_BACKEND == PLATFORM_USART_BACKEND_DMA)
+    primask = __get_PRIMASK();
+    __disable_irq();
+    usart_tx_dma_kick(ctx);
+    __set_PRIMASK(primask);
+#elif (PLATFORM_USART_USE_IRQ != 0)
+    ctx->regs->SERCOM_INTENSET = (1 << 0);
+#endif
+    return len;
+}
+
+static uint16_t usart_tx_space(ctx_usart_t *ctx) {
+    return PLATFORM_USART_TX_RING_SIZE -
+            (uint16_t) (ctx->tx.ring.head - ctx->tx.ring.tail);
+}
+
 // API-visible items
 
-bool platform_usart_cdc_tx_async(
+uint16_t platform_usart_tx_submit(platform_usart_port_t *port,
+        const platform_usart_tx_bufdesc_t *desc, unsigned int nr_desc,
+        platform_usart_tx_cb_t cb, void *arg) {
+    return usart_tx_submit(port, desc, nr_desc, cb, arg);
+}
+
+uint16_t platform_usart_tx_seq_done(platform_usart_port_t *port) {
+    return port->tx.seq_done;
+}
+
+bool platform_usart_tx_async(platform_usart_port_t *port,
         const platform_usart_tx_bufdesc_t *desc,
         unsigned int nr_desc) {
-    return usart_tx_async(&ctx_uart, desc, nr_desc);
+    return usart_tx_submit(port, desc, nr_desc, NULL, NULL) != 0;
+}
+
+bool platform_usart_configure(platform_usart_port_t *port,
+        const platform_usart_config_t *cfg, int32_t *baud_err_ppm) {
+    return usart_configure(port, cfg, baud_err_ppm);
+}
+
+uint32_t platform_usart_get_baud(platform_usart_port_t *port) {
+    return port->cfg.line.baud;
+}
+
+bool platform_usart_tx_busy(platform_usart_port_t *port) {
+    return usart_tx_busy(port);
+}
+
+void platform_usart_tx_abort(platform_usart_port_t *port) {
+    usart_tx_abort(port);
+    return;
+}
+
+uint16_t platform_usart_write(platform_usart_port_t *port,
+        const void *buf, uint16_t len) {
+    return usart_write(port, buf, len);
+}
+
+uint16_t platform_usart_tx_space(platform_usart_port_t *port) {
+    return usart_tx_space(port);
 }
 
-bool platform_usart_cdc_tx_busy(void) {
-    return usart_tx_busy(&ctx_uart);
+void platform_usart_stats(platform_usart_port_t *port,
+        platform_usart_stats_t *stats) {
+    uint32_t primask = __get_PRIMASK();
+
+    __disable_irq();
+    *stats = port->stats;
+    __set_PRIMASK(primask);
+    return;
 }
 
-void platform_usart_cdc_tx_abort(void) {
-    usart_tx_abort(&ctx_uart);
+void platform_usart_stats_clear(platform_usart_port_t *port) {
+    uint32_t primask = __get_PRIMASK();
+
+    __disable_irq();
+    memset(&port->stats, 0, sizeof (port->stats));
+    __set_PRIMASK(primask);
     return;
 }
 
@@ -416,21 +1938,70 @@ static bool usart_rx_async(ctx_usart_t *ctx, platform_usart_rx_async_desc_t *des
     desc->compl_type = PLATFORM_USART_RX_COMPL_NONE;
     desc->compl_info.data_len = 0;
     ctx->rx.idx = 0;
-    platform_tick_hrcount(&ctx->rx.ts_idle);
+    ctx->rx.idle_start = platform_tick_now();
     ctx->rx.desc = desc;
+
+    // Anything already in the ring is delivered on the next loop.
+    platform_event_post(PLATFORM_EVENT_USART);
     return true;
 }
 
+// Stream characters out of the RX ring
+
+static uint16_t usart_rx_available(ctx_usart_t *ctx) {
+    // The head goes first, as it may move the tail.
+    uint16_t head = usart_rx_head(ctx);
+
+    return head - ctx->rx.ring.tail;
+}
+
+static uint16_t usart_read(ctx_usart_t *ctx, void *buf, uint16_t len) {
+    uint8_t *dst = buf;
+    uint16_t head;
+    uint16_t tail;
+    uint16_t avail;
+    uint16_t x;
+
+    // While a descriptor is pending, the tick is the consumer.
+    if (ctx->rx.desc != NULL)
+        return 0;
+
+    head = usart_rx_head(ctx);
+    tail = ctx->rx.ring.tail;
+    avail = head - tail;
+    if (len > avail)
+        len = avail;
+    __DMB();
+    for (x = 0; x < len; ++x)
+        dst[x] = ctx->rx.ring_buf[(tail + x) & USART_RX_RING_MASK];
+    __DMB();
+    ctx->rx.ring.tail = tail + len;
+#if (PLATFORM_USART_FLOW_CONTROL != 0)
+    usart_rx_unthrottle(ctx);
+#endif
+    return len;
+}
+
 // API-visible items
 
-bool platform_usart_cdc_rx_async(platform_usart_rx_async_desc_t *desc) {
-    return usart_rx_async(&ctx_uart, desc);
+bool platform_usart_rx_async(platform_usart_port_t *port,
+        platform_usart_rx_async_desc_t *desc) {
+    return usart_rx_async(port, desc);
 }
 
-bool platform_usart_cdc_rx_busy(void) {
-    return usart_rx_busy(&ctx_uart);
+bool platform_usart_rx_busy(platform_usart_port_t *port) {
+    return usart_rx_busy(port);
 }
 
-void platform_usart_cdc_rx_abort(void) {
-    usart_rx_abort_helper(&ctx_uart);
+void platform_usart_rx_abort(platform_usart_port_t *port) {
+    usart_rx_abort_helper(port);
 }
+
+uint16_t platform_usart_read(platform_usart_port_t *port,
+        void *buf, uint16_t len) {
+    return usart_read(port, buf, len);
+}
+
+uint16_t platform_usart_rx_available(platform_usart_port_t *port) {
+    return usart_rx_available(port);
+}
\ No newline at end of file